@@ -0,0 +1,142 @@
+// =============================
+// Raw -> mV Calibration Lookup Table
+// =============================
+
+#include <limits.h>
+#include <stdlib.h>
+#include "esp_log.h"
+#include "adc_cali_lut.h"
+
+#define TAG "ADC_CALI_LUT"
+
+#define ADC_CALI_LUT_MAX_BITWIDTH  12
+#define ADC_CALI_LUT_INVERSE_WINDOW 8     // Codes either side searched by mv_to_raw
+
+
+esp_err_t adc_cali_lut_new(uint32_t bitwidth, adc_cali_lut_convert_fn_t convert, void *ctx,
+                           adc_cali_lut_t **ret_lut)
+{
+    if (!convert || !ret_lut || bitwidth == 0 || bitwidth > ADC_CALI_LUT_MAX_BITWIDTH) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t size = 1u << bitwidth;
+    adc_cali_lut_t *lut = malloc(sizeof(adc_cali_lut_t) + size * sizeof(uint16_t));
+    if (!lut) {
+        return ESP_ERR_NO_MEM;
+    }
+    lut->mask = size - 1;
+
+    for (uint32_t raw = 0; raw < size; raw++) {
+        int mv = 0;
+        esp_err_t ret = convert(ctx, (int)raw, &mv);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Conversion of raw code %lu failed! Error code: %d", (unsigned long)raw, ret);
+            free(lut);
+            return ret;
+        }
+        // Samples leave the table as int16_t: anything outside 0 .. INT16_MAX
+        // would come out wrapped, so such a calibration is refused
+        if (mv < 0 || mv > INT16_MAX) {
+            ESP_LOGE(TAG, "Raw code %lu converts to %d mV, outside 0 .. %d", (unsigned long)raw, mv, INT16_MAX);
+            free(lut);
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        lut->mv[raw] = (uint16_t)mv;
+    }
+
+    ESP_LOGI(TAG, "Calibration table ready: %lu entries, %lu bytes",
+             (unsigned long)size, (unsigned long)(size * sizeof(uint16_t)));
+    *ret_lut = lut;
+    return ESP_OK;
+}
+
+void adc_cali_lut_del(adc_cali_lut_t *lut)
+{
+    free(lut);
+}
+
+void adc_cali_lut_raw_to_mv_block(const adc_cali_lut_t *lut, const uint16_t *raw, int16_t *mv, size_t n)
+{
+    size_t i = 0;
+
+    if (!lut) {
+        // Fallback if calibration unavailable
+        for (; i < n; i++) {
+            mv[i] = (int16_t)raw[i];
+        }
+        return;
+    }
+
+    const uint16_t *table = lut->mv;
+    const uint32_t mask = lut->mask;
+
+    // Four independent loads per iteration keep the load pipeline busy
+    for (; i + 4 <= n; i += 4) {
+        int16_t a = (int16_t)table[raw[i + 0] & mask];
+        int16_t b = (int16_t)table[raw[i + 1] & mask];
+        int16_t c = (int16_t)table[raw[i + 2] & mask];
+        int16_t d = (int16_t)table[raw[i + 3] & mask];
+        mv[i + 0] = a;
+        mv[i + 1] = b;
+        mv[i + 2] = c;
+        mv[i + 3] = d;
+    }
+    for (; i < n; i++) {
+        mv[i] = (int16_t)table[raw[i] & mask];
+    }
+}
+
+uint16_t adc_cali_lut_mv_to_raw(const adc_cali_lut_t *lut, int mv)
+{
+    if (!lut) {
+        return (uint16_t)((mv < 0) ? 0 : (mv > UINT16_MAX) ? UINT16_MAX : mv);
+    }
+
+    // Binary search for the first code at or above mv, as if the table rose
+    // strictly. Fitted curves dip by a millivolt here and there where their
+    // integer terms round differently, so the nearest entry is then picked
+    // from the codes around it.
+    uint32_t lo = 0, hi = lut->mask;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (lut->mv[mid] < mv) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    uint32_t from = (lo > ADC_CALI_LUT_INVERSE_WINDOW) ? lo - ADC_CALI_LUT_INVERSE_WINDOW : 0;
+    uint32_t to = (lut->mask - lo > ADC_CALI_LUT_INVERSE_WINDOW) ? lo + ADC_CALI_LUT_INVERSE_WINDOW : lut->mask;
+    uint32_t best = from;
+    int best_err = INT_MAX;
+    for (uint32_t raw = from; raw <= to; raw++) {
+        int err = abs(lut->mv[raw] - mv);
+        if (err < best_err) {
+            best = raw;
+            best_err = err;
+        }
+    }
+    return (uint16_t)best;
+}
+
+esp_err_t adc_cali_lut_verify(const adc_cali_lut_t *lut, adc_cali_lut_convert_fn_t convert, void *ctx,
+                              uint32_t *mismatches)
+{
+    if (!lut || !convert) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t bad = 0;
+    for (uint32_t raw = 0; raw <= lut->mask; raw++) {
+        int mv = 0;
+        if (convert(ctx, (int)raw, &mv) != ESP_OK || lut->mv[raw] != mv) {
+            bad++;
+        }
+    }
+
+    if (mismatches) {
+        *mismatches = bad;
+    }
+    return (bad == 0) ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
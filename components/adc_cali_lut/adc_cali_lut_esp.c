@@ -0,0 +1,28 @@
+// =============================
+// Calibration Table from an ESP-IDF Calibration Handle
+// =============================
+
+#include "esp_adc/adc_cali.h"
+#include "adc_cali_lut.h"
+
+
+static esp_err_t cali_handle_convert(void *ctx, int raw, int *mv)
+{
+    return adc_cali_raw_to_voltage((adc_cali_handle_t)ctx, raw, mv);
+}
+
+esp_err_t adc_cali_lut_new_from_handle(adc_cali_handle_t handle, uint32_t bitwidth, adc_cali_lut_t **ret_lut)
+{
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return adc_cali_lut_new(bitwidth, cali_handle_convert, handle, ret_lut);
+}
+
+esp_err_t adc_cali_lut_verify_handle(const adc_cali_lut_t *lut, adc_cali_handle_t handle, uint32_t *mismatches)
+{
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return adc_cali_lut_verify(lut, cali_handle_convert, handle, mismatches);
+}
@@ -0,0 +1,70 @@
+// =============================
+// Raw -> mV Calibration Lookup Table
+// =============================
+// adc_cali_raw_to_voltage() redoes the fitting math for every sample. The
+// result only depends on the raw code, so for a given unit/attenuation/
+// bitwidth we can evaluate it once for all 2^bitwidth codes and turn the
+// per-sample conversion into a single table load:
+//
+//   12-bit -> 4096 entries x 2 bytes = 8 KB per attenuation
+//
+// Build one table per attenuation actually in use (4 attenuations = 32 KB).
+// A NULL table means "no calibration": raw codes are passed through.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_adc/adc_cali.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t mask;          // size - 1, applied to every raw code
+    uint16_t mv[];          // mv[raw] = calibrated millivolts
+} adc_cali_lut_t;
+
+// Reference conversion of a single raw code, e.g. a wrapper around
+// adc_cali_raw_to_voltage(). Used to fill and to verify a table.
+typedef esp_err_t (*adc_cali_lut_convert_fn_t)(void *ctx, int raw, int *mv);
+
+// Evaluates convert() for every code 0 .. 2^bitwidth - 1. Results outside
+// 0 .. INT16_MAX mV are rejected with ESP_ERR_INVALID_RESPONSE.
+esp_err_t adc_cali_lut_new(uint32_t bitwidth, adc_cali_lut_convert_fn_t convert, void *ctx,
+                           adc_cali_lut_t **ret_lut);
+
+#if !CONFIG_IDF_TARGET_LINUX
+// Same, using an existing calibration handle from adc_cali_create_scheme_*().
+esp_err_t adc_cali_lut_new_from_handle(adc_cali_handle_t handle, uint32_t bitwidth, adc_cali_lut_t **ret_lut);
+#endif
+
+void adc_cali_lut_del(adc_cali_lut_t *lut);
+
+// Converts a whole frame. lut == NULL copies the raw codes (uncalibrated fallback).
+void adc_cali_lut_raw_to_mv_block(const adc_cali_lut_t *lut, const uint16_t *raw, int16_t *mv, size_t n);
+
+// Inverse lookup: the code whose table value is nearest to mv, the lowest
+// one where several are. Assumes the table rises with the code, up to dips
+// a few codes long. Values past either end map to the end codes.
+// lut == NULL returns mv clamped to 0 .. UINT16_MAX.
+uint16_t adc_cali_lut_mv_to_raw(const adc_cali_lut_t *lut, int mv);
+
+// Compares every table entry against convert(). Returns ESP_OK when
+// bit-exact; *mismatches (optional) receives the number of differing codes.
+esp_err_t adc_cali_lut_verify(const adc_cali_lut_t *lut, adc_cali_lut_convert_fn_t convert, void *ctx,
+                              uint32_t *mismatches);
+
+#if !CONFIG_IDF_TARGET_LINUX
+// Same, against adc_cali_raw_to_voltage() on the handle the table was built from.
+esp_err_t adc_cali_lut_verify_handle(const adc_cali_lut_t *lut, adc_cali_handle_t handle, uint32_t *mismatches);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
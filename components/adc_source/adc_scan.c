@@ -0,0 +1,130 @@
+// =============================
+// ADC Scan De-interleaver
+// =============================
+
+#include <string.h>
+#include "adc_scan.h"
+
+#define ADC_SCAN_NO_SLOT    0xFF
+
+
+esp_err_t adc_scan_init(adc_scan_t *scan, const adc_source_config_t *cfg, uint16_t *storage, size_t capacity)
+{
+    if (!scan || !cfg || !storage || capacity == 0 || cfg->sample_rate_hz == 0 ||
+        cfg->num_channels == 0 || cfg->num_channels > ADC_SOURCE_MAX_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(scan, 0, sizeof(*scan));
+    memset(scan->slot_of, ADC_SCAN_NO_SLOT, sizeof(scan->slot_of));
+    scan->num_channels = cfg->num_channels;
+    scan->sample_rate_hz = cfg->sample_rate_hz;
+    scan->capacity = capacity;
+
+    const size_t stride = ADC_SCAN_STRIDE(capacity);
+    for (uint32_t c = 0; c < cfg->num_channels; c++) {
+        int ch = cfg->channels[c].channel;
+        if (ch < 0 || ch >= ADC_SCAN_MAX_CHANNEL_ID || scan->slot_of[ch] != ADC_SCAN_NO_SLOT) {
+            return ESP_ERR_INVALID_ARG;     // Out of range or listed twice
+        }
+        scan->slot_of[ch] = (uint8_t)c;
+        scan->channel[c] = ch;
+        scan->rate_div[c] = cfg->channels[c].rate_div ? cfg->channels[c].rate_div : 1;
+        scan->run[c] = storage + c * stride;
+    }
+
+    adc_scan_reset(scan);
+    return ESP_OK;
+}
+
+void adc_scan_reset(adc_scan_t *scan)
+{
+    scan->slot = 0;
+    scan->scan = 0;
+    memset(scan->phase, 0, sizeof(scan->phase));    // Every channel keeps scan 0
+    memset(scan->hold, 0, sizeof(scan->hold));
+}
+
+void adc_scan_skip(adc_scan_t *scan, uint64_t scans)
+{
+    scan->scan += scans;
+    for (uint32_t c = 0; c < scan->num_channels; c++) {
+        uint32_t div = scan->rate_div[c];
+        scan->phase[c] = (uint32_t)((scan->phase[c] + div - scans % div) % div);
+    }
+}
+
+// Stores one result of the scan in progress
+static inline void scan_put(adc_scan_t *scan, uint32_t slot, uint16_t code, size_t *len, uint64_t *first)
+{
+    if (scan->phase[slot] == 0 && len[slot] < scan->capacity) {
+        if (len[slot] == 0) {
+            first[slot] = scan->scan;
+        }
+        scan->run[slot][len[slot]++] = code;
+    }
+    scan->hold[slot] = code;
+}
+
+// Moves to the next slot; after the last one, to the next scan
+static inline void scan_advance(adc_scan_t *scan)
+{
+    if (++scan->slot < scan->num_channels) {
+        return;
+    }
+    scan->slot = 0;
+    scan->scan++;
+    for (uint32_t c = 0; c < scan->num_channels; c++) {
+        scan->phase[c] = (scan->phase[c] == 0) ? scan->rate_div[c] - 1 : scan->phase[c] - 1;
+    }
+}
+
+void adc_scan_deinterleave(adc_scan_t *scan, const uint16_t *words, size_t n, int64_t t_scan_us, adc_frame_t *frame)
+{
+    size_t len[ADC_SOURCE_MAX_CHANNELS] = {0};
+    uint64_t first[ADC_SOURCE_MAX_CHANNELS] = {0};
+    const uint64_t entry_scan = scan->scan;
+
+    for (size_t i = 0; i < n; i++) {
+        const uint16_t w = words[i];
+        const uint32_t slot = scan->slot_of[ADC_SCAN_WORD_CHANNEL(w)];
+
+        // --- Fast path: the result the pattern expects ---
+        if (slot == scan->slot) {
+            scan_put(scan, slot, ADC_SCAN_WORD_CODE(w), len, first);
+            scan_advance(scan);
+            continue;
+        }
+
+        if (slot == ADC_SCAN_NO_SLOT) {
+            scan->foreign++;
+            continue;
+        }
+
+        // --- Out of order: fill the skipped slots (finishing the scan if needed) ---
+        scan->resyncs++;
+        while (scan->slot != slot) {
+            scan_put(scan, scan->slot, scan->hold[scan->slot], len, first);
+            scan->filled++;
+            scan_advance(scan);
+        }
+        scan_put(scan, slot, ADC_SCAN_WORD_CODE(w), len, first);
+        scan_advance(scan);
+    }
+
+    // --- Per-channel runs and their timestamps ---
+    frame->timestamp_us = t_scan_us;
+    frame->num_channels = scan->num_channels;
+    for (uint32_t c = 0; c < scan->num_channels; c++) {
+        adc_frame_chan_t *ch = &frame->chan[c];
+        ch->channel = scan->channel[c];
+        ch->data = scan->run[c];
+        ch->len = len[c];
+        ch->timestamp_us = t_scan_us + adc_scan_slot_offset_us(scan, c);
+        if (len[c] > 0) {
+            ch->timestamp_us += (int64_t)((first[c] - entry_scan) * 1000000 / scan->sample_rate_hz);
+        }
+    }
+    frame->data = frame->chan[0].data;
+    frame->len = frame->chan[0].len;
+}
@@ -0,0 +1,150 @@
+// =============================
+// ADC Source - Generic Front-End
+// =============================
+
+#include <stdlib.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "adc_source_priv.h"
+#include "adc_scan.h"
+
+#define TAG "ADC_SOURCE"
+
+
+esp_err_t adc_source_check_config(const adc_source_config_t *cfg, adc_source_config_t *norm)
+{
+    if (!cfg || cfg->sample_rate_hz == 0 || cfg->frame_samples == 0 ||
+        cfg->num_channels > ADC_SOURCE_MAX_CHANNELS) {
+        ESP_LOGE(TAG, "Invalid source configuration");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *norm = *cfg;
+    if (cfg->num_channels == 0) {
+        // Single channel given the old way
+        norm->num_channels = 1;
+        norm->channels[0] = (adc_source_channel_cfg_t) {
+            .channel = cfg->channel,
+            .atten = cfg->atten,
+            .rate_div = 1,
+        };
+    }
+
+    for (uint32_t c = 0; c < norm->num_channels; c++) {
+        adc_source_channel_cfg_t *ch = &norm->channels[c];
+        if (ch->channel < 0 || ch->channel >= ADC_SCAN_MAX_CHANNEL_ID) {
+            ESP_LOGE(TAG, "Invalid channel %d", ch->channel);
+            return ESP_ERR_INVALID_ARG;
+        }
+        for (uint32_t k = 0; k < c; k++) {
+            if (norm->channels[k].channel == ch->channel) {
+                ESP_LOGE(TAG, "Channel %d listed twice", ch->channel);
+                return ESP_ERR_INVALID_ARG;
+            }
+        }
+        if (ch->rate_div == 0) {
+            ch->rate_div = 1;
+        }
+    }
+
+    // channel/atten mirror the first entry, for code that only looks at those
+    norm->channel = norm->channels[0].channel;
+    norm->atten = norm->channels[0].atten;
+    return ESP_OK;
+}
+
+esp_err_t adc_source_start(adc_source_t *src)
+{
+    if (!src) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    src->frames = 0;
+    src->samples = 0;
+    src->dropped_frames = 0;
+    src->missed_scans = 0;
+    src->start_us = src->now_us();
+
+    esp_err_t ret = src->start(src);
+    src->running = (ret == ESP_OK);
+    return ret;
+}
+
+esp_err_t adc_source_read(adc_source_t *src, adc_frame_t *frame, uint32_t timeout_ms)
+{
+    if (!src || !frame) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!src->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = src->read(src, frame, timeout_ms);
+    if (ret == ESP_OK) {
+        src->frames++;
+        for (uint32_t c = 0; c < frame->num_channels; c++) {
+            src->samples += frame->chan[c].len;
+        }
+    }
+    return ret;
+}
+
+esp_err_t adc_source_stop(adc_source_t *src)
+{
+    if (!src) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!src->running) {
+        return ESP_OK;
+    }
+    src->running = false;
+    return src->stop(src);
+}
+
+void adc_source_get_stats(adc_source_t *src, adc_source_stats_t *stats)
+{
+    stats->frames = src->frames;
+    stats->samples = src->samples;
+    stats->dropped_frames = src->dropped_frames;
+    stats->missed_scans = src->missed_scans;
+    stats->elapsed_us = src->now_us() - src->start_us;
+    stats->samples_per_sec = (stats->elapsed_us > 0)
+                             ? (uint32_t)(src->samples * 1000000ULL / (uint64_t)stats->elapsed_us)
+                             : 0;
+}
+
+const adc_source_config_t *adc_source_get_config(const adc_source_t *src)
+{
+    return &src->cfg;
+}
+
+void adc_source_del(adc_source_t *src)
+{
+    if (!src) {
+        return;
+    }
+    adc_source_stop(src);
+    src->del(src);
+}
+
+
+// =============================
+// Backends not built for this target
+// =============================
+#if CONFIG_IDF_TARGET_LINUX
+esp_err_t adc_source_new_oneshot(const adc_source_config_t *cfg, adc_source_t **ret_src)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t adc_source_new_continuous(const adc_source_config_t *cfg, adc_source_t **ret_src)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+#else
+esp_err_t adc_source_new_host(const adc_source_config_t *cfg, const adc_host_source_config_t *host_cfg,
+                              adc_source_t **ret_src)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+#endif
@@ -0,0 +1,297 @@
+// =============================
+// ADC Source - Continuous (DMA) Backend
+// =============================
+// The adc_continuous driver lets the ADC digital controller convert on its
+// own and move results into memory by DMA. The CPU only wakes up once per
+// conversion frame (frame_samples results), so rates from a few kHz up to the
+// hardware maximum are possible.
+//
+// Data path:
+//
+//   ADC -> DMA -> driver pool (max_store_buf_size) -> adc_continuous_read()
+//       -> adc_scan (de-interleave) -> per-channel runs in the frame
+//
+// With several channels the pattern table holds one entry per channel, so the
+// controller scans them in table order; a conversion frame is frame_samples
+// whole scans.
+//
+// When the reader falls behind, the driver pool fills up and the driver
+// throws away a conversion frame; on_pool_ovf counts those as dropped frames.
+//
+// adc_continuous_read() sleeps until the DMA interrupt hands over a frame, so
+// the reading task is woken by the hardware, not by a tick. on_conv_done
+// records when each frame completed; frame timestamps come from that clock
+// instead of from whenever the reader got around to it.
+
+#include <stdlib.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_adc/adc_continuous.h"
+#include "soc/soc_caps.h"
+#include "adc_source_priv.h"
+#include "adc_scan.h"
+
+#define TAG "ADC_CONTINUOUS"
+
+// Number of conversion frames the driver may buffer before it overflows
+#define ADC_CONT_POOL_FRAMES   4
+
+// The DMA result layout differs between chips. adc_scan reads TYPE1 words
+// (ESP32, ESP32-S2); TYPE2 results are repacked into that layout first.
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define ADC_CONT_OUTPUT_TYPE        ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define ADC_CONT_TYPE1              1
+#else
+#define ADC_CONT_OUTPUT_TYPE        ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define ADC_CONT_TYPE1              0
+#endif
+
+
+typedef struct {
+    adc_source_t base;                 // Must stay first
+    adc_continuous_handle_t handle;    // Continuous driver handle
+    uint8_t  *dma_buf;                 // One conversion frame as delivered by the driver
+    uint32_t  frame_bytes;             // scans * channels * SOC_ADC_DIGI_RESULT_BYTES
+    uint16_t *runs;                    // Per-channel runs handed to the caller (adc_scan storage)
+    adc_scan_t scan;
+    uint32_t  seq;
+    volatile uint32_t pool_ovf;        // Incremented from ISR context
+    uint32_t  pool_ovf_seen;           // pool_ovf value already added to dropped_frames
+    uint32_t  frame_us;                // Duration of one conversion frame
+    portMUX_TYPE done_lock;            // Guards the two fields below (written by the ISR)
+    uint32_t  done_count;              // Conversion frames completed, including dropped ones
+    int64_t   done_us;                 // Completion time of the latest one
+} adc_source_cont_t;
+
+
+// Runs in ISR context: keep it short
+static bool IRAM_ATTR cont_on_conv_done(adc_continuous_handle_t handle,
+                                        const adc_continuous_evt_data_t *edata, void *user_data)
+{
+    adc_source_cont_t *cs = (adc_source_cont_t *)user_data;
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&cs->done_lock);
+    cs->done_count++;
+    cs->done_us = now;
+    portEXIT_CRITICAL_ISR(&cs->done_lock);
+    return false;   // No task woken (the driver wakes the reader itself)
+}
+
+// Runs in ISR context: keep it short
+static bool IRAM_ATTR cont_on_pool_ovf(adc_continuous_handle_t handle,
+                                       const adc_continuous_evt_data_t *edata, void *user_data)
+{
+    adc_source_cont_t *cs = (adc_source_cont_t *)user_data;
+    cs->pool_ovf++;
+    return false;   // No task woken
+}
+
+static esp_err_t cont_start(adc_source_t *src)
+{
+    adc_source_cont_t *cs = (adc_source_cont_t *)src;
+    cs->seq = 0;
+    cs->pool_ovf = 0;
+    cs->pool_ovf_seen = 0;
+    portENTER_CRITICAL(&cs->done_lock);
+    cs->done_count = 0;
+    cs->done_us = 0;
+    portEXIT_CRITICAL(&cs->done_lock);
+    adc_scan_reset(&cs->scan);
+    return adc_continuous_start(cs->handle);
+}
+
+static esp_err_t cont_read(adc_source_t *src, adc_frame_t *frame, uint32_t timeout_ms)
+{
+    adc_source_cont_t *cs = (adc_source_cont_t *)src;
+    uint32_t ret_num = 0;
+
+    esp_err_t ret = adc_continuous_read(cs->handle, cs->dma_buf, cs->frame_bytes, &ret_num, timeout_ms);
+    if (ret != ESP_OK) {
+        return ret;   // ESP_ERR_TIMEOUT when no frame is ready yet
+    }
+    int64_t now = esp_timer_get_time();
+
+    // Every overflow since the last read cost us one conversion frame
+    uint32_t ovf = cs->pool_ovf;
+    uint32_t lost = ovf - cs->pool_ovf_seen;
+    cs->pool_ovf_seen = ovf;
+    src->dropped_frames += lost;
+    cs->seq += lost;
+    adc_scan_skip(&cs->scan, (uint64_t)lost * src->cfg.frame_samples);
+
+    // Results as 16-bit TYPE1 words (channel in the top 4 bits)
+    uint16_t *words = (uint16_t *)cs->dma_buf;
+    size_t n = ret_num / SOC_ADC_DIGI_RESULT_BYTES;
+#if !ADC_CONT_TYPE1
+    // In place: word i is written at byte 2*i, behind the 4*i being read
+    for (size_t i = 0; i < n; i++) {
+        const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&cs->dma_buf[i * SOC_ADC_DIGI_RESULT_BYTES];
+        words[i] = ADC_SCAN_WORD(p->type2.channel, p->type2.data);
+    }
+#endif
+
+    // This is conversion frame number seq (counting lost ones). The ISR saw
+    // done_count frames complete, the latest at done_us: step back by the
+    // frames still queued behind this one. Without ISR data, assume it just completed.
+    portENTER_CRITICAL(&cs->done_lock);
+    uint32_t done = cs->done_count;
+    int64_t done_us = cs->done_us;
+    portEXIT_CRITICAL(&cs->done_lock);
+    int32_t behind = (int32_t)(done - (cs->seq + 1));
+    int64_t t_end = (done > 0 && behind >= 0) ? done_us - (int64_t)behind * cs->frame_us : now;
+
+    // The first scan started one frame-time before the end
+    const uint32_t nch = src->cfg.num_channels;
+    int64_t t_scan = t_end - (int64_t)((n + nch - 1) / nch) * 1000000 / src->cfg.sample_rate_hz;
+    adc_scan_deinterleave(&cs->scan, words, n, t_scan, frame);
+    frame->seq = cs->seq++;
+    return ESP_OK;
+}
+
+static esp_err_t cont_stop(adc_source_t *src)
+{
+    adc_source_cont_t *cs = (adc_source_cont_t *)src;
+    return adc_continuous_stop(cs->handle);
+}
+
+static void cont_del(adc_source_t *src)
+{
+    adc_source_cont_t *cs = (adc_source_cont_t *)src;
+    if (cs->handle) {
+        adc_continuous_deinit(cs->handle);
+    }
+    free(cs->dma_buf);
+    heap_caps_free(cs->runs);
+    free(cs);
+}
+
+
+esp_err_t adc_source_new_continuous(const adc_source_config_t *cfg, adc_source_t **ret_src)
+{
+    adc_source_config_t norm;
+    esp_err_t ret = adc_source_check_config(cfg, &norm);
+    if (ret != ESP_OK || !ret_src) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint32_t nch = norm.num_channels;
+
+    // The digital controller only runs between these two limits (all channels together)
+    uint32_t conv_rate = norm.sample_rate_hz * nch;
+    if (conv_rate < SOC_ADC_SAMPLE_FREQ_THRES_LOW || conv_rate > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) {
+        ESP_LOGE(TAG, "Conversion rate %lu Hz (%lu Hz x %lu channels) out of range [%d, %d]",
+                 (unsigned long)conv_rate, (unsigned long)norm.sample_rate_hz, (unsigned long)nch,
+                 SOC_ADC_SAMPLE_FREQ_THRES_LOW, SOC_ADC_SAMPLE_FREQ_THRES_HIGH);
+        return ESP_ERR_INVALID_ARG;
+    }
+    // The DMA controller drives ADC1 only on ESP32; other chips also take ADC2
+    if ((norm.unit != ADC_UNIT_1 && norm.unit != ADC_UNIT_2) || !SOC_ADC_DIG_SUPPORTED_UNIT(norm.unit)) {
+        ESP_LOGE(TAG, "ADC unit %d has no continuous mode on this chip", norm.unit + 1);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (nch > SOC_ADC_PATT_LEN_MAX) {
+        ESP_LOGE(TAG, "At most %d channels per scan", SOC_ADC_PATT_LEN_MAX);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The conversion frame must be a whole number of DMA conversions
+    uint32_t frame_bytes = norm.frame_samples * nch * SOC_ADC_DIGI_RESULT_BYTES;
+    if (frame_bytes % SOC_ADC_DIGI_DATA_BYTES_PER_CONV != 0) {
+        ESP_LOGE(TAG, "frame_samples x channels must be a multiple of %d",
+                 SOC_ADC_DIGI_DATA_BYTES_PER_CONV / SOC_ADC_DIGI_RESULT_BYTES);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    adc_source_cont_t *cs = calloc(1, sizeof(*cs));
+    if (!cs) {
+        return ESP_ERR_NO_MEM;
+    }
+    cs->frame_bytes = frame_bytes;
+    cs->frame_us = (uint32_t)((uint64_t)norm.frame_samples * 1000000 / norm.sample_rate_hz);
+    portMUX_INITIALIZE(&cs->done_lock);
+    cs->dma_buf = calloc(1, frame_bytes);
+    // One extra slot per run: a resynchronised frame can touch one more scan
+    cs->runs = heap_caps_aligned_calloc(16, adc_scan_storage_len(nch, norm.frame_samples + 1),
+                                        sizeof(uint16_t), MALLOC_CAP_DEFAULT);
+    if (!cs->dma_buf || !cs->runs) {
+        cont_del(&cs->base);
+        return ESP_ERR_NO_MEM;
+    }
+    ret = adc_scan_init(&cs->scan, &norm, cs->runs, norm.frame_samples + 1);
+    if (ret != ESP_OK) {
+        cont_del(&cs->base);
+        return ret;
+    }
+
+    // ==============================
+    // 1️⃣ Driver Handle
+    // ==============================
+    // - max_store_buf_size: driver pool, in bytes, between DMA and adc_continuous_read()
+    // - conv_frame_size: bytes per conversion frame (one adc_continuous_read() worth)
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = frame_bytes * ADC_CONT_POOL_FRAMES,
+        .conv_frame_size = frame_bytes,
+    };
+    ret = adc_continuous_new_handle(&handle_cfg, &cs->handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create continuous ADC handle! Error code: %d", ret);
+        cont_del(&cs->base);
+        return ret;
+    }
+
+    // ==============================
+    // 2️⃣ Conversion Pattern
+    // ==============================
+    // One entry per channel: the controller converts them in this order, then
+    // starts over. sample_freq_hz counts conversions, so it is the scan rate
+    // times the number of channels. (rate_div is applied by adc_scan.)
+    adc_digi_pattern_config_t pattern[ADC_SOURCE_MAX_CHANNELS] = {0};
+    for (uint32_t c = 0; c < nch; c++) {
+        pattern[c].atten = norm.channels[c].atten;
+        pattern[c].channel = norm.channels[c].channel & 0x7;
+        pattern[c].unit = norm.unit;
+        pattern[c].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    }
+    adc_continuous_config_t dig_cfg = {
+        .sample_freq_hz = conv_rate,
+        .conv_mode = (norm.unit == ADC_UNIT_2) ? ADC_CONV_SINGLE_UNIT_2 : ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_CONT_OUTPUT_TYPE,
+        .pattern_num = nch,
+        .adc_pattern = pattern,
+    };
+    ret = adc_continuous_config(cs->handle, &dig_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to configure continuous ADC! Error code: %d", ret);
+        cont_del(&cs->base);
+        return ret;
+    }
+
+    // ==============================
+    // 3️⃣ Frame Timing + Overflow Accounting
+    // ==============================
+    adc_continuous_evt_cbs_t cbs = {
+        .on_conv_done = cont_on_conv_done,
+        .on_pool_ovf = cont_on_pool_ovf,
+    };
+    ret = adc_continuous_register_event_callbacks(cs->handle, &cbs, cs);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register ADC callbacks! Error code: %d", ret);
+        cont_del(&cs->base);
+        return ret;
+    }
+
+    cs->base.cfg = norm;
+    cs->base.start = cont_start;
+    cs->base.read = cont_read;
+    cs->base.stop = cont_stop;
+    cs->base.del = cont_del;
+    cs->base.now_us = esp_timer_get_time;
+
+    ESP_LOGI(TAG, "Continuous source ready: %lu channel(s), %lu Hz, %lu scans/frame",
+             (unsigned long)nch, (unsigned long)cfg->sample_rate_hz, (unsigned long)cfg->frame_samples);
+    *ret_src = &cs->base;
+    return ESP_OK;
+}
@@ -0,0 +1,210 @@
+// =============================
+// ADC Source - Host Stand-In (linux target)
+// =============================
+// Generates frames from a signal callback so the frame-handling path can run
+// on the ESP-IDF `linux` target, in QEMU-less CI or in unit tests.
+//
+// - realtime = false : frames are produced as fast as the reader asks for them
+// - realtime = true  : frames become available at sample_rate_hz; if the reader
+//                      lags more than max_queued_frames behind, the excess is
+//                      dropped, just like the DMA driver pool overflowing.
+//                      speed = N runs that clock N times faster (accelerated
+//                      replay); timestamps follow the accelerated clock.
+//
+// Scans are produced the way the DMA controller writes them (interleaved
+// TYPE1 words) and split with adc_scan, so the host exercises the same
+// de-interleave path as the continuous backend.
+
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+#include "esp_log.h"
+#include "adc_source_priv.h"
+#include "adc_scan.h"
+
+#define TAG "ADC_HOST"
+
+#define ADC_HOST_DEFAULT_QUEUED_FRAMES  4
+
+
+typedef struct {
+    adc_source_t base;                 // Must stay first
+    adc_host_source_config_t host;
+    uint64_t  next_sample;             // Absolute index of the next scan to generate
+    uint32_t  seq;
+    int64_t   t0_us;                   // Time of scan 0
+    uint16_t *words;                   // One frame of interleaved results ("DMA buffer")
+    uint16_t *runs;                    // Per-channel runs (adc_scan storage)
+    adc_scan_t scan;
+} adc_source_host_t;
+
+
+static int64_t host_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void host_sleep_us(int64_t us)
+{
+    struct timespec ts = {
+        .tv_sec = us / 1000000,
+        .tv_nsec = (us % 1000000) * 1000,
+    };
+    nanosleep(&ts, NULL);
+}
+
+// Default signal: 10 Hz sine, 1 V amplitude around mid-scale
+static uint16_t host_default_signal(uint64_t n, void *ctx)
+{
+    const adc_source_config_t *cfg = (const adc_source_config_t *)ctx;
+    double t = (double)n / cfg->sample_rate_hz;
+    return (uint16_t)(2048 + 1240 * sin(2 * M_PI * 10.0 * t));
+}
+
+// Scans per second on the (possibly accelerated) clock
+static uint64_t host_rate(const adc_source_host_t *hs)
+{
+    return (uint64_t)hs->base.cfg.sample_rate_hz * hs->host.speed;
+}
+
+// Time at which sample n has been "converted"
+static int64_t host_sample_time_us(const adc_source_host_t *hs, uint64_t n)
+{
+    return hs->t0_us + (int64_t)(n * 1000000 / host_rate(hs));
+}
+
+static esp_err_t host_start(adc_source_t *src)
+{
+    adc_source_host_t *hs = (adc_source_host_t *)src;
+    hs->next_sample = 0;
+    hs->seq = 0;
+    adc_scan_reset(&hs->scan);
+    hs->t0_us = host_now_us();
+    return ESP_OK;
+}
+
+static esp_err_t host_read(adc_source_t *src, adc_frame_t *frame, uint32_t timeout_ms)
+{
+    adc_source_host_t *hs = (adc_source_host_t *)src;
+    const uint32_t n = src->cfg.frame_samples;
+
+    if (hs->host.realtime) {
+        int64_t now = host_now_us();
+
+        // Frames that the "hardware" finished but nobody has read yet
+        uint64_t converted = (uint64_t)(now - hs->t0_us) * host_rate(hs) / 1000000;
+        uint64_t backlog = (converted > hs->next_sample) ? (converted - hs->next_sample) / n : 0;
+        if (backlog > hs->host.max_queued_frames) {
+            uint64_t lost = backlog - hs->host.max_queued_frames;
+            hs->next_sample += lost * n;
+            hs->seq += (uint32_t)lost;
+            src->dropped_frames += (uint32_t)lost;
+            adc_scan_skip(&hs->scan, lost * n);
+        }
+
+        // Wait for the frame to complete, bounded by timeout_ms
+        int64_t ready = host_sample_time_us(hs, hs->next_sample + n);
+        if (ready > now) {
+            int64_t wait = ready - now;
+            if (wait > (int64_t)timeout_ms * 1000) {
+                hs->host.wait_us((int64_t)timeout_ms * 1000);
+                return ESP_ERR_TIMEOUT;
+            }
+            hs->host.wait_us(wait);
+        }
+    }
+
+    // --- "Convert" n scans, interleaved like the DMA output ---
+    const uint32_t nch = src->cfg.num_channels;
+    uint16_t *w = hs->words;
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t k = hs->next_sample + i;
+        for (uint32_t c = 0; c < nch; c++) {
+            int ch = src->cfg.channels[c].channel;
+            uint16_t code = hs->host.scan_signal
+                            ? hs->host.scan_signal(ch, k, hs->host.signal_ctx)
+                            : hs->host.signal(k, hs->host.signal_ctx);
+            *w++ = ADC_SCAN_WORD(ch, code);
+        }
+    }
+
+    // --- Split into per-channel runs ---
+    adc_scan_deinterleave(&hs->scan, hs->words, (size_t)n * nch,
+                          host_sample_time_us(hs, hs->next_sample), frame);
+    frame->seq = hs->seq++;
+    hs->next_sample += n;
+    return ESP_OK;
+}
+
+static esp_err_t host_stop(adc_source_t *src)
+{
+    return ESP_OK;
+}
+
+static void host_del(adc_source_t *src)
+{
+    adc_source_host_t *hs = (adc_source_host_t *)src;
+    free(hs->words);
+    free(hs->runs);
+    free(hs);
+}
+
+
+esp_err_t adc_source_new_host(const adc_source_config_t *cfg, const adc_host_source_config_t *host_cfg,
+                              adc_source_t **ret_src)
+{
+    adc_source_config_t norm;
+    esp_err_t ret = adc_source_check_config(cfg, &norm);
+    if (ret != ESP_OK || !ret_src) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    adc_source_host_t *hs = calloc(1, sizeof(*hs));
+    if (!hs) {
+        return ESP_ERR_NO_MEM;
+    }
+    hs->base.cfg = norm;
+    hs->words = calloc((size_t)norm.frame_samples * norm.num_channels, sizeof(uint16_t));
+    hs->runs = calloc(adc_scan_storage_len(norm.num_channels, norm.frame_samples), sizeof(uint16_t));
+    if (!hs->words || !hs->runs) {
+        host_del(&hs->base);
+        return ESP_ERR_NO_MEM;
+    }
+    ret = adc_scan_init(&hs->scan, &norm, hs->runs, norm.frame_samples);
+    if (ret != ESP_OK) {
+        host_del(&hs->base);
+        return ret;
+    }
+
+    if (host_cfg) {
+        hs->host = *host_cfg;
+    }
+    if (!hs->host.signal && !hs->host.scan_signal) {
+        hs->host.signal = host_default_signal;
+        hs->host.signal_ctx = &hs->base.cfg;
+    }
+    if (hs->host.max_queued_frames == 0) {
+        hs->host.max_queued_frames = ADC_HOST_DEFAULT_QUEUED_FRAMES;
+    }
+    if (hs->host.speed == 0) {
+        hs->host.speed = 1;
+    }
+    if (!hs->host.wait_us) {
+        hs->host.wait_us = host_sleep_us;
+    }
+
+    hs->base.start = host_start;
+    hs->base.read = host_read;
+    hs->base.stop = host_stop;
+    hs->base.del = host_del;
+    hs->base.now_us = host_now_us;
+
+    ESP_LOGI(TAG, "Host source ready: %lu channel(s), %lu Hz, %lu scans/frame, %s x%lu",
+             (unsigned long)norm.num_channels,
+             (unsigned long)cfg->sample_rate_hz, (unsigned long)cfg->frame_samples,
+             hs->host.realtime ? "realtime" : "free-running", (unsigned long)hs->host.speed);
+    *ret_src = &hs->base;
+    return ESP_OK;
+}
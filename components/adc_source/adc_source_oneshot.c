@@ -0,0 +1,326 @@
+// =============================
+// ADC Source - Oneshot Backend (low power)
+// =============================
+// One adc_oneshot_read() per sample; the CPU sleeps between conversions.
+// Two ways to wake up for the next scan:
+//
+//   - ADC_SOURCE_TRIGGER_TICK  : xTaskDelayUntil(). The period must be a
+//     whole number of FreeRTOS ticks (100 Hz tick -> 100, 50, 25, 20 ...
+//     samples/s), which is fine for slow sensors.
+//   - ADC_SOURCE_TRIGGER_TIMER : a gptimer alarm every period (a whole number
+//     of microseconds) gives the reading task a notification.
+//
+// Either way a scan is only read when it is due. Periods that passed while
+// the task was busy are not caught up back to back (their samples would be
+// stamped as evenly spaced when they were not): they are counted as missed
+// scans, and a frame they interrupt is dropped, so every frame delivered is
+// evenly spaced and a stall shows up as a sequence gap.
+//
+// With several channels, every wake-up reads the channels back to back (one
+// scan) and writes each result straight into that channel's run.
+
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_adc/adc_oneshot.h"
+#include "driver/gptimer.h"
+#include "adc_source_priv.h"
+#include "adc_scan.h"
+
+#define TAG "ADC_ONESHOT"
+
+#define ONESHOT_TIMER_RESOLUTION_HZ  1000000    // 1 tick = 1 us
+#define ONESHOT_MIN_CONV_US          50         // Budget per adc_oneshot_read() in timer mode
+
+
+typedef struct {
+    adc_source_t base;                 // Must stay first
+    adc_oneshot_unit_handle_t handle;  // ADC driver handle
+    TickType_t period_ticks;           // Ticks between two conversions
+    TickType_t last_wake;              // xTaskDelayUntil() reference point
+    uint32_t seq;
+    uint64_t scan;                     // Scan counter (rate dividers)
+    uint16_t *runs;                    // Per-channel runs, ADC_SCAN_STRIDE(frame_samples) apart
+    gptimer_handle_t timer;            // ADC_SOURCE_TRIGGER_TIMER only
+    TaskHandle_t volatile reader;      // Task notified by the timer alarm
+} adc_source_oneshot_t;
+
+
+// Runs in ISR context: keep it short
+static bool IRAM_ATTR oneshot_on_alarm(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata,
+                                       void *user_ctx)
+{
+    adc_source_oneshot_t *os = (adc_source_oneshot_t *)user_ctx;
+    BaseType_t woken = pdFALSE;
+    TaskHandle_t reader = os->reader;
+    if (reader) {
+        vTaskNotifyGiveFromISR(reader, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+static esp_err_t oneshot_start(adc_source_t *src)
+{
+    adc_source_oneshot_t *os = (adc_source_oneshot_t *)src;
+    os->seq = 0;
+    os->scan = 0;
+    os->last_wake = xTaskGetTickCount();
+    if (os->timer) {
+        gptimer_set_raw_count(os->timer, 0);
+        return gptimer_start(os->timer);
+    }
+    return ESP_OK;
+}
+
+// Sleeps until the next scan is due. *missed: periods that had already
+// passed unread, skipped over.
+static esp_err_t oneshot_wait_scan(adc_source_oneshot_t *os, uint32_t timeout_ms, uint32_t *missed)
+{
+    *missed = 0;
+    if (!os->timer) {
+        if (xTaskDelayUntil(&os->last_wake, os->period_ticks) == pdFALSE) {
+            // Already late: resume on the current period instead of the old ones
+            TickType_t late = (xTaskGetTickCount() - os->last_wake) / os->period_ticks;
+            os->last_wake += late * os->period_ticks;
+            *missed = late;
+        }
+        return ESP_OK;
+    }
+    // One notification per alarm: take them all, the newest is the scan that is due now
+    uint32_t alarms = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout_ms));
+    if (alarms == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+    *missed = alarms - 1;
+    return ESP_OK;
+}
+
+static esp_err_t oneshot_read(adc_source_t *src, adc_frame_t *frame, uint32_t timeout_ms)
+{
+    adc_source_oneshot_t *os = (adc_source_oneshot_t *)src;
+
+    const uint32_t nch = src->cfg.num_channels;
+    const size_t stride = ADC_SCAN_STRIDE(src->cfg.frame_samples);
+    const int64_t period_us = 1000000 / src->cfg.sample_rate_hz;    // Exact (checked at creation)
+
+    os->reader = xTaskGetCurrentTaskHandle();
+    frame->num_channels = nch;
+    for (uint32_t c = 0; c < nch; c++) {
+        frame->chan[c].channel = src->cfg.channels[c].channel;
+        frame->chan[c].data = os->runs + c * stride;
+        frame->chan[c].len = 0;
+    }
+
+    for (uint32_t i = 0; i < src->cfg.frame_samples; i++, os->scan++) {
+        // --- Wait for the next scan (drift-free: tick count or timer alarm) ---
+        // A timeout drops the partial frame; the next read starts a new one.
+        uint32_t missed;
+        esp_err_t ret = oneshot_wait_scan(os, timeout_ms, &missed);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        if (missed > 0) {
+            // The scan clock ran on without us: keep rate dividers on it, and
+            // start the frame over rather than leave a hole in it
+            src->missed_scans += missed;
+            os->scan += missed;
+            if (i > 0) {
+                src->dropped_frames++;
+                os->seq++;
+                i = 0;
+                for (uint32_t c = 0; c < nch; c++) {
+                    frame->chan[c].len = 0;
+                }
+            }
+        }
+        int64_t now = esp_timer_get_time();     // When the scan was actually read
+        if (i == 0) {
+            frame->timestamp_us = now;
+        }
+
+        for (uint32_t c = 0; c < nch; c++) {
+            adc_frame_chan_t *ch = &frame->chan[c];
+            if (os->scan % src->cfg.channels[c].rate_div != 0) {
+                continue;
+            }
+            int raw = 0;
+            ret = adc_oneshot_read(os->handle, ch->channel, &raw);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "adc_oneshot_read failed! Error code: %d", ret);
+                return ret;
+            }
+            if (ch->len == 0) {
+                ch->timestamp_us = now;
+            }
+            ch->data[ch->len++] = (uint16_t)raw;
+        }
+    }
+    // Channels without a sample this frame still get a consistent time
+    for (uint32_t c = 0; c < nch; c++) {
+        if (frame->chan[c].len == 0) {
+            frame->chan[c].timestamp_us = frame->timestamp_us + (int64_t)src->cfg.frame_samples * period_us;
+        }
+    }
+
+    frame->seq = os->seq++;
+    frame->len = frame->chan[0].len;
+    frame->data = frame->chan[0].data;
+    return ESP_OK;
+}
+
+static esp_err_t oneshot_stop(adc_source_t *src)
+{
+    adc_source_oneshot_t *os = (adc_source_oneshot_t *)src;
+    if (os->timer) {
+        return gptimer_stop(os->timer);
+    }
+    return ESP_OK;
+}
+
+static void oneshot_del(adc_source_t *src)
+{
+    adc_source_oneshot_t *os = (adc_source_oneshot_t *)src;
+    if (os->timer) {
+        gptimer_disable(os->timer);
+        gptimer_del_timer(os->timer);
+    }
+    if (os->handle) {
+        adc_oneshot_del_unit(os->handle);
+    }
+    free(os->runs);
+    free(os);
+}
+
+
+esp_err_t adc_source_new_oneshot(const adc_source_config_t *cfg, adc_source_t **ret_src)
+{
+    adc_source_config_t norm;
+    esp_err_t ret = adc_source_check_config(cfg, &norm);
+    if (ret != ESP_OK || !ret_src) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The period is a whole number of ticks / microseconds, or the source
+    // would run at a different rate than the one everybody else designs for
+    const TickType_t period_ticks = configTICK_RATE_HZ / norm.sample_rate_hz;
+    const uint32_t period_us = ONESHOT_TIMER_RESOLUTION_HZ / norm.sample_rate_hz;
+    if (norm.trigger == ADC_SOURCE_TRIGGER_TIMER) {
+        if (period_us < ONESHOT_MIN_CONV_US * norm.num_channels) {
+            ESP_LOGE(TAG, "%lu Hz x %lu channels is too fast for oneshot reads. Use continuous mode.",
+                     (unsigned long)norm.sample_rate_hz, (unsigned long)norm.num_channels);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (ONESHOT_TIMER_RESOLUTION_HZ % norm.sample_rate_hz != 0) {
+            ESP_LOGE(TAG, "%lu Hz is not a whole number of microseconds per scan.",
+                     (unsigned long)norm.sample_rate_hz);
+            return ESP_ERR_INVALID_ARG;
+        }
+    } else if (period_ticks == 0) {
+        ESP_LOGE(TAG, "%lu Hz is faster than the FreeRTOS tick (%d Hz). Use the timer trigger or continuous mode.",
+                 (unsigned long)norm.sample_rate_hz, configTICK_RATE_HZ);
+        return ESP_ERR_INVALID_ARG;
+    } else if (configTICK_RATE_HZ % norm.sample_rate_hz != 0) {
+        ESP_LOGE(TAG, "%lu Hz is not a whole number of FreeRTOS ticks (%d Hz). Use a divisor of it or the timer trigger.",
+                 (unsigned long)norm.sample_rate_hz, configTICK_RATE_HZ);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    adc_source_oneshot_t *os = calloc(1, sizeof(*os));
+    uint16_t *runs = calloc(adc_scan_storage_len(norm.num_channels, norm.frame_samples), sizeof(uint16_t));
+    if (!os || !runs) {
+        free(os);
+        free(runs);
+        return ESP_ERR_NO_MEM;
+    }
+    os->runs = runs;
+    os->period_ticks = period_ticks;
+
+    // ==============================
+    // 1️⃣ ADC Unit Configuration
+    // ==============================
+    // adc_oneshot_new_unit() allocates the driver object, programs the ADC
+    // registers and hands back a handle used for every later call.
+    adc_oneshot_unit_init_cfg_t init_config = {
+        .unit_id = cfg->unit,
+    };
+    ret = adc_oneshot_new_unit(&init_config, &os->handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize ADC unit! Error code: %d", ret);
+        oneshot_del(&os->base);
+        return ret;
+    }
+
+    // ==============================
+    // 2️⃣ ADC Channel Configuration
+    // ==============================
+    // - bitwidth: Resolution of conversion (default 12-bit)
+    // - atten: How much input voltage the ADC can measure (~3.3V for DB_11)
+    for (uint32_t c = 0; c < norm.num_channels; c++) {
+        adc_oneshot_chan_cfg_t chan_config = {
+            .bitwidth = ADC_BITWIDTH_DEFAULT,
+            .atten = norm.channels[c].atten,
+        };
+        ret = adc_oneshot_config_channel(os->handle, norm.channels[c].channel, &chan_config);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to configure ADC channel %d! Error code: %d", norm.channels[c].channel, ret);
+            oneshot_del(&os->base);
+            return ret;
+        }
+    }
+
+    // ==============================
+    // 3️⃣ Scan Timer (optional)
+    // ==============================
+    // Counts microseconds and raises an alarm every period (auto-reload),
+    // so the scan clock does not depend on the FreeRTOS tick.
+    if (norm.trigger == ADC_SOURCE_TRIGGER_TIMER) {
+        gptimer_config_t timer_cfg = {
+            .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+            .direction = GPTIMER_COUNT_UP,
+            .resolution_hz = ONESHOT_TIMER_RESOLUTION_HZ,
+        };
+        gptimer_alarm_config_t alarm_cfg = {
+            .alarm_count = period_us,
+            .reload_count = 0,
+            .flags.auto_reload_on_alarm = true,
+        };
+        gptimer_event_callbacks_t cbs = {
+            .on_alarm = oneshot_on_alarm,
+        };
+        ret = gptimer_new_timer(&timer_cfg, &os->timer);
+        if (ret == ESP_OK) {
+            ret = gptimer_set_alarm_action(os->timer, &alarm_cfg);
+        }
+        if (ret == ESP_OK) {
+            ret = gptimer_register_event_callbacks(os->timer, &cbs, os);
+        }
+        if (ret == ESP_OK) {
+            ret = gptimer_enable(os->timer);
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set up the scan timer! Error code: %d", ret);
+            if (os->timer) {
+                gptimer_del_timer(os->timer);
+                os->timer = NULL;
+            }
+            oneshot_del(&os->base);
+            return ret;
+        }
+    }
+
+    os->base.cfg = norm;
+    os->base.start = oneshot_start;
+    os->base.read = oneshot_read;
+    os->base.stop = oneshot_stop;
+    os->base.del = oneshot_del;
+    os->base.now_us = esp_timer_get_time;
+
+    ESP_LOGI(TAG, "Oneshot source ready: %lu channel(s), %lu Hz, %lu scans/frame, %s trigger",
+             (unsigned long)norm.num_channels, (unsigned long)cfg->sample_rate_hz, (unsigned long)cfg->frame_samples,
+             os->timer ? "timer" : "tick");
+    *ret_src = &os->base;
+    return ESP_OK;
+}
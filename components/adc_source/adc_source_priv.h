@@ -0,0 +1,41 @@
+// =============================
+// ADC Source - Backend Interface (private)
+// =============================
+// Every backend embeds `adc_source_t` as its first member and fills in the
+// operations below. The generic wrappers in adc_source.c take care of the
+// statistics so that backends only have to move samples.
+
+#pragma once
+
+#include "adc_source.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct adc_source {
+    esp_err_t (*start)(adc_source_t *src);
+    esp_err_t (*read)(adc_source_t *src, adc_frame_t *frame, uint32_t timeout_ms);
+    esp_err_t (*stop)(adc_source_t *src);
+    void      (*del)(adc_source_t *src);
+    int64_t   (*now_us)(void);
+
+    adc_source_config_t cfg;
+
+    // Bookkeeping, updated by adc_source.c
+    uint64_t frames;
+    uint64_t samples;
+    uint32_t dropped_frames;   // Backends add to this when they detect lost frames
+    uint32_t missed_scans;     // Oneshot: scan periods that passed unread
+    int64_t  start_us;
+    bool     running;
+};
+
+// Shared argument check for all constructors. On success `norm` is a copy
+// of cfg with the channel table always filled in (num_channels >= 1,
+// rate_div >= 1), so backends only deal with the scan case.
+esp_err_t adc_source_check_config(const adc_source_config_t *cfg, adc_source_config_t *norm);
+
+#ifdef __cplusplus
+}
+#endif
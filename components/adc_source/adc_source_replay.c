@@ -0,0 +1,314 @@
+// =============================
+// ADC Source - Host Signals and Replay (linux target)
+// =============================
+// Signal callbacks for the host stand-in: synthetic waves, and recorded
+// captures loaded into memory once and replayed scan by scan.
+
+#include <ctype.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "adc_source.h"
+#include "adc_source_priv.h"
+
+#define TAG "ADC_REPLAY"
+
+#define REPLAY_LINE_MAX     256
+#define REPLAY_CODE_MAX     0x0FFF
+
+
+// =============================
+// Synthetic Waves
+// =============================
+// splitmix64 of (seed, channel, n): uniform in [-1, 1), no state to carry
+static float wave_noise(uint32_t seed, int channel, uint64_t n)
+{
+    uint64_t z = n * 0x9E3779B97F4A7C15ULL + ((uint64_t)seed << 32) + (uint64_t)channel * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    return (float)(z >> 40) / (float)(1 << 23) - 1.0f;
+}
+
+uint16_t adc_host_wave_signal(int channel, uint64_t n, void *ctx)
+{
+    const adc_host_wave_t *w = (const adc_host_wave_t *)ctx;
+    double v = w->offset;
+
+    switch (w->kind) {
+    case ADC_HOST_WAVE_SINE: {
+        // Phase in double: n grows large in long accelerated runs
+        double t = (double)n / w->sample_rate_hz;
+        v += w->amplitude * sin(2 * M_PI * w->freq_hz * t + channel * (M_PI / 4));
+        break;
+    }
+    case ADC_HOST_WAVE_NOISE:
+        v += w->amplitude * wave_noise(w->seed ^ 0x5A5A5A5Au, channel, n);
+        break;
+    case ADC_HOST_WAVE_STEPS: {
+        uint64_t step = (uint64_t)((double)n * w->freq_hz / w->sample_rate_hz);
+        v += (step & 1) ? w->amplitude / 2 : -w->amplitude / 2;
+        break;
+    }
+    }
+    if (w->noise > 0) {
+        v += w->noise * wave_noise(w->seed, channel, n);
+    }
+
+    if (v < 0) {
+        return 0;
+    }
+    return (v > REPLAY_CODE_MAX) ? REPLAY_CODE_MAX : (uint16_t)lround(v);
+}
+
+// =============================
+// Replay
+// =============================
+static uint16_t clamp_code(long v)
+{
+    return (v < 0) ? 0 : (v > REPLAY_CODE_MAX) ? REPLAY_CODE_MAX : (uint16_t)v;
+}
+
+// Stores code `col` of the scan being read (rp->num_scans counts complete scans)
+static esp_err_t replay_push(adc_host_replay_t *rp, size_t *cap, uint32_t col, uint16_t code)
+{
+    size_t used = rp->num_scans * rp->num_columns + col;
+    if (used == *cap) {
+        size_t grow = *cap ? *cap * 2 : 4096;
+        uint16_t *codes = realloc(rp->codes, grow * sizeof(uint16_t));
+        if (!codes) {
+            return ESP_ERR_NO_MEM;
+        }
+        rp->codes = codes;
+        *cap = grow;
+    }
+    rp->codes[used] = code;
+    return ESP_OK;
+}
+
+// fgets() splits a line that does not fit; the tail would be read as a row of its own
+static bool replay_line_fits(const char *line, FILE *f, unsigned lineno)
+{
+    size_t n = strlen(line);
+    if ((n > 0 && line[n - 1] == '\n') || feof(f)) {
+        return true;
+    }
+    ESP_LOGE(TAG, "Line %u is longer than %d characters", lineno, REPLAY_LINE_MAX - 2);
+    return false;
+}
+
+// One scan per line: "2048,1990" (any number of columns up to
+// ADC_SOURCE_MAX_CHANNELS, fixed by the first row)
+static esp_err_t replay_load_table(adc_host_replay_t *rp, FILE *f)
+{
+    char line[REPLAY_LINE_MAX];
+    size_t cap = 0;
+    long row[ADC_SOURCE_MAX_CHANNELS];
+    unsigned lineno = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        if (!replay_line_fits(line, f, ++lineno)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        const char *p = line;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (!isdigit((unsigned char)*p) && *p != '-') {
+            continue;       // Header, comment or blank line
+        }
+
+        uint32_t cols = 0;
+        char *end;
+        while (cols < ADC_SOURCE_MAX_CHANNELS) {
+            row[cols++] = strtol(p, &end, 10);
+            while (*end == ' ' || *end == '\t') {
+                end++;
+            }
+            if (*end != ',') {
+                break;
+            }
+            p = end + 1;
+        }
+        // Anything left is a column past the limit or text that is not a code
+        while (isspace((unsigned char)*end)) {
+            end++;
+        }
+        if (*end != '\0') {
+            if (*end == ',') {
+                ESP_LOGE(TAG, "Line %u has more than %d columns", lineno, ADC_SOURCE_MAX_CHANNELS);
+            } else {
+                ESP_LOGE(TAG, "Line %u has text after the codes", lineno);
+            }
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (rp->num_columns == 0) {
+            rp->num_columns = cols;
+        } else if (cols != rp->num_columns) {
+            ESP_LOGE(TAG, "Row %u has %lu columns, expected %lu", (unsigned)rp->num_scans + 1,
+                     (unsigned long)cols, (unsigned long)rp->num_columns);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        for (uint32_t c = 0; c < cols; c++) {
+            if (replay_push(rp, &cap, c, clamp_code(row[c])) != ESP_OK) {
+                return ESP_ERR_NO_MEM;
+            }
+        }
+        rp->num_scans++;
+    }
+    return ESP_OK;
+}
+
+// tools/stream_reader.py --csv rows: "channel,seq,timestamp_us,index,value".
+// Values (mV) are collected per channel id, then interleaved into scans; the
+// capture is cut to the channel with the fewest samples.
+static esp_err_t replay_load_stream_csv(adc_host_replay_t *rp, FILE *f)
+{
+    char line[REPLAY_LINE_MAX];
+    int ids[ADC_SOURCE_MAX_CHANNELS];
+    uint16_t *vals[ADC_SOURCE_MAX_CHANNELS] = { 0 };
+    size_t len[ADC_SOURCE_MAX_CHANNELS] = { 0 };
+    size_t cap[ADC_SOURCE_MAX_CHANNELS] = { 0 };
+    uint32_t nch = 0;
+    esp_err_t ret = ESP_OK;
+
+    unsigned lineno = 0;
+
+    while (ret == ESP_OK && fgets(line, sizeof(line), f)) {
+        if (!replay_line_fits(line, f, ++lineno)) {
+            ret = ESP_ERR_INVALID_SIZE;
+            break;
+        }
+        long ch, seq, ts, idx, value;
+        if (sscanf(line, "%ld,%ld,%ld,%ld,%ld", &ch, &seq, &ts, &idx, &value) != 5) {
+            continue;
+        }
+        uint32_t k = 0;
+        while (k < nch && ids[k] != ch) {
+            k++;
+        }
+        if (k == nch) {
+            if (nch == ADC_SOURCE_MAX_CHANNELS) {
+                continue;
+            }
+            ids[nch++] = (int)ch;
+        }
+        if (len[k] == cap[k]) {
+            cap[k] = cap[k] ? cap[k] * 2 : 4096;
+            uint16_t *grown = realloc(vals[k], cap[k] * sizeof(uint16_t));
+            if (!grown) {
+                ret = ESP_ERR_NO_MEM;
+                break;
+            }
+            vals[k] = grown;
+        }
+        vals[k][len[k]++] = (uint16_t)((value < 0) ? 0 : (value > INT16_MAX) ? INT16_MAX : value);
+    }
+
+    if (ret == ESP_OK && nch > 0) {
+        size_t scans = len[0];
+        for (uint32_t k = 1; k < nch; k++) {
+            scans = (len[k] < scans) ? len[k] : scans;
+        }
+        rp->codes = malloc(scans * nch * sizeof(uint16_t));
+        if (rp->codes) {
+            for (size_t i = 0; i < scans; i++) {
+                for (uint32_t k = 0; k < nch; k++) {
+                    rp->codes[i * nch + k] = vals[k][i];
+                }
+            }
+            rp->num_scans = scans;
+            rp->num_columns = nch;
+            rp->in_mv = true;
+        } else {
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    for (uint32_t k = 0; k < nch; k++) {
+        free(vals[k]);
+    }
+    return ret;
+}
+
+static esp_err_t replay_load_binary(adc_host_replay_t *rp, FILE *f, uint32_t num_channels)
+{
+    uint8_t le[2];
+    size_t cap = 0;
+    rp->num_columns = num_channels;
+
+    for (uint32_t col = 0; fread(le, 1, sizeof(le), f) == sizeof(le); ) {
+        if (replay_push(rp, &cap, col, clamp_code(le[0] | (le[1] << 8))) != ESP_OK) {
+            return ESP_ERR_NO_MEM;
+        }
+        // Count complete scans only; a trailing partial scan is ignored
+        if (++col == num_channels) {
+            col = 0;
+            rp->num_scans++;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t adc_host_replay_load(adc_host_replay_t *rp, const char *path, const adc_source_config_t *cfg)
+{
+    adc_source_config_t norm;
+    if (!rp || !path || adc_source_check_config(cfg, &norm) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(rp, 0, sizeof(*rp));
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        ESP_LOGE(TAG, "Cannot open %s", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // --- 1. Load by format ---
+    esp_err_t ret;
+    const char *ext = strrchr(path, '.');
+    if (ext && strcmp(ext, ".csv") == 0) {
+        char first[REPLAY_LINE_MAX] = "";
+        if (!fgets(first, sizeof(first), f)) {
+            first[0] = '\0';
+        }
+        rewind(f);
+        ret = (strncmp(first, "channel,seq,", 12) == 0) ? replay_load_stream_csv(rp, f) : replay_load_table(rp, f);
+    } else {
+        ret = replay_load_binary(rp, f, norm.num_channels);
+    }
+    fclose(f);
+    if (ret == ESP_OK && rp->num_scans == 0) {
+        ESP_LOGE(TAG, "No samples in %s", path);
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+    if (ret != ESP_OK) {
+        adc_host_replay_free(rp);
+        return ret;
+    }
+
+    // --- 2. Channel id -> column, in configuration order ---
+    for (uint32_t c = 0; c < norm.num_channels; c++) {
+        rp->column[norm.channels[c].channel] = (uint8_t)(c % rp->num_columns);
+    }
+    ESP_LOGI(TAG, "Replaying %s: %u scans x %lu column(s)", path, (unsigned)rp->num_scans,
+             (unsigned long)rp->num_columns);
+    return ESP_OK;
+}
+
+uint16_t adc_host_replay_signal(int channel, uint64_t n, void *ctx)
+{
+    const adc_host_replay_t *rp = (const adc_host_replay_t *)ctx;
+    return rp->codes[(n % rp->num_scans) * rp->num_columns + rp->column[channel & 0x0F]];
+}
+
+void adc_host_replay_free(adc_host_replay_t *rp)
+{
+    if (!rp) {
+        return;
+    }
+    free(rp->codes);
+    memset(rp, 0, sizeof(*rp));
+}
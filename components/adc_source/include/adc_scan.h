@@ -0,0 +1,97 @@
+// =============================
+// ADC Scan De-interleaver
+// =============================
+// In scan mode the ADC converts the channels of the pattern one after the
+// other and DMA writes the results interleaved:
+//
+//   ch6 ch7 ch4 ch5 | ch6 ch7 ch4 ch5 | ch6 ...      (one scan per "|")
+//
+// The filter stages want one contiguous run per channel instead
+// (structure of arrays), so each frame is split once, right after DMA:
+//
+//   out[0]: ch6 ch6 ch6 ...
+//   out[1]: ch7 ch7 ch7 ...
+//
+// Input words use the ESP32 DMA result layout (ADC_DIGI_OUTPUT_FORMAT_TYPE1):
+// channel in bits 15..12, code in bits 11..0. Each result is routed by its
+// channel id, not by its position, so a missing or extra result cannot shift
+// the remaining channels: the scan is resynchronised and the gap is filled
+// with the channel's previous value, which keeps every run on the same scan
+// index (and therefore on the same timestamps).
+//
+// Plain C, also built on the host (linux target).
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "adc_source.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADC_SCAN_MAX_CHANNEL_ID     16      // Channel field is 4 bits wide
+#define ADC_SCAN_WORD(ch, code)     ((uint16_t)(((ch) << 12) | ((code) & 0x0FFF)))
+#define ADC_SCAN_WORD_CHANNEL(w)    ((w) >> 12)
+#define ADC_SCAN_WORD_CODE(w)       ((w) & 0x0FFF)
+
+// Per-channel runs start on 16-byte boundaries
+#define ADC_SCAN_RUN_ALIGN          8       // Samples
+#define ADC_SCAN_STRIDE(capacity)   (((capacity) + ADC_SCAN_RUN_ALIGN - 1) & ~(size_t)(ADC_SCAN_RUN_ALIGN - 1))
+
+typedef struct {
+    // Pattern (fixed after init)
+    uint32_t  num_channels;
+    uint32_t  sample_rate_hz;                   // Scans per second
+    int       channel[ADC_SOURCE_MAX_CHANNELS]; // Slot -> channel id
+    uint32_t  rate_div[ADC_SOURCE_MAX_CHANNELS];
+    uint8_t   slot_of[ADC_SCAN_MAX_CHANNEL_ID]; // Channel id -> slot, 0xFF = not scanned
+    uint16_t *run[ADC_SOURCE_MAX_CHANNELS];     // Output runs inside the caller's storage
+    size_t    capacity;                         // Samples per run
+
+    // Running state
+    uint32_t  slot;                             // Slot the next result should belong to
+    uint64_t  scan;                             // Index of the scan in progress
+    uint32_t  phase[ADC_SOURCE_MAX_CHANNELS];   // Scans until the channel keeps one (rate_div)
+    uint16_t  hold[ADC_SOURCE_MAX_CHANNELS];    // Last code per channel (gap filler)
+
+    // Statistics
+    uint32_t  resyncs;                          // Results out of pattern order
+    uint32_t  filled;                           // Samples filled in for missing results
+    uint32_t  foreign;                          // Results of channels not in the pattern
+} adc_scan_t;
+
+// Storage (uint16_t) needed for num_channels runs of `capacity` samples
+static inline size_t adc_scan_storage_len(uint32_t num_channels, size_t capacity)
+{
+    return num_channels * ADC_SCAN_STRIDE(capacity);
+}
+
+// cfg must be normalised (num_channels >= 1). storage holds
+// adc_scan_storage_len() samples and should be 16-byte aligned.
+esp_err_t adc_scan_init(adc_scan_t *scan, const adc_source_config_t *cfg, uint16_t *storage, size_t capacity);
+
+// Splits n interleaved words into the per-channel runs and fills
+// frame->timestamp_us, num_channels, chan[] and the data/len shorthand.
+// t_scan_us is the conversion time of the start of scan `scan->scan`
+// (the scan in progress when the call starts). frame->seq is left alone.
+void adc_scan_deinterleave(adc_scan_t *scan, const uint16_t *words, size_t n, int64_t t_scan_us, adc_frame_t *frame);
+
+// Advances the scan counter past `scans` lost scans (dropped DMA frames),
+// so rate dividers stay in phase.
+void adc_scan_skip(adc_scan_t *scan, uint64_t scans);
+
+// Back to scan 0, slot 0
+void adc_scan_reset(adc_scan_t *scan);
+
+// Conversion time offset of a channel slot within a scan
+static inline int64_t adc_scan_slot_offset_us(const adc_scan_t *scan, uint32_t slot)
+{
+    return (int64_t)slot * 1000000 / ((int64_t)scan->sample_rate_hz * scan->num_channels);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,209 @@
+// =============================
+// ADC Acquisition Source Interface
+// =============================
+// A small interface that hides *how* samples are acquired from the code that
+// processes them. Every backend hands over whole frames of raw ADC codes:
+//
+//   - oneshot    : adc_oneshot driver, paced by the FreeRTOS tick (low power)
+//   - continuous : adc_continuous DMA driver, kHz..MHz sample rates
+//   - host       : synthetic stand-in for the ESP-IDF `linux` target / tests
+//
+// A source samples one channel or a scan of up to ADC_SOURCE_MAX_CHANNELS
+// channels. Frames are handed over de-interleaved: one contiguous run of
+// samples per channel (structure of arrays), see adc_scan.h.
+//
+// Typical usage:
+//
+//   adc_source_t *src;
+//   adc_source_new_continuous(&cfg, &src);
+//   adc_source_start(src);
+//   while (1) {
+//       adc_frame_t frame;
+//       if (adc_source_read(src, &frame, 100) == ESP_OK) {
+//           for (uint32_t c = 0; c < frame.num_channels; c++) {
+//               process(c, frame.chan[c].data, frame.chan[c].len);
+//           }
+//       }
+//   }
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Opaque handle, created by one of the adc_source_new_*() functions
+typedef struct adc_source adc_source_t;
+
+#define ADC_SOURCE_MAX_CHANNELS   8     // ADC1 has 8 channels on ESP32
+
+// =============================
+// Configuration
+// =============================
+// unit / channel / atten take the values of adc_unit_t, adc_channel_t and
+// adc_atten_t. They are plain integers so that this header also builds on
+// the `linux` target, where the ADC HAL types are not available.
+//
+// Multi-channel scan: fill channels[] and num_channels. The ADC then converts
+// the channels in table order, one after the other, sample_rate_hz times per
+// second (the controller itself runs at sample_rate_hz * num_channels).
+// A channel with rate_div = N keeps every Nth scan only.
+typedef struct {
+    int      channel;         // adc_channel_t
+    int      atten;           // adc_atten_t
+    uint32_t rate_div;        // 1 (or 0) = every scan
+} adc_source_channel_cfg_t;
+
+// Oneshot pacing. The continuous backend is always clocked by the ADC
+// controller and hands frames over from its conversion-done interrupt.
+typedef enum {
+    ADC_SOURCE_TRIGGER_TICK = 0,  // vTaskDelayUntil(): whole FreeRTOS ticks, lowest power
+    ADC_SOURCE_TRIGGER_TIMER,     // gptimer alarm wakes the reading task: 1 us resolution
+} adc_source_trigger_t;
+
+typedef struct {
+    int      unit;            // ADC_UNIT_1 (continuous mode supports ADC1 only on ESP32)
+    int      channel;         // e.g. ADC_CHANNEL_6 (GPIO34), used when num_channels == 0
+    int      atten;           // e.g. ADC_ATTEN_DB_11, used when num_channels == 0
+    uint32_t sample_rate_hz;  // Scans (samples per channel) per second
+    uint32_t frame_samples;   // Scans handed over per adc_source_read()
+    uint32_t num_channels;    // 0 = single channel from channel/atten above
+    adc_source_channel_cfg_t channels[ADC_SOURCE_MAX_CHANNELS];
+    adc_source_trigger_t trigger; // Oneshot only
+} adc_source_config_t;
+
+// =============================
+// Frames
+// =============================
+// A frame holds one contiguous run of raw codes per channel. The runs are
+// owned by the source and stay valid until the next adc_source_read() on
+// the same source.
+//
+// Timestamps are on a common clock: chan[a].data[i] and chan[b].data[i]
+// (same rate_div) come from the same scan and differ only by the slot delay.
+typedef struct {
+    int       channel;        // adc_channel_t of this run
+    size_t    len;            // Number of valid samples in data
+    uint16_t *data;           // Raw ADC codes (12-bit)
+    int64_t   timestamp_us;   // Conversion time of data[0]
+} adc_frame_chan_t;
+
+typedef struct {
+    uint32_t  seq;            // Frame sequence number; a jump means frames were dropped
+    int64_t   timestamp_us;   // Capture time of the first scan in the frame
+    size_t    len;            // Same as chan[0].len (single-channel shorthand)
+    uint16_t *data;           // Same as chan[0].data
+    uint32_t  num_channels;
+    adc_frame_chan_t chan[ADC_SOURCE_MAX_CHANNELS];
+} adc_frame_t;
+
+// =============================
+// Statistics
+// =============================
+typedef struct {
+    uint64_t frames;          // Frames delivered to the caller
+    uint64_t samples;         // Samples delivered to the caller (all channels)
+    uint32_t dropped_frames;  // Frames lost because the reader fell behind
+    uint32_t missed_scans;    // Oneshot: scan periods that passed while the reader was busy
+    int64_t  elapsed_us;      // Time since adc_source_start()
+    uint32_t samples_per_sec; // Sustained rate over elapsed_us
+} adc_source_stats_t;
+
+// =============================
+// Host stand-in (linux target / tests)
+// =============================
+// Produces the raw code for absolute sample (scan) index `n`.
+typedef uint16_t (*adc_host_signal_fn_t)(uint64_t n, void *ctx);
+// Same for scans: the raw code of `channel` in scan `n`.
+typedef uint16_t (*adc_host_scan_signal_fn_t)(int channel, uint64_t n, void *ctx);
+
+typedef struct {
+    adc_host_signal_fn_t signal;  // NULL = built-in 10 Hz sine around mid-scale
+    adc_host_scan_signal_fn_t scan_signal; // Multi-channel; NULL = signal() on every channel
+    void    *signal_ctx;          // Passed to signal() / scan_signal()
+    bool     realtime;            // true: pace frames at sample_rate_hz; false: as fast as possible
+    uint32_t max_queued_frames;   // Realtime only: backlog above this is dropped (like the DMA pool)
+    uint32_t speed;               // Realtime only: clock runs this many times faster (0 = 1)
+    void   (*wait_us)(int64_t us); // Realtime only: how to wait for a frame; NULL = nanosleep()
+                                   // (under FreeRTOS pass one that blocks the task, e.g. vTaskDelay)
+} adc_host_source_config_t;
+
+// Built-in test signals, for scan_signal (ctx = adc_host_wave_t *). Noise is
+// a hash of (seed, channel, n): the same scan always gets the same value.
+typedef enum {
+    ADC_HOST_WAVE_SINE,           // offset + amplitude * sin(2 pi freq t), phase shifted per channel
+    ADC_HOST_WAVE_NOISE,          // offset + uniform noise of +-amplitude
+    ADC_HOST_WAVE_STEPS,          // offset -/+ amplitude / 2, switching freq_hz times per second
+} adc_host_wave_kind_t;
+
+typedef struct {
+    adc_host_wave_kind_t kind;
+    uint32_t sample_rate_hz;      // Scan rate the signal is generated for
+    float    freq_hz;
+    float    amplitude;           // Raw codes
+    float    offset;              // Raw codes
+    float    noise;               // Uniform noise of +-noise codes added to any kind
+    uint32_t seed;
+} adc_host_wave_t;
+
+uint16_t adc_host_wave_signal(int channel, uint64_t n, void *ctx);
+
+// Recorded capture replayed as raw codes, for scan_signal (ctx =
+// adc_host_replay_t *). Loops at the end. Formats, by file extension:
+//   .csv : one scan per line, one column per channel (non-numeric lines are
+//          skipped), or the "channel,seq,timestamp_us,index,value" rows that
+//          tools/stream_reader.py --csv writes (one column per channel id,
+//          in order of appearance). Those hold filtered millivolts, not
+//          codes: they are kept as 0 .. INT16_MAX and in_mv is set, and the
+//          caller maps them back to codes through its calibration (see
+//          adc_cali_lut_mv_to_raw) before replaying
+//   else : little-endian uint16 codes, num_channels per scan (interleaved)
+// Column k feeds the k-th channel of the source configuration (modulo the
+// number of columns). Codes are clamped to 0..4095. A csv row with more
+// than ADC_SOURCE_MAX_CHANNELS columns, text after its codes, or over 254
+// characters fails the load with ESP_ERR_INVALID_SIZE.
+typedef struct {
+    uint16_t *codes;              // num_scans x num_columns
+    size_t    num_scans;
+    uint32_t  num_columns;
+    uint8_t   column[16];         // Channel id (4 bits) -> column
+    bool      in_mv;              // Values are millivolts still to be mapped to codes
+} adc_host_replay_t;
+
+esp_err_t adc_host_replay_load(adc_host_replay_t *rp, const char *path, const adc_source_config_t *cfg);
+uint16_t adc_host_replay_signal(int channel, uint64_t n, void *ctx);
+void adc_host_replay_free(adc_host_replay_t *rp);
+
+// =============================
+// Constructors
+// =============================
+// Each backend is only compiled where it makes sense; the others return
+// ESP_ERR_NOT_SUPPORTED.
+esp_err_t adc_source_new_oneshot(const adc_source_config_t *cfg, adc_source_t **ret_src);
+esp_err_t adc_source_new_continuous(const adc_source_config_t *cfg, adc_source_t **ret_src);
+esp_err_t adc_source_new_host(const adc_source_config_t *cfg, const adc_host_source_config_t *host_cfg,
+                              adc_source_t **ret_src);
+
+// =============================
+// Operations
+// =============================
+esp_err_t adc_source_start(adc_source_t *src);
+
+// Blocks up to timeout_ms for the next frame. Returns ESP_ERR_TIMEOUT if none arrived.
+// With ADC_SOURCE_TRIGGER_TIMER the timer wakes the calling task through its
+// task notification value, so always read from the same task.
+esp_err_t adc_source_read(adc_source_t *src, adc_frame_t *frame, uint32_t timeout_ms);
+
+esp_err_t adc_source_stop(adc_source_t *src);
+void adc_source_get_stats(adc_source_t *src, adc_source_stats_t *stats);
+const adc_source_config_t *adc_source_get_config(const adc_source_t *src);
+void adc_source_del(adc_source_t *src);
+
+#ifdef __cplusplus
+}
+#endif
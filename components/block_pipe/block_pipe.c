@@ -0,0 +1,351 @@
+// =============================
+// Zero-Copy Block Pipeline
+// =============================
+// Queues carry pipe_block_t pointers only (4 bytes per hand-off). Every queue
+// can hold the whole pool, so a send never blocks. A NULL pointer tells a
+// stage task to exit.
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "block_pipe.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+#else
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#endif
+
+#define TAG "BLOCK_PIPE"
+
+#define BLOCK_PIPE_RUN_ALIGN    8       // Samples: runs start on 16-byte boundaries
+
+
+typedef struct {
+    block_pipe_t *pipe;
+    uint32_t index;
+    TaskHandle_t task;
+    block_pipe_stage_stats_t stats;     // Written by the stage task only
+} block_pipe_stage_t;
+
+struct block_pipe {
+    block_pipe_config_t cfg;
+    pipe_block_t  *blocks;
+    int16_t       *storage;
+    QueueHandle_t  free_q;
+    QueueHandle_t  stage_q[BLOCK_PIPE_MAX_STAGES];
+    SemaphoreHandle_t exited;           // Given by a stage task when it ends
+    block_pipe_stage_t stage[BLOCK_PIPE_MAX_STAGES];
+    bool           running;
+    // Producer side
+    uint32_t       submitted;
+    uint32_t       starved;
+    uint32_t       in_flight_max;
+    atomic_uint    in_flight;           // Producer increments, last stage decrements
+};
+
+
+static int64_t block_pipe_now_us(void)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    return esp_timer_get_time();
+#endif
+}
+
+static int16_t *block_pipe_alloc_storage(size_t samples, uint32_t caps)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    (void)caps;
+    size_t bytes = (samples * sizeof(int16_t) + 15) & ~(size_t)15;
+    int16_t *p = aligned_alloc(16, bytes);
+    if (p) {
+        memset(p, 0, bytes);
+    }
+    return p;
+#else
+    return heap_caps_aligned_calloc(16, samples, sizeof(int16_t), caps);
+#endif
+}
+
+static void block_pipe_free_storage(int16_t *p)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    free(p);
+#else
+    heap_caps_free(p);
+#endif
+}
+
+static void block_pipe_stage_task(void *arg)
+{
+    block_pipe_stage_t *st = (block_pipe_stage_t *)arg;
+    block_pipe_t *pipe = st->pipe;
+    const block_pipe_stage_cfg_t *cfg = &pipe->cfg.stages[st->index];
+    const bool last = (st->index + 1 == pipe->cfg.num_stages);
+    QueueHandle_t next = last ? pipe->free_q : pipe->stage_q[st->index + 1];
+
+    while (1) {
+        pipe_block_t *blk;
+        if (xQueueReceive(pipe->stage_q[st->index], &blk, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (!blk) {
+            break;      // Stop request; everything queued before it is done
+        }
+
+        int64_t t0 = block_pipe_now_us();
+        cfg->fn(blk, cfg->ctx);
+        st->stats.busy_us += block_pipe_now_us() - t0;
+        st->stats.blocks++;
+        for (uint32_t c = 0; c < blk->num_channels; c++) {
+            st->stats.samples += blk->len[c];
+        }
+
+        // --- Hand the pointer on (back to the pool after the last stage) ---
+        if (last) {
+            atomic_fetch_sub_explicit(&pipe->in_flight, 1, memory_order_relaxed);
+        }
+        xQueueSend(next, &blk, 0);
+    }
+
+    xSemaphoreGive(pipe->exited);
+    vTaskDelete(NULL);
+}
+
+
+esp_err_t block_pipe_new(const block_pipe_config_t *cfg, block_pipe_t **ret_pipe)
+{
+    if (!cfg || !ret_pipe || cfg->num_channels == 0 || cfg->num_channels > BLOCK_PIPE_MAX_CHANNELS ||
+        cfg->block_samples == 0 || cfg->depth < 2 || cfg->depth > BLOCK_PIPE_MAX_DEPTH ||
+        cfg->num_stages == 0 || cfg->num_stages > BLOCK_PIPE_MAX_STAGES) {
+        ESP_LOGE(TAG, "Invalid pipeline configuration");
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (uint32_t i = 0; i < cfg->num_stages; i++) {
+        if (!cfg->stages[i].fn) {
+            ESP_LOGE(TAG, "Stage %lu has no function", (unsigned long)i);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    block_pipe_t *pipe = calloc(1, sizeof(*pipe));
+    if (!pipe) {
+        return ESP_ERR_NO_MEM;
+    }
+    pipe->cfg = *cfg;
+#if !CONFIG_IDF_TARGET_LINUX
+    if (pipe->cfg.caps == 0) {
+        pipe->cfg.caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+    }
+#endif
+
+    // --- Block storage: depth x channels runs, each stride samples apart ---
+    const size_t stride = (cfg->block_samples + BLOCK_PIPE_RUN_ALIGN - 1) & ~(size_t)(BLOCK_PIPE_RUN_ALIGN - 1);
+    pipe->blocks = calloc(cfg->depth, sizeof(pipe_block_t));
+    pipe->storage = block_pipe_alloc_storage(stride * cfg->num_channels * cfg->depth, pipe->cfg.caps);
+    pipe->free_q = xQueueCreate(cfg->depth + 1, sizeof(pipe_block_t *));
+    pipe->exited = xSemaphoreCreateBinary();
+    bool ok = pipe->blocks && pipe->storage && pipe->free_q && pipe->exited;
+    for (uint32_t i = 0; ok && i < cfg->num_stages; i++) {
+        // +1: room for the stop request on top of the whole pool
+        pipe->stage_q[i] = xQueueCreate(cfg->depth + 1, sizeof(pipe_block_t *));
+        ok = pipe->stage_q[i] != NULL;
+        pipe->stage[i].pipe = pipe;
+        pipe->stage[i].index = i;
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "Out of memory for %lu blocks of %lu x %u samples", (unsigned long)cfg->depth,
+                 (unsigned long)cfg->num_channels, (unsigned)cfg->block_samples);
+        block_pipe_del(pipe);
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (uint32_t b = 0; b < cfg->depth; b++) {
+        pipe_block_t *blk = &pipe->blocks[b];
+        blk->num_channels = cfg->num_channels;
+        for (uint32_t c = 0; c < cfg->num_channels; c++) {
+            blk->data[c] = pipe->storage + (b * cfg->num_channels + c) * stride;
+        }
+        xQueueSend(pipe->free_q, &blk, 0);
+    }
+
+    ESP_LOGI(TAG, "Pipeline ready: %lu stage(s), %lu blocks of %lu x %u samples",
+             (unsigned long)cfg->num_stages, (unsigned long)cfg->depth,
+             (unsigned long)cfg->num_channels, (unsigned)cfg->block_samples);
+    *ret_pipe = pipe;
+    return ESP_OK;
+}
+
+esp_err_t block_pipe_start(block_pipe_t *pipe)
+{
+    if (!pipe || pipe->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Start from the last stage so every queue has a taker before blocks arrive
+    for (int i = (int)pipe->cfg.num_stages - 1; i >= 0; i--) {
+        const block_pipe_stage_cfg_t *sc = &pipe->cfg.stages[i];
+        BaseType_t ok = xTaskCreatePinnedToCore(block_pipe_stage_task, sc->name ? sc->name : "pipe stage",
+                                                sc->stack, &pipe->stage[i], sc->priority,
+                                                &pipe->stage[i].task, sc->core);
+        if (ok != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create stage task %d", i);
+            // Stop the stages already running (the later ones)
+            for (int k = i + 1; k < (int)pipe->cfg.num_stages; k++) {
+                pipe_block_t *stop = NULL;
+                xQueueSend(pipe->stage_q[k], &stop, portMAX_DELAY);
+                xSemaphoreTake(pipe->exited, portMAX_DELAY);
+            }
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    pipe->running = true;
+    return ESP_OK;
+}
+
+pipe_block_t *block_pipe_acquire(block_pipe_t *pipe, TickType_t timeout)
+{
+    pipe_block_t *blk = NULL;
+    if (xQueueReceive(pipe->free_q, &blk, timeout) != pdTRUE) {
+        pipe->starved++;
+        return NULL;
+    }
+    uint32_t n = atomic_fetch_add_explicit(&pipe->in_flight, 1, memory_order_relaxed) + 1;
+    if (n > pipe->in_flight_max) {
+        pipe->in_flight_max = n;
+    }
+    for (uint32_t c = 0; c < blk->num_channels; c++) {
+        blk->len[c] = 0;
+    }
+    return blk;
+}
+
+void block_pipe_submit(block_pipe_t *pipe, pipe_block_t *blk)
+{
+    pipe->submitted++;
+    xQueueSend(pipe->stage_q[0], &blk, 0);
+}
+
+esp_err_t block_pipe_stop(block_pipe_t *pipe)
+{
+    if (!pipe || !pipe->running) {
+        return ESP_OK;
+    }
+    // One stage at a time: a stage's last forwarded block is queued ahead
+    // of the next stage's stop request
+    for (uint32_t i = 0; i < pipe->cfg.num_stages; i++) {
+        pipe_block_t *stop = NULL;
+        xQueueSend(pipe->stage_q[i], &stop, portMAX_DELAY);
+        xSemaphoreTake(pipe->exited, portMAX_DELAY);
+        pipe->stage[i].task = NULL;
+    }
+    pipe->running = false;
+    return ESP_OK;
+}
+
+void block_pipe_get_stats(block_pipe_t *pipe, block_pipe_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->submitted = pipe->submitted;
+    stats->starved = pipe->starved;
+    stats->in_flight_max = pipe->in_flight_max;
+    stats->num_stages = pipe->cfg.num_stages;
+    for (uint32_t i = 0; i < pipe->cfg.num_stages; i++) {
+        stats->stage[i] = pipe->stage[i].stats;     // Approximate while running
+    }
+}
+
+void block_pipe_del(block_pipe_t *pipe)
+{
+    if (!pipe) {
+        return;
+    }
+    block_pipe_stop(pipe);
+    for (uint32_t i = 0; i < BLOCK_PIPE_MAX_STAGES; i++) {
+        if (pipe->stage_q[i]) {
+            vQueueDelete(pipe->stage_q[i]);
+        }
+    }
+    if (pipe->free_q) {
+        vQueueDelete(pipe->free_q);
+    }
+    if (pipe->exited) {
+        vSemaphoreDelete(pipe->exited);
+    }
+    block_pipe_free_storage(pipe->storage);
+    free(pipe->blocks);
+    free(pipe);
+}
+
+uint32_t block_pipe_capacity_hz(const uint32_t *ns_per_sample, const BaseType_t *core, size_t n,
+                                uint32_t load_pct)
+{
+    uint64_t per_core[portNUM_PROCESSORS] = {0};
+    for (size_t i = 0; i < n; i++) {
+        BaseType_t c = (core[i] >= 0 && core[i] < portNUM_PROCESSORS) ? core[i] : 0;
+        per_core[c] += ns_per_sample[i];
+    }
+
+    uint64_t busiest = 0;
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        if (per_core[c] > busiest) {
+            busiest = per_core[c];
+        }
+    }
+    if (busiest == 0) {
+        return UINT32_MAX;
+    }
+    uint64_t hz = 10000000ULL * load_pct / busiest;    // 1e9 ns/s * load_pct / 100
+    return hz > UINT32_MAX ? UINT32_MAX : (uint32_t)hz;
+}
+
+// =============================
+// Per-Core Load
+// =============================
+// The idle task of each core only runs when nothing else wants that core, so
+// its share of the run-time counter is the core's free time.
+
+esp_err_t block_pipe_core_load(block_pipe_load_snap_t *snap, uint8_t load_pct[portNUM_PROCESSORS])
+{
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS && !CONFIG_IDF_TARGET_LINUX
+    configRUN_TIME_COUNTER_TYPE now = portGET_RUN_TIME_COUNTER_VALUE();
+    configRUN_TIME_COUNTER_TYPE idle[portNUM_PROCESSORS];
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        idle[c] = ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(c));
+    }
+
+    esp_err_t ret = ESP_ERR_NOT_FINISHED;
+    configRUN_TIME_COUNTER_TYPE total = now - (configRUN_TIME_COUNTER_TYPE)snap->total;
+    if (snap->valid && total > 0) {
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            configRUN_TIME_COUNTER_TYPE free_time = idle[c] - (configRUN_TIME_COUNTER_TYPE)snap->idle[c];
+            if (free_time > total) {
+                free_time = total;
+            }
+            load_pct[c] = (uint8_t)(100 - (uint64_t)free_time * 100 / total);
+        }
+        ret = ESP_OK;
+    }
+
+    snap->total = now;
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        snap->idle[c] = idle[c];
+    }
+    snap->valid = true;
+    return ret;
+#else
+    (void)snap;
+    (void)load_pct;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
@@ -0,0 +1,143 @@
+// =============================
+// Zero-Copy Block Pipeline
+// =============================
+// A fixed pool of sample blocks that travel through a chain of stage tasks.
+// Only the block pointer moves; the samples stay where the producer wrote
+// them and every stage works on them in place:
+//
+//                +-------------------- free queue <-------------------+
+//                v                                                    |
+//   producer: acquire -> fill -> submit -> [stage 0] -> [stage 1] -> ...
+//   (acquisition task)                      (own task, pinned to a core)
+//
+// With depth 2 this is a ping-pong buffer: the producer fills one block while
+// the stages work on the other. More blocks absorb stage hiccups.
+//
+// Everything (blocks, queues, tasks) is created by block_pipe_new() /
+// block_pipe_start(); after that nothing is allocated. Block storage comes
+// from heap_caps with the configured caps (internal byte-addressable RAM by
+// default: the CPU is the only one that touches the blocks), each channel run
+// 16-byte aligned.
+//
+// Typical usage:
+//
+//   block_pipe_new(&cfg, &pipe);
+//   block_pipe_start(pipe);
+//   while (1) {                                  // acquisition task
+//       pipe_block_t *blk = block_pipe_acquire(pipe, 0);
+//       if (!blk) continue;                      // stages behind: counted as starved
+//       fill(blk->data[c], blk->len[c]);
+//       block_pipe_submit(pipe, blk);
+//   }
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLOCK_PIPE_MAX_STAGES     4
+#define BLOCK_PIPE_MAX_CHANNELS   8
+#define BLOCK_PIPE_MAX_DEPTH      32
+
+typedef struct {
+    uint32_t  seq;                               // Set by the producer
+    int64_t   timestamp_us;                      // Capture time of the first sample
+    int64_t   newest_us;                         // Capture time of the newest sample
+    int64_t   chan_us[BLOCK_PIPE_MAX_CHANNELS];  // Per channel: time of data[c][0] (set by the producer)
+    uint32_t  num_channels;
+    size_t    len[BLOCK_PIPE_MAX_CHANNELS];      // Valid samples per channel
+    int16_t  *data[BLOCK_PIPE_MAX_CHANNELS];     // Fixed runs inside the pool (capacity block_samples)
+} pipe_block_t;
+
+// Works on the block in place. Runs in the stage's own task.
+typedef void (*block_pipe_stage_fn_t)(pipe_block_t *blk, void *ctx);
+
+typedef struct {
+    const char *name;                            // Task name
+    block_pipe_stage_fn_t fn;
+    void       *ctx;
+    BaseType_t  core;                            // 0, 1 or tskNO_AFFINITY
+    UBaseType_t priority;
+    uint32_t    stack;                           // Bytes
+} block_pipe_stage_cfg_t;
+
+typedef struct {
+    uint32_t num_channels;                       // Runs per block
+    size_t   block_samples;                      // Capacity of each run
+    uint32_t depth;                              // Blocks in the pool, >= 2
+    uint32_t caps;                               // heap_caps for the storage (0 = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+    uint32_t num_stages;
+    block_pipe_stage_cfg_t stages[BLOCK_PIPE_MAX_STAGES];
+} block_pipe_config_t;
+
+typedef struct {
+    uint32_t blocks;                             // Blocks processed
+    uint64_t samples;                            // Samples in those blocks (all channels)
+    int64_t  busy_us;                            // Time spent in the stage function
+} block_pipe_stage_stats_t;
+
+typedef struct {
+    uint32_t submitted;                          // Blocks handed to stage 0
+    uint32_t starved;                            // acquire() calls that found no free block
+    uint32_t in_flight_max;                      // Most blocks out of the pool at once
+    uint32_t num_stages;
+    block_pipe_stage_stats_t stage[BLOCK_PIPE_MAX_STAGES];
+} block_pipe_stats_t;
+
+typedef struct block_pipe block_pipe_t;
+
+esp_err_t block_pipe_new(const block_pipe_config_t *cfg, block_pipe_t **ret_pipe);
+
+// Creates the stage tasks (pinned as configured)
+esp_err_t block_pipe_start(block_pipe_t *pipe);
+
+// Producer side, single producer only. acquire() returns NULL if no block is
+// free within timeout; the runs keep their pointers, len[] is reset to 0.
+pipe_block_t *block_pipe_acquire(block_pipe_t *pipe, TickType_t timeout);
+void block_pipe_submit(block_pipe_t *pipe, pipe_block_t *blk);
+
+// Lets every block already submitted finish, then ends the stage tasks
+esp_err_t block_pipe_stop(block_pipe_t *pipe);
+
+void block_pipe_get_stats(block_pipe_t *pipe, block_pipe_stats_t *stats);
+
+// Stops the pipeline if needed and frees everything
+void block_pipe_del(block_pipe_t *pipe);
+
+// =============================
+// Capacity Estimate
+// =============================
+// Highest sample rate (samples/s over all channels) that per-sample costs
+// allow when task i runs on core[i] (tskNO_AFFINITY counts as core 0). The
+// busiest core sets the limit; load_pct is the share of a core the pipeline
+// may use (ISRs, Wi-Fi, logging need the rest). A model, not a measurement:
+// hand-offs and contention between the cores are left out, so it is an upper
+// bound (the host benchmark runs the pipeline to compare).
+uint32_t block_pipe_capacity_hz(const uint32_t *ns_per_sample, const BaseType_t *core, size_t n,
+                                uint32_t load_pct);
+
+// =============================
+// Per-Core Load
+// =============================
+// CPU use of each core since the previous call, from the idle tasks' run-time
+// counters. Needs CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS, otherwise returns
+// ESP_ERR_NOT_SUPPORTED. Start with a zeroed snapshot; the first call only
+// records it and returns ESP_ERR_NOT_FINISHED.
+typedef struct {
+    bool     valid;
+    uint64_t total;
+    uint64_t idle[portNUM_PROCESSORS];
+} block_pipe_load_snap_t;
+
+esp_err_t block_pipe_core_load(block_pipe_load_snap_t *snap, uint8_t load_pct[portNUM_PROCESSORS]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,306 @@
+// =============================
+// Streaming Filter Chain
+// =============================
+// The inner loops are written so that the Xtensa compiler can keep the
+// state in registers and turn every tap into a multiply-accumulate; when
+// the esp-dsp component is part of the build, the FIR dot product uses its
+// optimised kernel instead.
+
+#include <math.h>
+#include <string.h>
+#include "filter_chain.h"
+#if FILTER_CHAIN_HAVE_ESP_DSP
+#include "dsps_dotprod.h"
+#endif
+
+#define BIQUAD_STATE_LIMIT  ((int64_t)1 << 30)
+
+
+static inline int16_t sat16(int32_t v)
+{
+    if (v > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (v < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)v;
+}
+
+// =============================
+// Moving Average
+// =============================
+esp_err_t filter_stage_init_moving_avg(filter_stage_t *stage, int16_t *history, uint32_t len)
+{
+    if (!stage || !history || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    stage->type = FILTER_STAGE_MOVING_AVG;
+    stage->ma.hist = history;
+    stage->ma.len = len;
+    stage->ma.pos = 0;
+    stage->ma.sum = 0;
+    memset(history, 0, len * sizeof(int16_t));
+    return ESP_OK;
+}
+
+static void ma_process(filter_ma_t *ma, const int16_t *in, int16_t *out, size_t n)
+{
+    int32_t sum = ma->sum;
+    uint32_t pos = ma->pos;
+    const int32_t len = (int32_t)ma->len;
+    int16_t *hist = ma->hist;
+
+    for (size_t i = 0; i < n; i++) {
+        // Add the newest sample, drop the oldest: O(1) regardless of window length
+        int16_t x = in[i];
+        sum += x - hist[pos];
+        hist[pos] = x;
+        pos = (pos + 1 == (uint32_t)len) ? 0 : pos + 1;
+        out[i] = (int16_t)(sum / len);
+    }
+
+    ma->sum = sum;
+    ma->pos = pos;
+}
+
+// =============================
+// Biquad Cascade
+// =============================
+esp_err_t filter_biquad_design(filter_biquad_type_t type, float fs, float f0, float q, filter_biquad_t *out)
+{
+    if (!out || fs <= 0 || f0 <= 0 || f0 >= fs / 2 || q <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    double w0 = 2.0 * M_PI * f0 / fs;
+    double cw = cos(w0);
+    double alpha = sin(w0) / (2.0 * q);
+    double b0, b1, b2;
+    double a0 = 1.0 + alpha;
+    double a1 = -2.0 * cw;
+    double a2 = 1.0 - alpha;
+
+    switch (type) {
+    case FILTER_BIQUAD_LOWPASS:
+        b0 = (1.0 - cw) / 2.0;
+        b1 = 1.0 - cw;
+        b2 = (1.0 - cw) / 2.0;
+        break;
+    case FILTER_BIQUAD_HIGHPASS:
+        b0 = (1.0 + cw) / 2.0;
+        b1 = -(1.0 + cw);
+        b2 = (1.0 + cw) / 2.0;
+        break;
+    case FILTER_BIQUAD_BANDPASS:
+        b0 = alpha;
+        b1 = 0.0;
+        b2 = -alpha;
+        break;
+    case FILTER_BIQUAD_NOTCH:
+        b0 = 1.0;
+        b1 = -2.0 * cw;
+        b2 = 1.0;
+        break;
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const double scale = (double)(1 << FILTER_BIQUAD_COEFF_SHIFT);
+    memset(out, 0, sizeof(*out));
+    out->b0 = (int32_t)lround(b0 / a0 * scale);
+    out->b1 = (int32_t)lround(b1 / a0 * scale);
+    out->b2 = (int32_t)lround(b2 / a0 * scale);
+    out->a1 = (int32_t)lround(a1 / a0 * scale);
+    out->a2 = (int32_t)lround(a2 / a0 * scale);
+    return ESP_OK;
+}
+
+esp_err_t filter_stage_init_biquad(filter_stage_t *stage, filter_biquad_t *sections, size_t num_sections)
+{
+    if (!stage || !sections || num_sections == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    stage->type = FILTER_STAGE_BIQUAD;
+    stage->biquad.sections = sections;
+    stage->biquad.num_sections = num_sections;
+    for (size_t s = 0; s < num_sections; s++) {
+        sections[s].x1 = sections[s].x2 = 0;
+        sections[s].y1 = sections[s].y2 = 0;
+    }
+    return ESP_OK;
+}
+
+static void biquad_process(filter_biquad_t *bq, const int16_t *in, int16_t *out, size_t n)
+{
+    // Work on locals so the whole state lives in registers
+    const int64_t b0 = bq->b0, b1 = bq->b1, b2 = bq->b2;
+    const int64_t a1 = bq->a1, a2 = bq->a2;
+    int32_t x1 = bq->x1, x2 = bq->x2;
+    int32_t y1 = bq->y1, y2 = bq->y2;
+    const int64_t round = (int64_t)1 << (FILTER_BIQUAD_COEFF_SHIFT - 1);
+
+    for (size_t i = 0; i < n; i++) {
+        int32_t x0 = in[i];
+
+        // y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+        // Inputs are raised to the state precision so both halves share one accumulator
+        int64_t acc = (b0 * x0 + b1 * x1 + b2 * x2) * (1 << FILTER_BIQUAD_STATE_SHIFT);
+        acc -= a1 * y1 + a2 * y2;
+        int64_t y = (acc + round) >> FILTER_BIQUAD_COEFF_SHIFT;
+
+        // +/-2^30 is twice the int16 range: only a runaway design gets there,
+        // and clamping keeps a1 y1 + a2 y2 from overflowing the accumulator
+        int32_t y0 = (int32_t)(y > BIQUAD_STATE_LIMIT ? BIQUAD_STATE_LIMIT : (y < -BIQUAD_STATE_LIMIT ? -BIQUAD_STATE_LIMIT : y));
+
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = y0;
+        out[i] = sat16((y0 + (1 << (FILTER_BIQUAD_STATE_SHIFT - 1))) >> FILTER_BIQUAD_STATE_SHIFT);
+    }
+
+    bq->x1 = (int16_t)x1;
+    bq->x2 = (int16_t)x2;
+    bq->y1 = y1;
+    bq->y2 = y2;
+}
+
+// =============================
+// FIR
+// =============================
+esp_err_t filter_stage_init_fir(filter_stage_t *stage, const int16_t *coeffs, uint32_t taps, int16_t *delay)
+{
+    if (!stage || !coeffs || !delay || taps == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    stage->type = FILTER_STAGE_FIR;
+    stage->fir.coeffs = coeffs;
+    stage->fir.taps = taps;
+    stage->fir.delay = delay;
+    stage->fir.pos = 0;
+    memset(delay, 0, 2 * taps * sizeof(int16_t));
+    return ESP_OK;
+}
+
+esp_err_t filter_fir_set_coeffs(filter_stage_t *stage, const int16_t *coeffs)
+{
+    if (!stage || !coeffs || stage->type != FILTER_STAGE_FIR) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    stage->fir.coeffs = coeffs;
+    return ESP_OK;
+}
+
+// sum(c[k] * x[k]) in Q15, rounded and saturated
+static inline int16_t fir_dot(const int16_t *c, const int16_t *x, uint32_t taps)
+{
+#if FILTER_CHAIN_HAVE_ESP_DSP
+    // esp-dsp rounds up and does not saturate (see filter_chain.h)
+    if ((taps & 3) == 0) {
+        int16_t out;
+        dsps_dotprod_s16(c, x, &out, (int)taps, 0);
+        return out;
+    }
+#endif
+    int64_t acc0 = 0, acc1 = 0;
+    uint32_t k = 0;
+
+    // Two accumulators, four taps per iteration: independent MAC chains
+    for (; k + 4 <= taps; k += 4) {
+        acc0 += (int32_t)c[k + 0] * x[k + 0];
+        acc1 += (int32_t)c[k + 1] * x[k + 1];
+        acc0 += (int32_t)c[k + 2] * x[k + 2];
+        acc1 += (int32_t)c[k + 3] * x[k + 3];
+    }
+    for (; k < taps; k++) {
+        acc0 += (int32_t)c[k] * x[k];
+    }
+
+    int64_t acc = acc0 + acc1 + (1 << (FILTER_FIR_COEFF_SHIFT - 1));
+    acc >>= FILTER_FIR_COEFF_SHIFT;
+    return sat16(acc > INT32_MAX ? INT32_MAX : (acc < INT32_MIN ? INT32_MIN : (int32_t)acc));
+}
+
+static void fir_process(filter_fir_t *fir, const int16_t *in, int16_t *out, size_t n)
+{
+    const uint32_t taps = fir->taps;
+    int16_t *delay = fir->delay;
+    uint32_t pos = fir->pos;
+
+    for (size_t i = 0; i < n; i++) {
+        // Newest sample goes to delay[pos] and its mirror delay[pos + taps]; the
+        // window delay[pos .. pos + taps - 1] then holds x[n], x[n-1], ... in
+        // reverse-time order, contiguous, without any wrap-around check.
+        pos = (pos == 0) ? taps - 1 : pos - 1;
+        delay[pos] = in[i];
+        delay[pos + taps] = in[i];
+        out[i] = fir_dot(fir->coeffs, &delay[pos], taps);
+    }
+
+    fir->pos = pos;
+}
+
+// =============================
+// Chain
+// =============================
+// Every stage reads in[i] before it writes out[i], so in == out is in place.
+void filter_stage_process_to(filter_stage_t *stage, const int16_t *in, int16_t *out, size_t n)
+{
+    switch (stage->type) {
+    case FILTER_STAGE_MOVING_AVG:
+        ma_process(&stage->ma, in, out, n);
+        break;
+    case FILTER_STAGE_BIQUAD:
+        // First section reads the input, the rest work on out in place
+        for (size_t s = 0; s < stage->biquad.num_sections; s++) {
+            biquad_process(&stage->biquad.sections[s], s == 0 ? in : out, out, n);
+        }
+        break;
+    case FILTER_STAGE_FIR:
+        fir_process(&stage->fir, in, out, n);
+        break;
+    }
+}
+
+void filter_stage_process(filter_stage_t *stage, int16_t *block, size_t n)
+{
+    filter_stage_process_to(stage, block, block, n);
+}
+
+void filter_chain_process_to(filter_chain_t *chain, const int16_t *in, int16_t *out, size_t n)
+{
+    if (chain->num_stages == 0) {
+        if (out != in) {
+            memcpy(out, in, n * sizeof(int16_t));
+        }
+        return;
+    }
+    filter_stage_process_to(&chain->stages[0], in, out, n);
+    for (size_t s = 1; s < chain->num_stages; s++) {
+        filter_stage_process_to(&chain->stages[s], out, out, n);
+    }
+}
+
+void filter_chain_process(filter_chain_t *chain, int16_t *block, size_t n)
+{
+    filter_chain_process_to(chain, block, block, n);
+}
+
+void filter_chain_reset(filter_chain_t *chain)
+{
+    for (size_t s = 0; s < chain->num_stages; s++) {
+        filter_stage_t *stage = &chain->stages[s];
+        switch (stage->type) {
+        case FILTER_STAGE_MOVING_AVG:
+            filter_stage_init_moving_avg(stage, stage->ma.hist, stage->ma.len);
+            break;
+        case FILTER_STAGE_BIQUAD:
+            filter_stage_init_biquad(stage, stage->biquad.sections, stage->biquad.num_sections);
+            break;
+        case FILTER_STAGE_FIR:
+            filter_stage_init_fir(stage, stage->fir.coeffs, stage->fir.taps, stage->fir.delay);
+            break;
+        }
+    }
+}
@@ -0,0 +1,148 @@
+// =============================
+// Streaming Filter Chain
+// =============================
+// Block-based, incremental filters for int16 sample streams (mV). Every
+// stage keeps its own state between calls, so a stream can be fed in blocks
+// of any size and the result is identical to one long call.
+//
+//   - Moving average : running sum, O(1) per sample for any window length
+//   - Biquad cascade : fixed-point Direct Form I, coefficients in Q2.30
+//                      (notch for 50/60 Hz mains, low-pass, band-pass)
+//   - FIR            : Q15 coefficients, fixed at compile time or set at runtime.
+//                      With esp-dsp in the build, taps % 4 == 0 uses
+//                      dsps_dotprod_s16(), which rounds up (+0x7FFF before the
+//                      shift) and wraps instead of saturating; the portable
+//                      path rounds to nearest and saturates. Outputs differ by
+//                      at most 1 LSB while the result fits in int16.
+//
+// A chain runs its stages one after the other over the whole block, in place:
+//
+//   static int16_t ma_hist[8];
+//   static filter_biquad_t notch[1];
+//   static filter_stage_t stages[2];
+//   filter_stage_init_moving_avg(&stages[0], ma_hist, 8);
+//   filter_biquad_design(FILTER_BIQUAD_NOTCH, 20000, 50, 30, &notch[0]);
+//   filter_stage_init_biquad(&stages[1], notch, 1);
+//   filter_chain_t chain = { .stages = stages, .num_stages = 2 };
+//   filter_chain_process(&chain, block, n);
+//
+// The _to variants read the block from one buffer and write it to another,
+// e.g. straight from a ring span into a work buffer: the first stage does
+// the copy, the others run in place on the output.
+//
+// All state is caller-provided (static arrays); nothing is allocated.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FILTER_BIQUAD_COEFF_SHIFT   30      // Q2.30: range [-2, 2)
+#define FILTER_BIQUAD_STATE_SHIFT   14      // Extra fractional bits kept in the feedback path
+                                            // (a 50 Hz notch at 20 kHz, Q 30 amplifies their
+                                            // rounding noise about 2000 times)
+#define FILTER_FIR_COEFF_SHIFT      15      // Q15: range [-1, 1)
+
+// =============================
+// Moving Average
+// =============================
+typedef struct {
+    int16_t *hist;          // Last `len` input samples (caller storage)
+    uint32_t len;           // Window length
+    uint32_t pos;           // Oldest sample in hist
+    int32_t  sum;           // Sum of hist[]
+} filter_ma_t;
+
+// =============================
+// Biquad (one second-order section)
+// =============================
+typedef struct {
+    int32_t b0, b1, b2;     // Feed-forward, Q2.30
+    int32_t a1, a2;         // Feedback, Q2.30 (a0 normalised to 1)
+    int16_t x1, x2;         // Previous inputs
+    int32_t y1, y2;         // Previous outputs, Q.FILTER_BIQUAD_STATE_SHIFT, within +/-2^30
+} filter_biquad_t;
+
+typedef enum {
+    FILTER_BIQUAD_LOWPASS,
+    FILTER_BIQUAD_HIGHPASS,
+    FILTER_BIQUAD_BANDPASS,  // Constant 0 dB peak gain
+    FILTER_BIQUAD_NOTCH,
+} filter_biquad_type_t;
+
+typedef struct {
+    filter_biquad_t *sections;
+    size_t num_sections;
+} filter_biquad_cascade_t;
+
+// =============================
+// FIR
+// =============================
+typedef struct {
+    const int16_t *coeffs;  // taps coefficients, Q15
+    uint32_t taps;
+    int16_t *delay;         // 2 * taps samples (caller storage), mirrored so reads never wrap
+    uint32_t pos;
+} filter_fir_t;
+
+// =============================
+// Stages and Chain
+// =============================
+typedef enum {
+    FILTER_STAGE_MOVING_AVG,
+    FILTER_STAGE_BIQUAD,
+    FILTER_STAGE_FIR,
+} filter_stage_type_t;
+
+typedef struct {
+    filter_stage_type_t type;
+    union {
+        filter_ma_t ma;
+        filter_biquad_cascade_t biquad;
+        filter_fir_t fir;
+    };
+} filter_stage_t;
+
+typedef struct {
+    filter_stage_t *stages;
+    size_t num_stages;
+} filter_chain_t;
+
+// history: len samples; len >= 1
+esp_err_t filter_stage_init_moving_avg(filter_stage_t *stage, int16_t *history, uint32_t len);
+
+// sections: already designed (see filter_biquad_design); state is cleared
+esp_err_t filter_stage_init_biquad(filter_stage_t *stage, filter_biquad_t *sections, size_t num_sections);
+
+// delay: 2 * taps samples. coeffs may be a const table or updated later with filter_fir_set_coeffs().
+esp_err_t filter_stage_init_fir(filter_stage_t *stage, const int16_t *coeffs, uint32_t taps, int16_t *delay);
+
+// Swaps the coefficient table of a running FIR stage (same tap count).
+esp_err_t filter_fir_set_coeffs(filter_stage_t *stage, const int16_t *coeffs);
+
+// RBJ audio-EQ cookbook design, quantised to Q2.30. Runs once at init (uses float).
+// Returns ESP_ERR_INVALID_ARG unless 0 < f0 < fs / 2 and q > 0.
+esp_err_t filter_biquad_design(filter_biquad_type_t type, float fs, float f0, float q, filter_biquad_t *out);
+
+// Runs one stage over a block in place.
+void filter_stage_process(filter_stage_t *stage, int16_t *block, size_t n);
+
+// Runs every stage of the chain over a block in place.
+void filter_chain_process(filter_chain_t *chain, int16_t *block, size_t n);
+
+// Same, reading n samples from in and writing them to out (in == out is in
+// place; otherwise the two must not overlap). A chain without stages copies.
+void filter_stage_process_to(filter_stage_t *stage, const int16_t *in, int16_t *out, size_t n);
+void filter_chain_process_to(filter_chain_t *chain, const int16_t *in, int16_t *out, size_t n);
+
+// Clears the state of every stage (history, delay lines), keeps coefficients.
+void filter_chain_reset(filter_chain_t *chain);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,116 @@
+// =============================
+// Pipeline Timing: Jitter and Latency Histograms
+// =============================
+// Two questions decide whether the acquisition pipeline keeps up:
+//
+//   - jitter  : are samples taken when they should be? (inter-sample
+//               interval minus the nominal period)
+//   - latency : how long from the conversion of a sample until its filtered
+//               value reaches the output?
+//
+// Both are collected in fixed-bin histograms that live in caller-owned
+// structs: no allocation, constant time per value, cheap enough to run in
+// the acquisition task on every frame.
+//
+//   timing_hist_t lat;
+//   timing_hist_init(&lat, 0, 500);          // 0..16 ms in 500 us bins
+//   timing_hist_add(&lat, now - capture_us);
+//   timing_hist_percentile(&lat, 99);        // upper edge of the p99 bin
+//
+// Plain C, also built on the host (linux target).
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIMING_HIST_BINS   32
+
+// =============================
+// Histogram
+// =============================
+typedef struct {
+    int64_t  lo_us;                      // Lower edge of bins[0]
+    uint32_t bin_us;                     // Bin width
+    uint32_t bins[TIMING_HIST_BINS];
+    uint32_t below;                      // Values < lo_us
+    uint32_t above;                      // Values >= lo_us + TIMING_HIST_BINS * bin_us
+    uint32_t count;
+    int64_t  min_us;
+    int64_t  max_us;
+    int64_t  sum_us;
+} timing_hist_t;
+
+// Bins cover [lo_us, lo_us + TIMING_HIST_BINS * bin_us). bin_us 0 is taken as 1.
+void timing_hist_init(timing_hist_t *h, int64_t lo_us, uint32_t bin_us);
+
+// Empties the histogram, keeps the bin layout
+void timing_hist_reset(timing_hist_t *h);
+
+static inline void timing_hist_add(timing_hist_t *h, int64_t v_us)
+{
+    int64_t off = v_us - h->lo_us;
+    if (off < 0) {
+        h->below++;
+    } else if (off >= (int64_t)h->bin_us * TIMING_HIST_BINS) {
+        h->above++;
+    } else {
+        h->bins[off / h->bin_us]++;
+    }
+    if (h->count == 0 || v_us < h->min_us) {
+        h->min_us = v_us;
+    }
+    if (h->count == 0 || v_us > h->max_us) {
+        h->max_us = v_us;
+    }
+    h->count++;
+    h->sum_us += v_us;
+}
+
+// Value below which pct percent of the samples lie, rounded up to the edge
+// of its bin (so it never understates). Outside the binned range the exact
+// min / max is returned. 0 for an empty histogram.
+int64_t timing_hist_percentile(const timing_hist_t *h, uint32_t pct);
+
+int64_t timing_hist_mean(const timing_hist_t *h);
+
+// One line: "n=1000 mean 12 p50 10 p99 40 max 55 us". Returns buf.
+char *timing_hist_summary(const timing_hist_t *h, char *buf, size_t len);
+
+// =============================
+// Jitter Meter
+// =============================
+// Fed with the capture time of every sample (or of every frame, with the
+// frame period as nominal), it histograms interval - nominal. A perfect
+// clock puts everything in the bin that holds 0.
+typedef struct {
+    timing_hist_t hist;                  // interval - nominal_us, centred on 0
+    int64_t  nominal_us;
+    int64_t  last_us;
+    bool     started;
+    uint32_t gaps;                       // Intervals >= 1.5 x nominal (lost frames, stalls)
+} jitter_meter_t;
+
+void jitter_meter_init(jitter_meter_t *m, int64_t nominal_us, uint32_t bin_us);
+
+static inline void jitter_meter_add(jitter_meter_t *m, int64_t t_us)
+{
+    if (m->started) {
+        int64_t interval = t_us - m->last_us;
+        if (2 * interval >= 3 * m->nominal_us) {
+            m->gaps++;
+        }
+        timing_hist_add(&m->hist, interval - m->nominal_us);
+    }
+    m->last_us = t_us;
+    m->started = true;
+}
+
+#ifdef __cplusplus
+}
+#endif
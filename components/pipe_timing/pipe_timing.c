@@ -0,0 +1,80 @@
+// =============================
+// Pipeline Timing: Jitter and Latency Histograms
+// =============================
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "pipe_timing.h"
+
+
+void timing_hist_init(timing_hist_t *h, int64_t lo_us, uint32_t bin_us)
+{
+    h->lo_us = lo_us;
+    h->bin_us = bin_us ? bin_us : 1;
+    timing_hist_reset(h);
+}
+
+void timing_hist_reset(timing_hist_t *h)
+{
+    memset(h->bins, 0, sizeof(h->bins));
+    h->below = 0;
+    h->above = 0;
+    h->count = 0;
+    h->min_us = 0;
+    h->max_us = 0;
+    h->sum_us = 0;
+}
+
+int64_t timing_hist_percentile(const timing_hist_t *h, uint32_t pct)
+{
+    if (h->count == 0) {
+        return 0;
+    }
+    if (pct > 100) {
+        pct = 100;
+    }
+
+    // Rank of the requested sample, 1-based, rounded up
+    uint64_t rank = ((uint64_t)h->count * pct + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = h->below;
+    if (seen >= rank) {
+        return h->min_us;
+    }
+    for (int b = 0; b < TIMING_HIST_BINS; b++) {
+        seen += h->bins[b];
+        if (seen >= rank) {
+            int64_t edge = h->lo_us + (int64_t)(b + 1) * h->bin_us;
+            return (edge < h->max_us) ? edge : h->max_us;
+        }
+    }
+    return h->max_us;
+}
+
+int64_t timing_hist_mean(const timing_hist_t *h)
+{
+    return h->count ? h->sum_us / (int64_t)h->count : 0;
+}
+
+char *timing_hist_summary(const timing_hist_t *h, char *buf, size_t len)
+{
+    snprintf(buf, len, "n=%" PRIu32 " mean %" PRId64 " p50 %" PRId64 " p99 %" PRId64 " max %" PRId64 " us",
+             h->count, timing_hist_mean(h), timing_hist_percentile(h, 50),
+             timing_hist_percentile(h, 99), h->max_us);
+    return buf;
+}
+
+void jitter_meter_init(jitter_meter_t *m, int64_t nominal_us, uint32_t bin_us)
+{
+    // Centre the bins on zero deviation
+    bin_us = bin_us ? bin_us : 1;
+    timing_hist_init(&m->hist, -(int64_t)bin_us * TIMING_HIST_BINS / 2, bin_us);
+    m->nominal_us = nominal_us;
+    m->last_us = 0;
+    m->started = false;
+    m->gaps = 0;
+}
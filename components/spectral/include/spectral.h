@@ -0,0 +1,164 @@
+// =============================
+// Spectral Analysis
+// =============================
+// Turns a sample stream (mV) into a few numbers per analysis window, instead
+// of sending every sample on:
+//
+//   stream -> overlapping windows (N = 256/512/1024, new window every `hop`
+//             samples) -> mean removed, window table applied -> real FFT
+//             -> band powers, dominant frequency, RMS
+//
+// The FFT is a float radix-2 real FFT of N points, computed as an N/2-point
+// complex FFT plus a split step. The complex FFT uses esp-dsp when the
+// project includes it and a portable C version otherwise. esp-dsp gets a
+// static twiddle table from this component, so it allocates nothing either.
+//
+// A sliding DFT (spectral_sdft_t) tracks a handful of bins instead, updated
+// at every sample for a fixed cost per bin, without waiting for a window.
+//
+// Powers are in mV^2 and scaled so that the bins of one window add up to the
+// mean square of its (mean-free) samples: a sine of amplitude A contributes
+// A^2 / 2, whatever the window type or length.
+//
+//   static spectral_plan_t plan;                   // Shared by all channels
+//   static spectral_t chan;
+//   spectral_plan_init(&plan, 512, SPECTRAL_WINDOW_HANN);
+//   spectral_config_t cfg = { .sample_rate_hz = 256, .hop = 128, .num_bands = 4, .bands = { ... } };
+//   spectral_init(&chan, &plan, &cfg);
+//   n = spectral_process(&chan, block, len, results, 4);   // 0..4 finished windows
+//
+// All state is caller-provided (static structs); nothing is allocated.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SPECTRAL_MIN_N          256
+#define SPECTRAL_MAX_N          1024
+#define SPECTRAL_MAX_BANDS      8
+#define SPECTRAL_SDFT_MAX_BINS  8
+
+typedef enum {
+    SPECTRAL_WINDOW_RECT,
+    SPECTRAL_WINDOW_HANN,
+    SPECTRAL_WINDOW_HAMMING,
+    SPECTRAL_WINDOW_BLACKMAN,
+} spectral_window_t;
+
+// =============================
+// FFT Plan
+// =============================
+// Window and twiddle tables for one length, plus the work buffer the FFT
+// runs in. One plan serves any number of channels analysed from one task.
+typedef struct {
+    uint32_t n;                              // Window / FFT length
+    float    window[SPECTRAL_MAX_N];
+    float    twiddle[SPECTRAL_MAX_N];        // e^(-j 2 pi k / n), k < n/2, as (re, im) pairs
+    float    work[SPECTRAL_MAX_N];
+    float    power[SPECTRAL_MAX_N / 2 + 1];  // Last power spectrum, bins 0..n/2
+    float    power_scale;                    // |X|^2 -> mV^2 (one-sided, window energy corrected)
+    bool     use_esp_dsp;                    // Set by init when the build has esp-dsp; clear for the portable FFT
+} spectral_plan_t;
+
+// n: 256, 512 or 1024 (any power of two from SPECTRAL_MIN_N to SPECTRAL_MAX_N).
+// ESP_ERR_INVALID_STATE if esp-dsp was already set up with its own table.
+esp_err_t spectral_plan_init(spectral_plan_t *plan, uint32_t n, spectral_window_t window);
+
+// In-place real FFT of plan->n samples. Output is packed: data[0] = X[0],
+// data[1] = X[n/2] (both real), then data[2k], data[2k+1] = Re, Im of X[k]
+// for k = 1 .. n/2 - 1.
+void spectral_rfft(spectral_plan_t *plan, float *data);
+
+// =============================
+// Windowed Analysis
+// =============================
+typedef struct {
+    float lo_hz;                             // Inclusive
+    float hi_hz;                             // Exclusive
+} spectral_band_t;
+
+typedef struct {
+    float    sample_rate_hz;
+    uint32_t hop;                            // Samples between window starts, 1 .. n
+    uint32_t num_bands;
+    spectral_band_t bands[SPECTRAL_MAX_BANDS];
+} spectral_config_t;
+
+typedef struct {
+    uint32_t seq;                            // Window number
+    uint64_t end_sample;                     // Stream index just past the window's last sample
+    float    mean;                           // mV (removed before the FFT)
+    float    rms;                            // mV, of the mean-free samples
+    float    dominant_hz;                    // Strongest bin above DC, interpolated
+    float    total_power;                    // mV^2, all bins above DC
+    float    band_power[SPECTRAL_MAX_BANDS]; // mV^2 per configured band
+} spectral_result_t;
+
+typedef struct {
+    spectral_plan_t  *plan;
+    spectral_config_t cfg;
+    uint32_t band_lo[SPECTRAL_MAX_BANDS];    // Bin ranges of the bands
+    uint32_t band_hi[SPECTRAL_MAX_BANDS];
+    int16_t  hist[SPECTRAL_MAX_N];           // Last n samples (ring)
+    uint32_t pos;                            // Next write position in hist
+    uint32_t until_next;                     // Samples until the next window is due
+    uint32_t seq;
+    uint64_t total;                          // Samples consumed
+} spectral_t;
+
+esp_err_t spectral_init(spectral_t *sp, spectral_plan_t *plan, const spectral_config_t *cfg);
+
+// Consumes n samples; writes one result per completed window (at most
+// max_results, further windows in this call are skipped) and returns how
+// many were written. The first window completes after n samples, then one
+// every hop samples.
+size_t spectral_process(spectral_t *sp, const int16_t *x, size_t n, spectral_result_t *results, size_t max_results);
+
+// Analyses one window directly (n samples of the plan's length)
+void spectral_analyze(spectral_t *sp, const int16_t *window_samples, spectral_result_t *res);
+
+// =============================
+// Sliding DFT
+// =============================
+// Tracks single bins of an n-point DFT over the last n samples (rectangular
+// window), updated with every sample:
+//
+//   S_k <- (S_k + x_new - r^n x_old) * r e^(j 2 pi k / n)
+//
+// r slightly below 1 keeps float rounding from accumulating. Frequencies are
+// rounded to the nearest bin of fs / n.
+typedef struct {
+    uint32_t n;                              // Any length up to SPECTRAL_MAX_N
+    uint32_t num_bins;
+    uint32_t bin[SPECTRAL_SDFT_MAX_BINS];
+    float    re[SPECTRAL_SDFT_MAX_BINS];
+    float    im[SPECTRAL_SDFT_MAX_BINS];
+    float    rot_re[SPECTRAL_SDFT_MAX_BINS]; // r e^(j 2 pi k / n)
+    float    rot_im[SPECTRAL_SDFT_MAX_BINS];
+    float    r_n;                            // r^n
+    int16_t  hist[SPECTRAL_MAX_N];
+    uint32_t pos;
+    float    sample_rate_hz;
+} spectral_sdft_t;
+
+esp_err_t spectral_sdft_init(spectral_sdft_t *sd, float sample_rate_hz, uint32_t n,
+                             const float *freqs_hz, uint32_t num_bins);
+
+void spectral_sdft_process(spectral_sdft_t *sd, const int16_t *x, size_t n);
+
+// Power of tracked bin i over the last n samples, mV^2 (same scale as the band powers)
+float spectral_sdft_power(const spectral_sdft_t *sd, uint32_t i);
+
+// Centre frequency of tracked bin i
+float spectral_sdft_freq(const spectral_sdft_t *sd, uint32_t i);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,349 @@
+// =============================
+// Spectral Analysis
+// =============================
+// Real FFT of n points = complex FFT of n/2 points (even samples as real
+// part, odd samples as imaginary part) + one split pass that separates the
+// two halves again. This halves the work of a plain complex FFT.
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+#include "spectral.h"
+#if SPECTRAL_HAVE_ESP_DSP
+#include "dsps_fft2r.h"
+#include "dsps_bit_rev.h"
+#endif
+
+#define SPECTRAL_SDFT_R     0.999999f   // Damping of the sliding DFT
+
+
+#if SPECTRAL_HAVE_ESP_DSP
+#if CONFIG_DSP_MAX_FFT_SIZE < SPECTRAL_MAX_N / 2
+#error "CONFIG_DSP_MAX_FFT_SIZE is below the longest complex FFT (SPECTRAL_MAX_N / 2)"
+#endif
+// esp-dsp's twiddles, in its own (bit-reversed) order so the plan's table
+// cannot serve; one float per point of the longest complex FFT. Handing it to
+// dsps_fft2r_init_fc32() keeps esp-dsp from allocating its tables.
+static float dsp_table[SPECTRAL_MAX_N / 2] __attribute__((aligned(16)));
+static bool dsp_ready;
+#endif
+
+// =============================
+// FFT Plan
+// =============================
+esp_err_t spectral_plan_init(spectral_plan_t *plan, uint32_t n, spectral_window_t window)
+{
+    if (!plan || n < SPECTRAL_MIN_N || n > SPECTRAL_MAX_N || (n & (n - 1)) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(plan, 0, sizeof(*plan));
+    plan->n = n;
+
+    // --- 1. Window table (periodic form: overlapping windows add up evenly) ---
+    double energy = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        double x = 2.0 * M_PI * i / n;
+        double w;
+        switch (window) {
+        case SPECTRAL_WINDOW_HANN:
+            w = 0.5 - 0.5 * cos(x);
+            break;
+        case SPECTRAL_WINDOW_HAMMING:
+            w = 0.54 - 0.46 * cos(x);
+            break;
+        case SPECTRAL_WINDOW_BLACKMAN:
+            w = 0.42 - 0.5 * cos(x) + 0.08 * cos(2 * x);
+            break;
+        case SPECTRAL_WINDOW_RECT:
+            w = 1.0;
+            break;
+        default:
+            return ESP_ERR_INVALID_ARG;
+        }
+        plan->window[i] = (float)w;
+        energy += w * w;
+    }
+    // Parseval: sum |X|^2 = n * sum (w x)^2, and sum (w x)^2 ~ energy * mean(x^2)
+    plan->power_scale = (float)(1.0 / (n * energy));
+
+    // --- 2. Twiddles W_n^k for the split pass; every 2nd one serves the n/2 FFT ---
+    for (uint32_t k = 0; k < n / 2; k++) {
+        plan->twiddle[2 * k] = (float)cos(2.0 * M_PI * k / n);
+        plan->twiddle[2 * k + 1] = (float)-sin(2.0 * M_PI * k / n);
+    }
+
+#if SPECTRAL_HAVE_ESP_DSP
+    if (!dsp_ready) {
+        if (dsps_fft2r_init_fc32(dsp_table, SPECTRAL_MAX_N / 2) != ESP_OK) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        dsp_ready = true;
+    }
+    plan->use_esp_dsp = true;
+#endif
+    return ESP_OK;
+}
+
+// In-place radix-2 complex FFT of m points (interleaved re, im). tw holds
+// W_2m^k, so a span of len uses every (2m / len)-th entry.
+static void cfft(const float *tw, float *d, uint32_t m)
+{
+    // --- Bit-reversed order ---
+    for (uint32_t i = 1, j = 0; i < m; i++) {
+        uint32_t bit = m >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j |= bit;
+        if (i < j) {
+            float tr = d[2 * i], ti = d[2 * i + 1];
+            d[2 * i] = d[2 * j];
+            d[2 * i + 1] = d[2 * j + 1];
+            d[2 * j] = tr;
+            d[2 * j + 1] = ti;
+        }
+    }
+
+    // --- Butterflies, span doubling every pass ---
+    for (uint32_t len = 2, step = m; len <= m; len <<= 1, step >>= 1) {
+        const uint32_t half = len / 2;
+        for (uint32_t j = 0; j < half; j++) {
+            const float wr = tw[2 * j * step], wi = tw[2 * j * step + 1];
+            for (uint32_t i = j; i < m; i += len) {
+                float *a = &d[2 * i];
+                float *b = &d[2 * (i + half)];
+                float tr = wr * b[0] - wi * b[1];
+                float ti = wr * b[1] + wi * b[0];
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+void spectral_rfft(spectral_plan_t *plan, float *data)
+{
+    const uint32_t n = plan->n;
+    const uint32_t m = n / 2;
+    const float *tw = plan->twiddle;
+
+    // --- 1. n/2-point complex FFT of z[k] = x[2k] + j x[2k+1] ---
+#if SPECTRAL_HAVE_ESP_DSP
+    if (plan->use_esp_dsp) {
+        dsps_fft2r_fc32(data, (int)m);
+        dsps_bit_rev_fc32(data, (int)m);
+    } else
+#endif
+    {
+        cfft(tw, data, m);
+    }
+
+    // --- 2. Split: X[k] = E[k] + W^k O[k], E/O from Z[k] and conj(Z[m-k]) ---
+    float z0r = data[0], z0i = data[1];
+    data[0] = z0r + z0i;                    // X[0]
+    data[1] = z0r - z0i;                    // X[n/2]
+    for (uint32_t k = 1; k <= m / 2; k++) {
+        float *a = &data[2 * k];
+        float *b = &data[2 * (m - k)];
+        float er = 0.5f * (a[0] + b[0]), ei = 0.5f * (a[1] - b[1]);
+        float or_ = 0.5f * (a[1] + b[1]), oi = -0.5f * (a[0] - b[0]);
+        float wr = tw[2 * k], wi = tw[2 * k + 1];
+        float tr = wr * or_ - wi * oi;
+        float ti = wr * oi + wi * or_;
+        // X[m-k] = conj(E[k] - W^k O[k])
+        b[0] = er - tr;
+        b[1] = -(ei - ti);
+        a[0] = er + tr;
+        a[1] = ei + ti;
+    }
+}
+
+// =============================
+// Windowed Analysis
+// =============================
+esp_err_t spectral_init(spectral_t *sp, spectral_plan_t *plan, const spectral_config_t *cfg)
+{
+    if (!sp || !plan || !cfg || plan->n == 0 || cfg->sample_rate_hz <= 0 || cfg->hop == 0 ||
+        cfg->hop > plan->n || cfg->num_bands > SPECTRAL_MAX_BANDS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(sp, 0, sizeof(*sp));
+    sp->plan = plan;
+    sp->cfg = *cfg;
+    sp->until_next = plan->n;
+
+    // Bin k covers [k - 1/2, k + 1/2) * fs / n; a band takes the bins whose centre it contains
+    const float bin_hz = cfg->sample_rate_hz / plan->n;
+    for (uint32_t b = 0; b < cfg->num_bands; b++) {
+        const spectral_band_t *band = &cfg->bands[b];
+        if (band->hi_hz <= band->lo_hz || band->lo_hz < 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        uint32_t lo = (uint32_t)ceilf(band->lo_hz / bin_hz);
+        uint32_t hi = (uint32_t)ceilf(band->hi_hz / bin_hz);
+        sp->band_lo[b] = lo < 1 ? 1 : lo;                     // DC is removed
+        sp->band_hi[b] = hi > plan->n / 2 + 1 ? plan->n / 2 + 1 : hi;
+    }
+    return ESP_OK;
+}
+
+// Window from the history ring, oldest sample first
+static void analyze_ring(spectral_t *sp, spectral_result_t *res)
+{
+    spectral_plan_t *plan = sp->plan;
+    const uint32_t n = plan->n;
+    float *w = plan->work;
+
+    // --- 1. Mean and RMS, then mean-free samples times the window table ---
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        sum += sp->hist[i];
+    }
+    const float mean = (float)sum / n;
+    float sq = 0;
+    for (uint32_t i = 0, j = sp->pos; i < n; i++) {
+        float v = sp->hist[j] - mean;
+        sq += v * v;
+        w[i] = v * plan->window[i];
+        j = (j + 1 == n) ? 0 : j + 1;
+    }
+    res->mean = mean;
+    res->rms = sqrtf(sq / n);
+
+    // --- 2. FFT and one-sided power spectrum in mV^2 ---
+    spectral_rfft(plan, w);
+    float *p = plan->power;
+    p[0] = w[0] * w[0] * plan->power_scale;
+    p[n / 2] = w[1] * w[1] * plan->power_scale;
+    for (uint32_t k = 1; k < n / 2; k++) {
+        p[k] = 2.0f * (w[2 * k] * w[2 * k] + w[2 * k + 1] * w[2 * k + 1]) * plan->power_scale;
+    }
+
+    // --- 3. Total, strongest bin (parabolic peak interpolation) and bands ---
+    float total = 0;
+    uint32_t peak = 1;
+    for (uint32_t k = 1; k <= n / 2; k++) {
+        total += p[k];
+        if (p[k] > p[peak]) {
+            peak = k;
+        }
+    }
+    float offset = 0;
+    if (peak > 1 && peak < n / 2) {
+        float a = sqrtf(p[peak - 1]), b = sqrtf(p[peak]), c = sqrtf(p[peak + 1]);
+        float den = a - 2 * b + c;
+        if (den < 0) {
+            offset = 0.5f * (a - c) / den;
+        }
+    }
+    res->total_power = total;
+    res->dominant_hz = (peak + offset) * sp->cfg.sample_rate_hz / n;
+    for (uint32_t b = 0; b < sp->cfg.num_bands; b++) {
+        float bp = 0;
+        for (uint32_t k = sp->band_lo[b]; k < sp->band_hi[b]; k++) {
+            bp += p[k];
+        }
+        res->band_power[b] = bp;
+    }
+    res->seq = sp->seq++;
+    res->end_sample = sp->total;
+}
+
+size_t spectral_process(spectral_t *sp, const int16_t *x, size_t n, spectral_result_t *results, size_t max_results)
+{
+    const uint32_t len = sp->plan->n;
+    size_t produced = 0;
+
+    while (n > 0) {
+        // Copy up to the next window boundary into the ring
+        size_t take = n < sp->until_next ? n : sp->until_next;
+        for (size_t i = 0; i < take; i++) {
+            sp->hist[sp->pos] = x[i];
+            sp->pos = (sp->pos + 1 == len) ? 0 : sp->pos + 1;
+        }
+        sp->total += take;
+        sp->until_next -= take;
+        x += take;
+        n -= take;
+
+        if (sp->until_next == 0) {
+            sp->until_next = sp->cfg.hop;
+            if (produced < max_results) {
+                analyze_ring(sp, &results[produced++]);
+            } else {
+                sp->seq++;      // Skipped: keeps the window numbering on the stream
+            }
+        }
+    }
+    return produced;
+}
+
+void spectral_analyze(spectral_t *sp, const int16_t *window_samples, spectral_result_t *res)
+{
+    memcpy(sp->hist, window_samples, sp->plan->n * sizeof(int16_t));
+    sp->pos = 0;
+    sp->total += sp->plan->n;
+    analyze_ring(sp, res);
+}
+
+// =============================
+// Sliding DFT
+// =============================
+esp_err_t spectral_sdft_init(spectral_sdft_t *sd, float sample_rate_hz, uint32_t n,
+                             const float *freqs_hz, uint32_t num_bins)
+{
+    if (!sd || sample_rate_hz <= 0 || n < 2 || n > SPECTRAL_MAX_N || num_bins > SPECTRAL_SDFT_MAX_BINS ||
+        (num_bins > 0 && !freqs_hz)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(sd, 0, sizeof(*sd));
+    sd->n = n;
+    sd->num_bins = num_bins;
+    sd->sample_rate_hz = sample_rate_hz;
+    sd->r_n = powf(SPECTRAL_SDFT_R, (float)n);
+    for (uint32_t i = 0; i < num_bins; i++) {
+        long k = lroundf(freqs_hz[i] * n / sample_rate_hz);
+        if (k < 1 || k >= (long)(n + 1) / 2) {
+            return ESP_ERR_INVALID_ARG;     // DC and Nyquist are not tracked
+        }
+        sd->bin[i] = (uint32_t)k;
+        sd->rot_re[i] = SPECTRAL_SDFT_R * (float)cos(2.0 * M_PI * k / n);
+        sd->rot_im[i] = SPECTRAL_SDFT_R * (float)sin(2.0 * M_PI * k / n);
+    }
+    return ESP_OK;
+}
+
+void spectral_sdft_process(spectral_sdft_t *sd, const int16_t *x, size_t n)
+{
+    const uint32_t len = sd->n;
+    const uint32_t bins = sd->num_bins;
+    uint32_t pos = sd->pos;
+
+    for (size_t i = 0; i < n; i++) {
+        // Newest sample in, the one from n samples ago out
+        float delta = x[i] - sd->r_n * sd->hist[pos];
+        sd->hist[pos] = x[i];
+        pos = (pos + 1 == len) ? 0 : pos + 1;
+
+        for (uint32_t b = 0; b < bins; b++) {
+            float re = sd->re[b] + delta;
+            float im = sd->im[b];
+            sd->re[b] = re * sd->rot_re[b] - im * sd->rot_im[b];
+            sd->im[b] = re * sd->rot_im[b] + im * sd->rot_re[b];
+        }
+    }
+    sd->pos = pos;
+}
+
+float spectral_sdft_power(const spectral_sdft_t *sd, uint32_t i)
+{
+    const float n = (float)sd->n;
+    return 2.0f * (sd->re[i] * sd->re[i] + sd->im[i] * sd->im[i]) / (n * n);
+}
+
+float spectral_sdft_freq(const spectral_sdft_t *sd, uint32_t i)
+{
+    return sd->bin[i] * sd->sample_rate_hz / sd->n;
+}
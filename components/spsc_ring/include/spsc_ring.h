@@ -0,0 +1,91 @@
+// =============================
+// Lock-Free Single-Producer / Single-Consumer Sample Ring
+// =============================
+// Replaces the old `adc_buffer[] + volatile buffer_index` pair. Exactly one
+// task may push and exactly one task may read; no locks are needed because
+// each side only ever writes its own index:
+//
+//   producer: writes samples, then publishes `head` (release)
+//   consumer: loads `head` (acquire), reads samples, then publishes `tail` (release)
+//
+// head and tail are free-running counters; head - tail is the fill level.
+// The capacity must be a power of two so that `index & mask` replaces `%`.
+//
+// Bulk access works on contiguous spans straight inside the storage array:
+//
+//   const int16_t *span;
+//   size_t n = spsc_ring_peek_n(&ring, &span, 64);   // n <= 64, no copy
+//   process(span, n);
+//   spsc_ring_consume_n(&ring, n);
+//
+// A span never wraps around the end of the storage, so a full read may take
+// two peek/consume rounds. Draining always ends on an empty peek, so peeks
+// are not underruns; the consumer calls spsc_ring_poll() once when it wakes
+// up for data, and an empty ring there is one.
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    // Producer side
+    atomic_uint head;           // Total samples pushed
+    atomic_uint overruns;       // Samples rejected because the ring was full
+    atomic_uint high_water;     // Highest fill level seen by the producer
+    // Consumer side
+    atomic_uint tail;           // Total samples consumed
+    atomic_uint underruns;      // poll() calls that found the ring empty
+    // Fixed after init
+    int16_t *buf;
+    uint32_t mask;              // capacity - 1
+} spsc_ring_t;
+
+typedef struct {
+    uint32_t capacity;
+    uint32_t fill;              // Samples currently readable
+    uint32_t high_water;
+    uint32_t overruns;
+    uint32_t underruns;
+    uint32_t pushed;            // Total samples accepted (wraps at 2^32)
+} spsc_ring_stats_t;
+
+// Storage is owned by the caller (typically a static array).
+// Returns ESP_ERR_INVALID_ARG unless capacity is a power of two >= 2.
+esp_err_t spsc_ring_init(spsc_ring_t *ring, int16_t *storage, size_t capacity);
+
+// =============================
+// Producer
+// =============================
+// Copies up to n samples in. Samples that do not fit are dropped (the
+// consumer owns the old data) and counted as overruns. Returns samples stored.
+size_t spsc_ring_push_n(spsc_ring_t *ring, const int16_t *src, size_t n);
+
+// =============================
+// Consumer
+// =============================
+// Points *span at up to n readable samples without copying and returns how
+// many. The span stays valid until spsc_ring_consume_n().
+size_t spsc_ring_peek_n(spsc_ring_t *ring, const int16_t **span, size_t n);
+
+// Releases n samples previously returned by spsc_ring_peek_n().
+void spsc_ring_consume_n(spsc_ring_t *ring, size_t n);
+
+// Readable samples when the consumer wakes up for data; an empty ring counts
+// as an underrun.
+size_t spsc_ring_poll(spsc_ring_t *ring);
+
+// Readable samples right now (may be called from either side)
+size_t spsc_ring_available(spsc_ring_t *ring);
+
+void spsc_ring_get_stats(spsc_ring_t *ring, spsc_ring_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,114 @@
+// =============================
+// Lock-Free SPSC Sample Ring
+// =============================
+
+#include <string.h>
+#include "spsc_ring.h"
+
+
+esp_err_t spsc_ring_init(spsc_ring_t *ring, int16_t *storage, size_t capacity)
+{
+    if (!ring || !storage || capacity < 2 || (capacity & (capacity - 1)) != 0 ||
+        capacity > UINT32_MAX / 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ring->buf = storage;
+    ring->mask = (uint32_t)capacity - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->overruns, 0);
+    atomic_init(&ring->underruns, 0);
+    atomic_init(&ring->high_water, 0);
+    return ESP_OK;
+}
+
+size_t spsc_ring_push_n(spsc_ring_t *ring, const int16_t *src, size_t n)
+{
+    // Our own index needs no ordering; the consumer's index must be acquired
+    // so we never overwrite a slot it is still reading.
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    uint32_t capacity = ring->mask + 1;
+    uint32_t space = capacity - (head - tail);
+
+    size_t todo = (n < space) ? n : space;
+    if (todo < n) {
+        atomic_fetch_add_explicit(&ring->overruns, (uint32_t)(n - todo), memory_order_relaxed);
+    }
+
+    // Copy in at most two contiguous pieces: up to the end of storage, then from the start
+    uint32_t start = head & ring->mask;
+    size_t first = capacity - start;
+    if (first > todo) {
+        first = todo;
+    }
+    memcpy(&ring->buf[start], src, first * sizeof(int16_t));
+    memcpy(&ring->buf[0], src + first, (todo - first) * sizeof(int16_t));
+
+    // Publish: the samples above become visible before the new head
+    atomic_store_explicit(&ring->head, head + (uint32_t)todo, memory_order_release);
+
+    uint32_t fill = (head + (uint32_t)todo) - tail;
+    if (fill > atomic_load_explicit(&ring->high_water, memory_order_relaxed)) {
+        atomic_store_explicit(&ring->high_water, fill, memory_order_relaxed);
+    }
+    return todo;
+}
+
+size_t spsc_ring_peek_n(spsc_ring_t *ring, const int16_t **span, size_t n)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t avail = head - tail;
+
+    if (n > avail) {
+        n = avail;
+    }
+
+    // Never hand out a span that wraps past the end of storage
+    uint32_t start = tail & ring->mask;
+    size_t contiguous = (size_t)ring->mask + 1 - start;
+    if (n > contiguous) {
+        n = contiguous;
+    }
+
+    *span = &ring->buf[start];
+    return n;
+}
+
+void spsc_ring_consume_n(spsc_ring_t *ring, size_t n)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    // Release: our reads of the span complete before the producer may reuse it
+    atomic_store_explicit(&ring->tail, tail + (uint32_t)n, memory_order_release);
+}
+
+size_t spsc_ring_available(spsc_ring_t *ring)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head - tail;
+}
+
+size_t spsc_ring_poll(spsc_ring_t *ring)
+{
+    size_t avail = spsc_ring_available(ring);
+    if (avail == 0) {
+        atomic_fetch_add_explicit(&ring->underruns, 1, memory_order_relaxed);
+    }
+    return avail;
+}
+
+void spsc_ring_get_stats(spsc_ring_t *ring, spsc_ring_stats_t *stats)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    stats->capacity = ring->mask + 1;
+    stats->fill = head - tail;
+    stats->pushed = head;
+    stats->high_water = atomic_load_explicit(&ring->high_water, memory_order_relaxed);
+    stats->overruns = atomic_load_explicit(&ring->overruns, memory_order_relaxed);
+    stats->underruns = atomic_load_explicit(&ring->underruns, memory_order_relaxed);
+}
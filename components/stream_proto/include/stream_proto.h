@@ -0,0 +1,140 @@
+// =============================
+// Binary Sample Streaming Protocol
+// =============================
+// Replaces one text line per sample with compact binary frames:
+//
+//   wire:    0x00 | COBS( header | payload | CRC16 ) | 0x00
+//
+//   header (13 bytes, little-endian):
+//     u8  type        STREAM_FRAME_SAMPLES or STREAM_FRAME_FEATURES
+//     u8  encoding    stream_encoding_t
+//     u8  channel     Source channel id
+//     u16 count       Samples (or feature values) in this frame
+//     u32 seq         Frame sequence number (gaps = lost frames)
+//     u32 timestamp   Capture time of the first sample (us, wraps after ~71 min)
+//
+//   payload, depending on encoding:
+//     RAW16    : count x int16                                   (2 bytes/sample)
+//     PACKED12 : two 12-bit values in 3 bytes, values 0..4095   (1.5 bytes/sample)
+//     DELTA8   : first sample as int16, then int8 deltas; a delta outside
+//                -127..127 is sent as 0x80 followed by the full int16 (~1 byte/sample)
+//     FLOAT32  : count x IEEE-754 float; feature frames only (see below)
+//
+//   Feature frames carry values computed on the device (e.g. the band powers
+//   of an analysis window) instead of samples. They share the header, CRC
+//   and sequence numbers with sample frames; the meaning of each value is
+//   fixed by the firmware configuration.
+//
+//   CRC16: CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over header + payload.
+//
+// COBS removes every 0x00 from the frame, so 0x00 only ever marks a frame
+// boundary: a receiver can join the stream at any byte and resynchronise
+// on the next delimiter. The leading delimiter also isolates any stray text
+// (e.g. a log line) written to the same UART between two frames.
+//
+// This file builds on the target and on the host (linux target); the same
+// encoder/decoder is used on both ends.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STREAM_FRAME_SAMPLES        0x01    // Frame type: sample block
+#define STREAM_FRAME_FEATURES       0x02    // Frame type: feature vector
+
+#define STREAM_HEADER_SIZE          13
+#define STREAM_CRC_SIZE             2
+#define STREAM_MAX_SAMPLES          512     // Per frame
+#define STREAM_MAX_FEATURES         64      // Values per feature frame
+
+// Worst case (RAW16) frame plus COBS overhead and both delimiters
+#define STREAM_RAW_MAX_SIZE         (STREAM_HEADER_SIZE + 2 * STREAM_MAX_SAMPLES + STREAM_CRC_SIZE)
+#define STREAM_WIRE_MAX_SIZE        (STREAM_RAW_MAX_SIZE + STREAM_RAW_MAX_SIZE / 254 + 1 + 2)
+
+typedef enum {
+    STREAM_ENC_RAW16    = 0,
+    STREAM_ENC_DELTA8   = 1,
+    STREAM_ENC_PACKED12 = 2,
+    STREAM_ENC_FLOAT32  = 3,        // Feature frames
+    STREAM_ENC_AUTO     = 0xFF,     // Encoder only: pick the smallest of the above
+} stream_encoding_t;
+
+typedef struct {
+    uint8_t  encoding;      // stream_encoding_t
+    uint8_t  channel;
+    uint16_t count;
+    uint32_t seq;
+    uint32_t timestamp_us;
+} stream_frame_hdr_t;
+
+// =============================
+// Encoder
+// =============================
+// Encodes one frame, including both 0x00 delimiters, into out (at least
+// STREAM_WIRE_MAX_SIZE bytes for a full frame). hdr->encoding may be
+// STREAM_ENC_AUTO; the encoding actually used is written back to it.
+esp_err_t stream_proto_encode(stream_frame_hdr_t *hdr, const int16_t *samples,
+                              uint8_t *out, size_t out_size, size_t *out_len);
+
+// Encodes a feature frame of hdr->count (<= STREAM_MAX_FEATURES) values;
+// hdr->encoding is set to STREAM_ENC_FLOAT32.
+esp_err_t stream_proto_encode_features(stream_frame_hdr_t *hdr, const float *values,
+                                       uint8_t *out, size_t out_size, size_t *out_len);
+
+// =============================
+// Decoder
+// =============================
+// Decodes one COBS frame (delimiters already stripped). samples must hold
+// STREAM_MAX_SAMPLES values. Returns ESP_ERR_INVALID_CRC on a corrupted frame,
+// ESP_ERR_INVALID_SIZE on a malformed one and ESP_ERR_NOT_SUPPORTED on a
+// valid frame of another type.
+esp_err_t stream_proto_decode(const uint8_t *frame, size_t len, stream_frame_hdr_t *hdr, int16_t *samples);
+
+// Same for feature frames; values must hold STREAM_MAX_FEATURES values.
+esp_err_t stream_proto_decode_features(const uint8_t *frame, size_t len, stream_frame_hdr_t *hdr, float *values);
+
+typedef void (*stream_frame_cb_t)(const stream_frame_hdr_t *hdr, const int16_t *samples, void *ctx);
+typedef void (*stream_features_cb_t)(const stream_frame_hdr_t *hdr, const float *values, void *ctx);
+
+// Byte-stream decoder: accepts arbitrary chunks, calls on_frame for every
+// valid sample frame and on_features (optional, set after init) for every
+// valid feature frame.
+typedef struct {
+    uint8_t  buf[STREAM_WIRE_MAX_SIZE];
+    size_t   len;
+    int16_t  samples[STREAM_MAX_SAMPLES];
+    float    values[STREAM_MAX_FEATURES];
+    stream_frame_cb_t on_frame;
+    stream_features_cb_t on_features;
+    void    *ctx;
+    // Statistics
+    uint32_t frames;        // Valid frames delivered (both types)
+    uint32_t feature_frames;
+    uint32_t bad_frames;    // CRC or format errors (includes stray text between frames)
+    uint32_t lost_frames;   // Gaps in the sequence numbers
+    uint32_t resyncs;       // Sequence went backwards (sender restarted): re-anchored, not counted as lost
+    uint32_t next_seq;
+    uint64_t bytes;         // Bytes fed
+    uint64_t samples_out;   // Samples delivered
+} stream_decoder_t;
+
+void stream_decoder_init(stream_decoder_t *dec, stream_frame_cb_t on_frame, void *ctx);
+void stream_decoder_feed(stream_decoder_t *dec, const uint8_t *data, size_t len);
+
+// =============================
+// Helpers (exposed for tests and tools)
+// =============================
+uint16_t stream_crc16(const uint8_t *data, size_t len);
+size_t stream_cobs_encode(const uint8_t *in, size_t len, uint8_t *out);
+// Returns the decoded length, or 0 if the input is not valid COBS or does not fit out_size.
+size_t stream_cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t out_size);
+
+#ifdef __cplusplus
+}
+#endif
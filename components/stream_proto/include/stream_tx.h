@@ -0,0 +1,65 @@
+// =============================
+// Binary Stream Transmit Task
+// =============================
+// Producers hand sample blocks to stream_tx_submit() and feature vectors to
+// stream_tx_submit_features(); neither ever blocks: if the queue is full the
+// block is dropped, counted, and shows up at the receiver as a gap in the
+// sequence numbers. A dedicated low-priority task
+// encodes the blocks (stream_proto.h) and writes them to the output, so a
+// slow UART can never stall acquisition or filtering.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "stream_proto.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STREAM_TX_BLOCK_SAMPLES     256     // Largest block accepted by stream_tx_submit()
+
+typedef struct stream_tx stream_tx_t;
+
+// Output sink; returns the number of bytes written
+typedef size_t (*stream_tx_write_fn_t)(const uint8_t *data, size_t len, void *ctx);
+
+typedef struct {
+    stream_tx_write_fn_t write;     // NULL = fwrite() to stdout (console UART)
+    void    *write_ctx;
+    uint8_t  encoding;              // stream_encoding_t, usually STREAM_ENC_AUTO
+    uint32_t queue_depth;           // Blocks buffered between producers and the task
+    uint32_t task_priority;         // Keep below acquisition and filtering
+    uint32_t task_stack;            // Bytes; encoding needs ~2 KB of scratch
+} stream_tx_config_t;
+
+typedef struct {
+    uint32_t frames;                // Frames written (both types)
+    uint32_t feature_frames;        // Feature frames among them
+    uint32_t dropped_blocks;        // Blocks rejected because the queue was full
+    uint64_t samples;               // Samples written
+    uint64_t bytes;                 // Encoded bytes written (delimiters included)
+} stream_tx_stats_t;
+
+esp_err_t stream_tx_start(const stream_tx_config_t *cfg, stream_tx_t **ret_tx);
+
+// Queues a copy of up to STREAM_TX_BLOCK_SAMPLES samples. Never blocks.
+// Returns ESP_ERR_TIMEOUT if the block was dropped. Call from one task only.
+esp_err_t stream_tx_submit(stream_tx_t *tx, uint8_t channel, uint32_t timestamp_us,
+                           const int16_t *samples, size_t n);
+
+// Queues a feature frame of up to STREAM_MAX_FEATURES values, with the same
+// drop rules and sequence numbers as sample blocks.
+esp_err_t stream_tx_submit_features(stream_tx_t *tx, uint8_t channel, uint32_t timestamp_us,
+                                    const float *values, size_t n);
+
+void stream_tx_get_stats(stream_tx_t *tx, stream_tx_stats_t *stats);
+
+// Stops the task once the queue is drained and frees everything
+void stream_tx_stop(stream_tx_t *tx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,457 @@
+// =============================
+// Binary Sample Streaming Protocol
+// =============================
+
+#include <stdbool.h>
+#include <string.h>
+#include "stream_proto.h"
+
+#define DELTA8_ESCAPE   0x80
+
+
+// =============================
+// CRC-16/CCITT-FALSE
+// =============================
+uint16_t stream_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// =============================
+// COBS
+// =============================
+size_t stream_cobs_encode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t code_pos = 0;    // Where the current block's length byte goes
+    size_t o = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        } else {
+            out[o++] = in[i];
+            if (++code == 0xFF) {
+                out[code_pos] = code;
+                code_pos = o++;
+                code = 1;
+            }
+        }
+    }
+    out[code_pos] = code;
+    return o;
+}
+
+size_t stream_cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t out_size)
+{
+    size_t i = 0;
+    size_t o = 0;
+
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len) {
+            return 0;
+        }
+        if (o + code - 1 > out_size) {
+            return 0;
+        }
+        for (uint8_t k = 1; k < code; k++) {
+            if (in[i] == 0) {
+                return 0;
+            }
+            out[o++] = in[i++];
+        }
+        // A block shorter than 0xFF stands for a zero, except at the very end
+        if (code < 0xFF && i < len) {
+            if (o == out_size) {
+                return 0;
+            }
+            out[o++] = 0;
+        }
+    }
+    return o;
+}
+
+// =============================
+// Payload Encodings
+// =============================
+static size_t delta8_size(const int16_t *s, size_t n)
+{
+    size_t size = 2;
+    for (size_t i = 1; i < n; i++) {
+        int32_t d = (int32_t)s[i] - s[i - 1];
+        size += (d >= -127 && d <= 127) ? 1 : 3;
+    }
+    return size;
+}
+
+static bool fits_12bit(const int16_t *s, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (s[i] < 0 || s[i] > 0x0FFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t encode_payload(uint8_t enc, const int16_t *s, size_t n, uint8_t *p)
+{
+    size_t o = 0;
+
+    switch (enc) {
+    case STREAM_ENC_RAW16:
+        for (size_t i = 0; i < n; i++) {
+            p[o++] = (uint8_t)s[i];
+            p[o++] = (uint8_t)((uint16_t)s[i] >> 8);
+        }
+        break;
+
+    case STREAM_ENC_PACKED12:
+        for (size_t i = 0; i + 1 < n; i += 2) {
+            uint16_t a = (uint16_t)s[i], b = (uint16_t)s[i + 1];
+            p[o++] = (uint8_t)a;
+            p[o++] = (uint8_t)(((a >> 8) & 0x0F) | ((b & 0x0F) << 4));
+            p[o++] = (uint8_t)(b >> 4);
+        }
+        if (n & 1) {
+            p[o++] = (uint8_t)s[n - 1];
+            p[o++] = (uint8_t)(((uint16_t)s[n - 1] >> 8) & 0x0F);
+        }
+        break;
+
+    case STREAM_ENC_DELTA8:
+        if (n == 0) {
+            break;
+        }
+        p[o++] = (uint8_t)s[0];
+        p[o++] = (uint8_t)((uint16_t)s[0] >> 8);
+        for (size_t i = 1; i < n; i++) {
+            int32_t d = (int32_t)s[i] - s[i - 1];
+            if (d >= -127 && d <= 127) {
+                p[o++] = (uint8_t)(int8_t)d;
+            } else {
+                p[o++] = DELTA8_ESCAPE;
+                p[o++] = (uint8_t)s[i];
+                p[o++] = (uint8_t)((uint16_t)s[i] >> 8);
+            }
+        }
+        break;
+    }
+    return o;
+}
+
+static esp_err_t decode_payload(uint8_t enc, const uint8_t *p, size_t len, int16_t *s, size_t n)
+{
+    size_t i = 0;
+
+    switch (enc) {
+    case STREAM_ENC_RAW16:
+        if (len != 2 * n) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        for (size_t k = 0; k < n; k++, i += 2) {
+            s[k] = (int16_t)(p[i] | (p[i + 1] << 8));
+        }
+        return ESP_OK;
+
+    case STREAM_ENC_PACKED12:
+        if (len != 3 * (n / 2) + 2 * (n & 1)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        for (size_t k = 0; k + 1 < n; k += 2, i += 3) {
+            s[k] = (int16_t)(p[i] | ((p[i + 1] & 0x0F) << 8));
+            s[k + 1] = (int16_t)((p[i + 1] >> 4) | (p[i + 2] << 4));
+        }
+        if (n & 1) {
+            s[n - 1] = (int16_t)(p[i] | ((p[i + 1] & 0x0F) << 8));
+        }
+        return ESP_OK;
+
+    case STREAM_ENC_DELTA8:
+        if (n == 0) {
+            return (len == 0) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+        }
+        if (len < 2) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        s[0] = (int16_t)(p[0] | (p[1] << 8));
+        i = 2;
+        for (size_t k = 1; k < n; k++) {
+            if (i >= len) {
+                return ESP_ERR_INVALID_SIZE;
+            }
+            if (p[i] == DELTA8_ESCAPE) {
+                if (i + 3 > len) {
+                    return ESP_ERR_INVALID_SIZE;
+                }
+                s[k] = (int16_t)(p[i + 1] | (p[i + 2] << 8));
+                i += 3;
+            } else {
+                s[k] = (int16_t)(s[k - 1] + (int8_t)p[i]);
+                i += 1;
+            }
+        }
+        return (i == len) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+
+    default:
+        return ESP_ERR_INVALID_SIZE;
+    }
+}
+
+// =============================
+// Frames
+// =============================
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static void put_header(uint8_t *raw, uint8_t type, const stream_frame_hdr_t *hdr)
+{
+    raw[0] = type;
+    raw[1] = hdr->encoding;
+    raw[2] = hdr->channel;
+    put_u16(&raw[3], hdr->count);
+    put_u32(&raw[5], hdr->seq);
+    put_u32(&raw[9], hdr->timestamp_us);
+}
+
+static void get_header(const uint8_t *raw, stream_frame_hdr_t *hdr)
+{
+    hdr->encoding = raw[1];
+    hdr->channel = raw[2];
+    hdr->count = get_u16(&raw[3]);
+    hdr->seq = get_u32(&raw[5]);
+    hdr->timestamp_us = get_u32(&raw[9]);
+}
+
+// Appends the CRC to raw[0..len) (room for it is the caller's) and writes
+// the COBS-encoded frame with both delimiters to out
+static esp_err_t frame_wrap(uint8_t *raw, size_t len, uint8_t *out, size_t out_size, size_t *out_len)
+{
+    put_u16(&raw[len], stream_crc16(raw, len));
+    len += STREAM_CRC_SIZE;
+    if (out_size < len + len / 254 + 1 + 2) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    out[0] = 0x00;
+    size_t cobs_len = stream_cobs_encode(raw, len, &out[1]);
+    out[1 + cobs_len] = 0x00;
+    *out_len = cobs_len + 2;
+    return ESP_OK;
+}
+
+// Undoes COBS and checks the CRC; *body = header + payload length
+static esp_err_t frame_unwrap(const uint8_t *frame, size_t len, uint8_t *raw, size_t *body)
+{
+    if (len == 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    size_t raw_len = stream_cobs_decode(frame, len, raw, STREAM_RAW_MAX_SIZE);
+    if (raw_len < STREAM_HEADER_SIZE + STREAM_CRC_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *body = raw_len - STREAM_CRC_SIZE;
+    if (stream_crc16(raw, *body) != get_u16(&raw[*body])) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    return ESP_OK;
+}
+
+esp_err_t stream_proto_encode(stream_frame_hdr_t *hdr, const int16_t *samples,
+                              uint8_t *out, size_t out_size, size_t *out_len)
+{
+    if (!hdr || (!samples && hdr->count) || !out || !out_len || hdr->count > STREAM_MAX_SAMPLES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const size_t n = hdr->count;
+
+    // --- 1. Choose the encoding ---
+    if (hdr->encoding == STREAM_ENC_AUTO) {
+        size_t best = 2 * n;
+        hdr->encoding = STREAM_ENC_RAW16;
+        if (fits_12bit(samples, n) && 3 * (n / 2) + 2 * (n & 1) < best) {
+            best = 3 * (n / 2) + 2 * (n & 1);
+            hdr->encoding = STREAM_ENC_PACKED12;
+        }
+        if (n > 0 && delta8_size(samples, n) < best) {
+            hdr->encoding = STREAM_ENC_DELTA8;
+        }
+    } else if (hdr->encoding == STREAM_ENC_PACKED12 && !fits_12bit(samples, n)) {
+        return ESP_ERR_INVALID_ARG;
+    } else if (hdr->encoding == STREAM_ENC_DELTA8 && n > 0 && delta8_size(samples, n) > 2 * n) {
+        return ESP_ERR_INVALID_ARG;     // Too many escapes: would not fit a frame, use RAW16
+    } else if (hdr->encoding > STREAM_ENC_PACKED12) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // --- 2. Header + payload in a scratch buffer ---
+    uint8_t raw[STREAM_RAW_MAX_SIZE];
+    put_header(raw, STREAM_FRAME_SAMPLES, hdr);
+    size_t len = STREAM_HEADER_SIZE + encode_payload(hdr->encoding, samples, n, &raw[STREAM_HEADER_SIZE]);
+
+    // --- 3. CRC, then COBS between two delimiters ---
+    return frame_wrap(raw, len, out, out_size, out_len);
+}
+
+esp_err_t stream_proto_encode_features(stream_frame_hdr_t *hdr, const float *values,
+                                       uint8_t *out, size_t out_size, size_t *out_len)
+{
+    if (!hdr || (!values && hdr->count) || !out || !out_len || hdr->count > STREAM_MAX_FEATURES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    hdr->encoding = STREAM_ENC_FLOAT32;
+
+    uint8_t raw[STREAM_HEADER_SIZE + 4 * STREAM_MAX_FEATURES + STREAM_CRC_SIZE];
+    put_header(raw, STREAM_FRAME_FEATURES, hdr);
+    size_t len = STREAM_HEADER_SIZE;
+    for (size_t i = 0; i < hdr->count; i++, len += 4) {
+        uint32_t bits;
+        memcpy(&bits, &values[i], sizeof(bits));
+        put_u32(&raw[len], bits);
+    }
+    return frame_wrap(raw, len, out, out_size, out_len);
+}
+
+esp_err_t stream_proto_decode(const uint8_t *frame, size_t len, stream_frame_hdr_t *hdr, int16_t *samples)
+{
+    uint8_t raw[STREAM_RAW_MAX_SIZE];
+    size_t body;
+
+    esp_err_t err = frame_unwrap(frame, len, raw, &body);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (raw[0] != STREAM_FRAME_SAMPLES) {
+        return (raw[0] == STREAM_FRAME_FEATURES) ? ESP_ERR_NOT_SUPPORTED : ESP_ERR_INVALID_SIZE;
+    }
+
+    get_header(raw, hdr);
+    if (hdr->count > STREAM_MAX_SAMPLES) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return decode_payload(hdr->encoding, &raw[STREAM_HEADER_SIZE], body - STREAM_HEADER_SIZE,
+                          samples, hdr->count);
+}
+
+esp_err_t stream_proto_decode_features(const uint8_t *frame, size_t len, stream_frame_hdr_t *hdr, float *values)
+{
+    uint8_t raw[STREAM_RAW_MAX_SIZE];
+    size_t body;
+
+    esp_err_t err = frame_unwrap(frame, len, raw, &body);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (raw[0] != STREAM_FRAME_FEATURES) {
+        return (raw[0] == STREAM_FRAME_SAMPLES) ? ESP_ERR_NOT_SUPPORTED : ESP_ERR_INVALID_SIZE;
+    }
+
+    get_header(raw, hdr);
+    if (hdr->encoding != STREAM_ENC_FLOAT32 || hdr->count > STREAM_MAX_FEATURES ||
+        body != STREAM_HEADER_SIZE + 4u * hdr->count) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (size_t i = 0; i < hdr->count; i++) {
+        uint32_t bits = get_u32(&raw[STREAM_HEADER_SIZE + 4 * i]);
+        memcpy(&values[i], &bits, sizeof(bits));
+    }
+    return ESP_OK;
+}
+
+// =============================
+// Byte-Stream Decoder
+// =============================
+void stream_decoder_init(stream_decoder_t *dec, stream_frame_cb_t on_frame, void *ctx)
+{
+    memset(dec, 0, sizeof(*dec));
+    dec->on_frame = on_frame;
+    dec->ctx = ctx;
+}
+
+static void decoder_frame_end(stream_decoder_t *dec)
+{
+    if (dec->len == 0 || dec->len > sizeof(dec->buf)) {
+        return;     // Back-to-back delimiters, or an oversized run already counted
+    }
+
+    stream_frame_hdr_t hdr;
+    bool features = false;
+    esp_err_t err = stream_proto_decode(dec->buf, dec->len, &hdr, dec->samples);
+    if (err == ESP_ERR_NOT_SUPPORTED) {
+        features = true;
+        err = stream_proto_decode_features(dec->buf, dec->len, &hdr, dec->values);
+    }
+    if (err != ESP_OK) {
+        dec->bad_frames++;
+        return;
+    }
+
+    // One sequence for both frame types. A jump backwards (in modulo 2^32
+    // terms) is a restarted sender, not 4 billion lost frames.
+    if (dec->frames > 0 && hdr.seq != dec->next_seq) {
+        if ((int32_t)(hdr.seq - dec->next_seq) < 0) {
+            dec->resyncs++;
+        } else {
+            dec->lost_frames += hdr.seq - dec->next_seq;
+        }
+    }
+    dec->next_seq = hdr.seq + 1;
+    dec->frames++;
+    if (features) {
+        dec->feature_frames++;
+        if (dec->on_features) {
+            dec->on_features(&hdr, dec->values, dec->ctx);
+        }
+        return;
+    }
+    dec->samples_out += hdr.count;
+    if (dec->on_frame) {
+        dec->on_frame(&hdr, dec->samples, dec->ctx);
+    }
+}
+
+void stream_decoder_feed(stream_decoder_t *dec, const uint8_t *data, size_t len)
+{
+    dec->bytes += len;
+
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] == 0x00) {
+            decoder_frame_end(dec);
+            dec->len = 0;
+        } else if (dec->len < sizeof(dec->buf)) {
+            dec->buf[dec->len++] = data[i];
+        } else {
+            // Too long to be a frame: discard until the next delimiter
+            dec->bad_frames += (dec->len == sizeof(dec->buf));
+            dec->len = sizeof(dec->buf) + 1;
+        }
+    }
+}
@@ -0,0 +1,216 @@
+// =============================
+// Binary Stream Transmit Task
+// =============================
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "stream_tx.h"
+
+#define TAG "STREAM_TX"
+
+#define STREAM_TX_STOP   0xFFFF     // Block count that tells the task to exit
+
+
+typedef struct {
+    uint8_t  type;                  // STREAM_FRAME_SAMPLES or STREAM_FRAME_FEATURES
+    uint8_t  channel;
+    uint16_t count;
+    uint32_t seq;
+    uint32_t timestamp_us;
+    union {                         // Feature vectors fit in the sample block's space
+        int16_t samples[STREAM_TX_BLOCK_SAMPLES];
+        float   values[STREAM_MAX_FEATURES];
+    };
+} stream_tx_block_t;
+
+struct stream_tx {
+    stream_tx_config_t cfg;
+    QueueHandle_t queue;
+    SemaphoreHandle_t done;         // Given by the task when it exits
+    // Written by the producer only
+    uint32_t next_seq;              // Assigned at submit time so drops leave a gap
+    stream_tx_block_t staging;      // Copied into the queue by xQueueSend()
+    atomic_uint dropped_blocks;
+    // Written by the task only; 64-bit counters take two stores on the chip,
+    // so they are updated and read under stats_lock
+    portMUX_TYPE stats_lock;
+    uint32_t frames;
+    uint32_t feature_frames;
+    uint64_t samples;
+    uint64_t bytes;
+    stream_tx_block_t block;        // Task-side copy of the current block
+    uint8_t wire[STREAM_WIRE_MAX_SIZE];
+};
+
+
+static size_t stream_tx_stdout_write(const uint8_t *data, size_t len, void *ctx)
+{
+    size_t written = fwrite(data, 1, len, stdout);
+    fflush(stdout);
+    return written;
+}
+
+static void stream_tx_task(void *arg)
+{
+    stream_tx_t *tx = (stream_tx_t *)arg;
+
+    while (1) {
+        // --- 1. Wait for the next block (this task has nothing else to do) ---
+        if (xQueueReceive(tx->queue, &tx->block, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (tx->block.count == STREAM_TX_STOP) {
+            break;
+        }
+
+        // --- 2. Encode ---
+        stream_frame_hdr_t hdr = {
+            .encoding = tx->cfg.encoding,
+            .channel = tx->block.channel,
+            .count = tx->block.count,
+            .seq = tx->block.seq,
+            .timestamp_us = tx->block.timestamp_us,
+        };
+        size_t len = 0;
+        if (tx->block.type == STREAM_FRAME_FEATURES) {
+            stream_proto_encode_features(&hdr, tx->block.values, tx->wire, sizeof(tx->wire), &len);
+        } else if (stream_proto_encode(&hdr, tx->block.samples, tx->wire, sizeof(tx->wire), &len) != ESP_OK) {
+            // Forced encoding that cannot carry this block: fall back to raw
+            hdr.encoding = STREAM_ENC_RAW16;
+            stream_proto_encode(&hdr, tx->block.samples, tx->wire, sizeof(tx->wire), &len);
+        }
+
+        // --- 3. Write (may block on the UART; only this task waits) ---
+        size_t written = tx->cfg.write(tx->wire, len, tx->cfg.write_ctx);
+        portENTER_CRITICAL(&tx->stats_lock);
+        tx->bytes += written;
+        if (tx->block.type == STREAM_FRAME_FEATURES) {
+            tx->feature_frames++;
+        } else {
+            tx->samples += hdr.count;
+        }
+        tx->frames++;
+        portEXIT_CRITICAL(&tx->stats_lock);
+    }
+
+    xSemaphoreGive(tx->done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t stream_tx_start(const stream_tx_config_t *cfg, stream_tx_t **ret_tx)
+{
+    if (!cfg || !ret_tx || cfg->queue_depth == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    stream_tx_t *tx = calloc(1, sizeof(*tx));
+    if (!tx) {
+        return ESP_ERR_NO_MEM;
+    }
+    tx->cfg = *cfg;
+    if (!tx->cfg.write) {
+        tx->cfg.write = stream_tx_stdout_write;
+    }
+    atomic_init(&tx->dropped_blocks, 0);
+    portMUX_INITIALIZE(&tx->stats_lock);
+
+    tx->queue = xQueueCreate(cfg->queue_depth, sizeof(stream_tx_block_t));
+    tx->done = xSemaphoreCreateBinary();
+    if (!tx->queue || !tx->done) {
+        ESP_LOGE(TAG, "Failed to create stream queue!");
+        goto err;
+    }
+
+    if (xTaskCreate(stream_tx_task, "Stream TX", cfg->task_stack, tx, cfg->task_priority, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create stream task!");
+        goto err;
+    }
+
+    *ret_tx = tx;
+    return ESP_OK;
+
+err:
+    if (tx->queue) {
+        vQueueDelete(tx->queue);
+    }
+    if (tx->done) {
+        vSemaphoreDelete(tx->done);
+    }
+    free(tx);
+    return ESP_ERR_NO_MEM;
+}
+
+// Timeout 0: the producer never waits for the transmitter
+static esp_err_t stream_tx_queue(stream_tx_t *tx)
+{
+    if (xQueueSend(tx->queue, &tx->staging, 0) != pdTRUE) {
+        atomic_fetch_add(&tx->dropped_blocks, 1);
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+esp_err_t stream_tx_submit(stream_tx_t *tx, uint8_t channel, uint32_t timestamp_us,
+                           const int16_t *samples, size_t n)
+{
+    if (!tx || !samples || n == 0 || n > STREAM_TX_BLOCK_SAMPLES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    stream_tx_block_t *staging = &tx->staging;
+    staging->type = STREAM_FRAME_SAMPLES;
+    staging->channel = channel;
+    staging->count = (uint16_t)n;
+    staging->seq = tx->next_seq++;
+    staging->timestamp_us = timestamp_us;
+    memcpy(staging->samples, samples, n * sizeof(int16_t));
+    return stream_tx_queue(tx);
+}
+
+esp_err_t stream_tx_submit_features(stream_tx_t *tx, uint8_t channel, uint32_t timestamp_us,
+                                    const float *values, size_t n)
+{
+    if (!tx || !values || n == 0 || n > STREAM_MAX_FEATURES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    stream_tx_block_t *staging = &tx->staging;
+    staging->type = STREAM_FRAME_FEATURES;
+    staging->channel = channel;
+    staging->count = (uint16_t)n;
+    staging->seq = tx->next_seq++;
+    staging->timestamp_us = timestamp_us;
+    memcpy(staging->values, values, n * sizeof(float));
+    return stream_tx_queue(tx);
+}
+
+void stream_tx_get_stats(stream_tx_t *tx, stream_tx_stats_t *stats)
+{
+    portENTER_CRITICAL(&tx->stats_lock);
+    stats->frames = tx->frames;
+    stats->feature_frames = tx->feature_frames;
+    stats->samples = tx->samples;
+    stats->bytes = tx->bytes;
+    portEXIT_CRITICAL(&tx->stats_lock);
+    stats->dropped_blocks = atomic_load(&tx->dropped_blocks);
+}
+
+void stream_tx_stop(stream_tx_t *tx)
+{
+    if (!tx) {
+        return;
+    }
+    static const stream_tx_block_t stop = { .count = STREAM_TX_STOP };
+    xQueueSend(tx->queue, &stop, portMAX_DELAY);
+    xSemaphoreTake(tx->done, portMAX_DELAY);
+    vQueueDelete(tx->queue);
+    vSemaphoreDelete(tx->done);
+    free(tx);
+}
@@ -0,0 +1,39 @@
+// =============================
+// Host Benchmark Helpers
+// =============================
+// Wall-clock and CPU cycle counters for the [bench] test cases.
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#if defined(__XTENSA__) || defined(__riscv)
+#include "sdkconfig.h"
+#include "esp_timer.h"
+#endif
+
+static inline int64_t bench_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// CPU cycles where the host exposes a counter, nanoseconds otherwise
+static inline uint64_t bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#elif defined(__XTENSA__) || defined(__riscv)
+    // The CCOUNT register wraps every few seconds; count cycles off the 64-bit timer
+    return (uint64_t)esp_timer_get_time() * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#endif
+}
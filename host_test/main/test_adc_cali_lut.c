@@ -0,0 +1,157 @@
+// =============================
+// Tests: adc_cali_lut
+// =============================
+
+#include <stdio.h>
+#include "unity.h"
+#include "adc_cali_lut.h"
+#include "bench.h"
+
+// Stand-in for adc_cali_raw_to_voltage(): the curve-fitting scheme is a
+// linear fit plus a polynomial error correction, all in integer math. Kept
+// out of line like the real driver call.
+__attribute__((noinline)) static esp_err_t model_raw_to_mv(void *ctx, int raw, int *mv)
+{
+    if (raw < 0 || raw > 4095) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const int64_t coeff_a = 53100;     // Slope, scaled by 65536
+    const int64_t coeff_b = 142;       // Offset (mV)
+    int64_t v = (coeff_a * raw) / 65536 + coeff_b;
+    int64_t x = raw;
+    int64_t err = (x * x * 3) / 1000000 - (x * x * x) / 2000000000;
+    *mv = (int)(v - err);
+    return ESP_OK;
+}
+
+static esp_err_t failing_convert(void *ctx, int raw, int *mv)
+{
+    return (raw == 100) ? ESP_FAIL : model_raw_to_mv(ctx, raw, mv);
+}
+
+// Offset by ctx mV: pushes the ends of the curve out of the int16_t range
+static esp_err_t shifted_convert(void *ctx, int raw, int *mv)
+{
+    model_raw_to_mv(NULL, raw, mv);
+    *mv += (int)(intptr_t)ctx;
+    return ESP_OK;
+}
+
+TEST_CASE("cali lut is bit-exact against the reference routine", "[adc_cali_lut]")
+{
+    adc_cali_lut_t *lut = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, adc_cali_lut_new(12, model_raw_to_mv, NULL, &lut));
+
+    uint32_t mismatches = 1;
+    TEST_ASSERT_EQUAL(ESP_OK, adc_cali_lut_verify(lut, model_raw_to_mv, NULL, &mismatches));
+    TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+
+    // Block conversion must give exactly the per-sample answer, for every code
+    static uint16_t raw[4096 + 3];
+    static int16_t mv[4096 + 3];
+    for (int i = 0; i < 4096 + 3; i++) {
+        raw[i] = (uint16_t)((i * 2654435761u) & 0x0FFF);
+    }
+    adc_cali_lut_raw_to_mv_block(lut, raw, mv, 4096 + 3);
+    for (int i = 0; i < 4096 + 3; i++) {
+        int ref = 0;
+        model_raw_to_mv(NULL, raw[i], &ref);
+        TEST_ASSERT_EQUAL_INT(ref, mv[i]);
+    }
+
+    // A modified entry must be caught
+    lut->mv[1234]++;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, adc_cali_lut_verify(lut, model_raw_to_mv, NULL, &mismatches));
+    TEST_ASSERT_EQUAL_UINT32(1, mismatches);
+    adc_cali_lut_del(lut);
+}
+
+TEST_CASE("cali lut falls back to raw codes without a table", "[adc_cali_lut]")
+{
+    const uint16_t raw[5] = {0, 1, 2048, 4094, 4095};
+    int16_t mv[5];
+    adc_cali_lut_raw_to_mv_block(NULL, raw, mv, 5);
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_INT(raw[i], mv[i]);
+    }
+}
+
+TEST_CASE("cali lut maps millivolts back to codes", "[adc_cali_lut]")
+{
+    adc_cali_lut_t *lut = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, adc_cali_lut_new(12, model_raw_to_mv, NULL, &lut));
+
+    // Every value in the table comes back as a code that gives it, also
+    // where the curve dips (the model has ten one-code dips of 1 mV)
+    for (uint32_t raw = 0; raw <= lut->mask; raw++) {
+        uint16_t back = adc_cali_lut_mv_to_raw(lut, lut->mv[raw]);
+        TEST_ASSERT_EQUAL_UINT16(lut->mv[raw], lut->mv[back]);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(raw, back);
+    }
+    // Between entries the nearer one wins; past the ends the end codes
+    uint16_t a = adc_cali_lut_mv_to_raw(lut, 1000);
+    TEST_ASSERT_INT_WITHIN(1, 1000, lut->mv[a]);
+    TEST_ASSERT_EQUAL_UINT16(0, adc_cali_lut_mv_to_raw(lut, -50));
+    TEST_ASSERT_EQUAL_UINT16(lut->mv[4095], lut->mv[adc_cali_lut_mv_to_raw(lut, 30000)]);
+    adc_cali_lut_del(lut);
+
+    TEST_ASSERT_EQUAL_UINT16(1234, adc_cali_lut_mv_to_raw(NULL, 1234));
+    TEST_ASSERT_EQUAL_UINT16(0, adc_cali_lut_mv_to_raw(NULL, -1));
+}
+
+TEST_CASE("cali lut rejects bad arguments and failed conversions", "[adc_cali_lut]")
+{
+    adc_cali_lut_t *lut = NULL;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, adc_cali_lut_new(13, model_raw_to_mv, NULL, &lut));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, adc_cali_lut_new(12, NULL, NULL, &lut));
+    TEST_ASSERT_EQUAL(ESP_FAIL, adc_cali_lut_new(12, failing_convert, NULL, &lut));
+    TEST_ASSERT_NULL(lut);
+
+    // Values the int16_t output cannot hold are refused, not wrapped
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_RESPONSE, adc_cali_lut_new(12, shifted_convert, (void *)(intptr_t)-200, &lut));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_RESPONSE, adc_cali_lut_new(12, shifted_convert, (void *)(intptr_t)32000, &lut));
+    TEST_ASSERT_NULL(lut);
+}
+
+#define BENCH_FRAME  256
+#define BENCH_ROUNDS 4000
+
+TEST_CASE("cali lut cycles per sample", "[adc_cali_lut][bench]")
+{
+    static uint16_t raw[BENCH_FRAME];
+    static int16_t mv[BENCH_FRAME];
+    for (int i = 0; i < BENCH_FRAME; i++) {
+        raw[i] = (uint16_t)((i * 40503u) & 0x0FFF);
+    }
+
+    adc_cali_lut_t *lut = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, adc_cali_lut_new(12, model_raw_to_mv, NULL, &lut));
+
+    // Per-sample routine, as adc_sampling() did before
+    uint32_t chk = 0;
+    uint64_t c0 = bench_cycles();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int i = 0; i < BENCH_FRAME; i++) {
+            int v = 0;
+            model_raw_to_mv(NULL, raw[i], &v);
+            mv[i] = (int16_t)v;
+        }
+        chk += mv[r % BENCH_FRAME];
+    }
+    uint64_t c1 = bench_cycles();
+
+    // Table lookup, one call per frame
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        adc_cali_lut_raw_to_mv_block(lut, raw, mv, BENCH_FRAME);
+        chk -= mv[r % BENCH_FRAME];
+    }
+    uint64_t c2 = bench_cycles();
+
+    double per_sample = (double)(c1 - c0) / (BENCH_FRAME * BENCH_ROUNDS);
+    double per_lut = (double)(c2 - c1) / (BENCH_FRAME * BENCH_ROUNDS);
+    printf("[bench] adc_cali_lut: per-sample routine %.2f cycles/sample, table %.2f cycles/sample\n",
+           per_sample, per_lut);
+
+    TEST_ASSERT_EQUAL_UINT32(0, chk);
+    adc_cali_lut_del(lut);
+}
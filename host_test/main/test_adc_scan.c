@@ -0,0 +1,247 @@
+// =============================
+// Tests: adc_scan (multi-channel de-interleave)
+// =============================
+
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "adc_scan.h"
+#include "adc_source.h"
+#include "bench.h"
+
+// Code of `ch` in scan n: channel in the top bits so mixed-up samples show
+static uint16_t scan_code(int ch, uint64_t n)
+{
+    return (uint16_t)((ch << 8) | (n & 0xFF));
+}
+
+static uint16_t scan_signal(int channel, uint64_t n, void *ctx)
+{
+    return scan_code(channel, n);
+}
+
+static void fill_scans(const adc_source_config_t *cfg, uint64_t first_scan, uint32_t scans, uint16_t *words)
+{
+    for (uint32_t s = 0; s < scans; s++) {
+        for (uint32_t c = 0; c < cfg->num_channels; c++) {
+            int ch = cfg->channels[c].channel;
+            *words++ = ADC_SCAN_WORD(ch, scan_code(ch, first_scan + s));
+        }
+    }
+}
+
+static adc_source_config_t six_channels(void)
+{
+    adc_source_config_t cfg = {
+        .sample_rate_hz = 1000,
+        .frame_samples = 64,
+        .num_channels = 6,
+        .channels = {
+            { .channel = 6, .rate_div = 1 },
+            { .channel = 7, .rate_div = 2 },
+            { .channel = 4, .rate_div = 1 },
+            { .channel = 5, .rate_div = 4 },
+            { .channel = 0, .rate_div = 3 },
+            { .channel = 3, .rate_div = 1 },
+        },
+    };
+    return cfg;
+}
+
+TEST_CASE("scan de-interleaves into aligned per-channel runs", "[adc_scan]")
+{
+    adc_source_config_t cfg = six_channels();
+    static uint16_t storage[6 * 64];
+    static uint16_t words[6 * 64];
+    adc_scan_t scan;
+    TEST_ASSERT_EQUAL(ESP_OK, adc_scan_init(&scan, &cfg, storage, 64));
+
+    const int64_t scan_us = 1000;       // 1 kHz scans
+    const int64_t conv_us = 1000;       // Per scan; one slot is conv_us / 6
+    uint64_t first = 0;
+    for (int f = 0; f < 5; f++, first += 64) {
+        fill_scans(&cfg, first, 64, words);
+        adc_frame_t frame;
+        adc_scan_deinterleave(&scan, words, 6 * 64, 1000000 + (int64_t)first * scan_us, &frame);
+
+        TEST_ASSERT_EQUAL_UINT32(6, frame.num_channels);
+        TEST_ASSERT_EQUAL_PTR(frame.chan[0].data, frame.data);
+        for (uint32_t c = 0; c < 6; c++) {
+            const adc_frame_chan_t *ch = &frame.chan[c];
+            const uint32_t div = cfg.channels[c].rate_div;
+            TEST_ASSERT_EQUAL_INT(cfg.channels[c].channel, ch->channel);
+            TEST_ASSERT_EQUAL_UINT32(0, ((uintptr_t)ch->data) % 16);
+
+            // Kept scans are the multiples of the divider
+            uint64_t s0 = (first + div - 1) / div * div;
+            TEST_ASSERT_EQUAL((first + 64 - s0 + div - 1) / div, ch->len);
+            for (size_t i = 0; i < ch->len; i++) {
+                TEST_ASSERT_EQUAL_UINT16(scan_code(ch->channel, s0 + i * div), ch->data[i]);
+            }
+            // Common time base: scan start plus the slot delay
+            TEST_ASSERT_INT64_WITHIN(1, 1000000 + (int64_t)s0 * scan_us + (int64_t)c * conv_us / 6, ch->timestamp_us);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, scan.resyncs);
+    TEST_ASSERT_EQUAL_UINT32(0, scan.filled);
+}
+
+TEST_CASE("scan resynchronises after lost and foreign results", "[adc_scan]")
+{
+    adc_source_config_t cfg = {
+        .sample_rate_hz = 1000,
+        .frame_samples = 8,
+        .num_channels = 4,
+        .channels = { { .channel = 6 }, { .channel = 7 }, { .channel = 4 }, { .channel = 5 } },
+    };
+    uint16_t storage[4 * ADC_SCAN_STRIDE(9)];
+    uint16_t words[4 * 8];
+    adc_scan_t scan;
+    TEST_ASSERT_EQUAL(ESP_OK, adc_scan_init(&scan, &cfg, storage, 9));
+
+    fill_scans(&cfg, 0, 8, words);
+    // Scan 2 loses its ch7 result; scan 5 gets a result of a channel not in the pattern
+    uint16_t damaged[4 * 8 + 1];
+    size_t n = 0;
+    for (size_t i = 0; i < 4 * 8; i++) {
+        if (i == 2 * 4 + 1) {
+            continue;
+        }
+        if (i == 5 * 4 + 2) {
+            damaged[n++] = ADC_SCAN_WORD(2, 0x555);
+        }
+        damaged[n++] = words[i];
+    }
+
+    adc_frame_t frame;
+    adc_scan_deinterleave(&scan, damaged, n, 0, &frame);
+    TEST_ASSERT_EQUAL_UINT32(1, scan.resyncs);
+    TEST_ASSERT_EQUAL_UINT32(1, scan.filled);
+    TEST_ASSERT_EQUAL_UINT32(1, scan.foreign);
+
+    // All runs still line up with the scan index; the gap holds the previous value
+    for (uint32_t c = 0; c < 4; c++) {
+        int ch = cfg.channels[c].channel;
+        TEST_ASSERT_EQUAL(8, frame.chan[c].len);
+        for (uint64_t s = 0; s < 8; s++) {
+            uint16_t expect = (c == 1 && s == 2) ? scan_code(ch, 1) : scan_code(ch, s);
+            TEST_ASSERT_EQUAL_UINT16(expect, frame.chan[c].data[s]);
+        }
+    }
+}
+
+TEST_CASE("scan rejects bad channel tables", "[adc_scan]")
+{
+    uint16_t storage[64];
+    adc_scan_t scan;
+    adc_source_config_t cfg = {
+        .sample_rate_hz = 1000,
+        .frame_samples = 8,
+        .num_channels = 2,
+        .channels = { { .channel = 3 }, { .channel = 3 } },
+    };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, adc_scan_init(&scan, &cfg, storage, 8));
+    cfg.channels[1].channel = 16;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, adc_scan_init(&scan, &cfg, storage, 8));
+
+    // The same checks guard the sources
+    adc_source_t *src = NULL;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, adc_source_new_host(&cfg, NULL, &src));
+    cfg.num_channels = ADC_SOURCE_MAX_CHANNELS + 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, adc_source_new_host(&cfg, NULL, &src));
+}
+
+TEST_CASE("host source delivers multi-channel frames", "[adc_scan]")
+{
+    adc_source_config_t cfg = six_channels();
+    adc_host_source_config_t host_cfg = {
+        .scan_signal = scan_signal,
+    };
+    adc_source_t *src = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, adc_source_new_host(&cfg, &host_cfg, &src));
+    TEST_ASSERT_EQUAL_UINT32(6, adc_source_get_config(src)->num_channels);
+    TEST_ASSERT_EQUAL(ESP_OK, adc_source_start(src));
+
+    uint64_t total = 0;
+    for (uint32_t f = 0; f < 12; f++) {
+        adc_frame_t frame;
+        TEST_ASSERT_EQUAL(ESP_OK, adc_source_read(src, &frame, 100));
+        TEST_ASSERT_EQUAL_UINT32(f, frame.seq);
+        for (uint32_t c = 0; c < 6; c++) {
+            const adc_frame_chan_t *ch = &frame.chan[c];
+            const uint32_t div = cfg.channels[c].rate_div;
+            uint64_t s0 = ((uint64_t)f * 64 + div - 1) / div * div;
+            TEST_ASSERT_EQUAL_UINT16(scan_code(ch->channel, s0), ch->data[0]);
+            TEST_ASSERT_EQUAL_UINT16(scan_code(ch->channel, s0 + (ch->len - 1) * div), ch->data[ch->len - 1]);
+            // Same scan -> same time, up to the slot delay
+            TEST_ASSERT_INT64_WITHIN(1000, frame.timestamp_us + (int64_t)(s0 - f * 64) * 1000, ch->timestamp_us);
+            total += ch->len;
+        }
+    }
+
+    adc_source_stats_t stats;
+    adc_source_get_stats(src, &stats);
+    TEST_ASSERT_EQUAL_UINT64(total, stats.samples);
+    adc_source_del(src);
+}
+
+// =============================
+// Benchmark
+// =============================
+#define BENCH_SCANS  256
+#define BENCH_ROUNDS 4000
+
+TEST_CASE("scan de-interleave throughput", "[adc_scan][bench]")
+{
+    static const int chans[ADC_SOURCE_MAX_CHANNELS] = {6, 7, 4, 5, 0, 3, 1, 2};
+    static uint16_t words[ADC_SOURCE_MAX_CHANNELS * BENCH_SCANS];
+    static uint16_t storage[ADC_SOURCE_MAX_CHANNELS * BENCH_SCANS];
+    static uint16_t naive[BENCH_SCANS];
+    const uint32_t counts[] = {1, 4, 8};
+
+    for (size_t k = 0; k < sizeof(counts) / sizeof(counts[0]); k++) {
+        adc_source_config_t cfg = { .sample_rate_hz = 20000, .frame_samples = BENCH_SCANS, .num_channels = counts[k] };
+        for (uint32_t c = 0; c < counts[k]; c++) {
+            cfg.channels[c].channel = chans[c];
+        }
+        adc_scan_t scan;
+        TEST_ASSERT_EQUAL(ESP_OK, adc_scan_init(&scan, &cfg, storage, BENCH_SCANS));
+        const size_t n = (size_t)counts[k] * BENCH_SCANS;
+        fill_scans(&cfg, 0, BENCH_SCANS, words);
+
+        uint32_t chk = 0;
+        uint64_t c0 = bench_cycles();
+        int64_t t0 = bench_now_us();
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            adc_frame_t frame;
+            adc_scan_deinterleave(&scan, words, n, 0, &frame);
+            chk += frame.chan[counts[k] - 1].data[r % BENCH_SCANS];
+        }
+        uint64_t c1 = bench_cycles();
+        int64_t t1 = bench_now_us();
+
+        // Reference: one pass over the frame per channel, as the single-channel
+        // continuous backend filtered "its" channel out of the DMA results
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            for (uint32_t c = 0; c < counts[k]; c++) {
+                size_t m = 0;
+                for (size_t i = 0; i < n; i++) {
+                    if (ADC_SCAN_WORD_CHANNEL(words[i]) == (unsigned)chans[c]) {
+                        naive[m++] = ADC_SCAN_WORD_CODE(words[i]);
+                    }
+                }
+                if (c == counts[k] - 1) {
+                    chk -= naive[r % BENCH_SCANS];
+                }
+            }
+        }
+        uint64_t c2 = bench_cycles();
+
+        double samples = (double)n * BENCH_ROUNDS;
+        printf("[bench] adc_scan %lu ch: %.1f Msamples/s, "
+               "%.2f cycles/sample (per-channel passes %.2f)\n",
+               (unsigned long)counts[k], samples / (double)(t1 - t0 > 0 ? t1 - t0 : 1),
+               (double)(c1 - c0) / samples, (double)(c2 - c1) / samples);
+        TEST_ASSERT_EQUAL_UINT32(0, chk);
+    }
+}
@@ -0,0 +1,278 @@
+// =============================
+// Tests: adc_source host stand-in
+// =============================
+
+#include <stdio.h>
+#include <time.h>
+#include "unity.h"
+#include "adc_source.h"
+
+// Sawtooth: sample n has code n % 4096, so every sample can be checked
+static uint16_t ramp_signal(uint64_t n, void *ctx)
+{
+    return (uint16_t)(n & 0x0FFF);
+}
+
+TEST_CASE("host source delivers contiguous frames", "[adc_source]")
+{
+    adc_source_config_t cfg = {
+        .sample_rate_hz = 20000,
+        .frame_samples = 256,
+    };
+    adc_host_source_config_t host_cfg = {
+        .signal = ramp_signal,
+    };
+    adc_source_t *src = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, adc_source_new_host(&cfg, &host_cfg, &src));
+    TEST_ASSERT_EQUAL(ESP_OK, adc_source_start(src));
+
+    uint64_t expected = 0;
+    for (uint32_t f = 0; f < 100; f++) {
+        adc_frame_t frame;
+        TEST_ASSERT_EQUAL(ESP_OK, adc_source_read(src, &frame, 100));
+        TEST_ASSERT_EQUAL_UINT32(f, frame.seq);
+        TEST_ASSERT_EQUAL(cfg.frame_samples, frame.len);
+        for (size_t i = 0; i < frame.len; i++) {
+            TEST_ASSERT_EQUAL_UINT16(expected & 0x0FFF, frame.data[i]);
+            expected++;
+        }
+    }
+
+    adc_source_stats_t stats;
+    adc_source_get_stats(src, &stats);
+    TEST_ASSERT_EQUAL_UINT64(100, stats.frames);
+    TEST_ASSERT_EQUAL_UINT64(100 * 256, stats.samples);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.dropped_frames);
+    adc_source_del(src);
+}
+
+TEST_CASE("host source drops frames when the reader lags", "[adc_source]")
+{
+    adc_source_config_t cfg = {
+        .sample_rate_hz = 100000,
+        .frame_samples = 100,        // 1 ms per frame
+    };
+    adc_host_source_config_t host_cfg = {
+        .signal = ramp_signal,
+        .realtime = true,
+        .max_queued_frames = 2,
+    };
+    adc_source_t *src = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, adc_source_new_host(&cfg, &host_cfg, &src));
+    TEST_ASSERT_EQUAL(ESP_OK, adc_source_start(src));
+
+    adc_frame_t frame;
+    TEST_ASSERT_EQUAL(ESP_OK, adc_source_read(src, &frame, 100));
+    TEST_ASSERT_EQUAL_UINT32(0, frame.seq);
+
+    // Stall for ~20 frame periods: only 2 may be kept
+    struct timespec stall = { .tv_nsec = 20 * 1000 * 1000 };
+    nanosleep(&stall, NULL);
+
+    TEST_ASSERT_EQUAL(ESP_OK, adc_source_read(src, &frame, 100));
+    adc_source_stats_t stats;
+    adc_source_get_stats(src, &stats);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(15, stats.dropped_frames);
+    // The sequence number jumps by the number of dropped frames
+    TEST_ASSERT_EQUAL_UINT32(1 + stats.dropped_frames, frame.seq);
+    // ... and the samples continue where the hardware would be
+    TEST_ASSERT_EQUAL_UINT16((frame.seq * 100) & 0x0FFF, frame.data[0]);
+    adc_source_del(src);
+}
+
+TEST_CASE("host source sustained rate", "[adc_source][bench]")
+{
+    adc_source_config_t cfg = {
+        .sample_rate_hz = 1000000,
+        .frame_samples = 1024,
+    };
+    adc_source_t *src = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, adc_source_new_host(&cfg, NULL, &src));
+    TEST_ASSERT_EQUAL(ESP_OK, adc_source_start(src));
+
+    uint32_t sum = 0;
+    for (int f = 0; f < 2000; f++) {
+        adc_frame_t frame;
+        TEST_ASSERT_EQUAL(ESP_OK, adc_source_read(src, &frame, 100));
+        sum += frame.data[frame.len - 1];
+    }
+
+    adc_source_stats_t stats;
+    adc_source_get_stats(src, &stats);
+    printf("[bench] adc_source host: %lu samples/s, %lu dropped frames (chk %lu)\n",
+           (unsigned long)stats.samples_per_sec, (unsigned long)stats.dropped_frames, (unsigned long)sum);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.dropped_frames);
+    adc_source_del(src);
+}
+
+TEST_CASE("host waves are deterministic and stay in range", "[adc_source]")
+{
+    adc_host_wave_t sine = {
+        .kind = ADC_HOST_WAVE_SINE, .sample_rate_hz = 1000, .freq_hz = 10,
+        .amplitude = 1000, .offset = 2048,
+    };
+    // Quarter period of 10 Hz at 1 kHz = 25 samples; channel 0 has no phase shift
+    TEST_ASSERT_EQUAL_UINT16(2048, adc_host_wave_signal(0, 0, &sine));
+    TEST_ASSERT_EQUAL_UINT16(3048, adc_host_wave_signal(0, 25, &sine));
+    TEST_ASSERT_EQUAL_UINT16(1048, adc_host_wave_signal(0, 75, &sine));
+
+    adc_host_wave_t steps = {
+        .kind = ADC_HOST_WAVE_STEPS, .sample_rate_hz = 1000, .freq_hz = 4,
+        .amplitude = 1000, .offset = 2000,
+    };
+    TEST_ASSERT_EQUAL_UINT16(1500, adc_host_wave_signal(0, 0, &steps));
+    TEST_ASSERT_EQUAL_UINT16(1500, adc_host_wave_signal(0, 249, &steps));
+    TEST_ASSERT_EQUAL_UINT16(2500, adc_host_wave_signal(0, 250, &steps));
+
+    adc_host_wave_t noise = {
+        .kind = ADC_HOST_WAVE_NOISE, .sample_rate_hz = 1000,
+        .amplitude = 3000, .offset = 2048, .seed = 7,
+    };
+    double sum = 0;
+    uint16_t lo = 4095, hi = 0;
+    for (uint64_t n = 0; n < 20000; n++) {
+        uint16_t v = adc_host_wave_signal(1, n, &noise);
+        TEST_ASSERT_EQUAL_UINT16(v, adc_host_wave_signal(1, n, &noise));
+        sum += v;
+        lo = (v < lo) ? v : lo;
+        hi = (v > hi) ? v : hi;
+    }
+    // +-3000 around 2048 clips at both ends of the 12-bit range
+    TEST_ASSERT_EQUAL_UINT16(0, lo);
+    TEST_ASSERT_EQUAL_UINT16(4095, hi);
+    TEST_ASSERT_FLOAT_WITHIN(100, 2048, sum / 20000);
+    TEST_ASSERT_NOT_EQUAL(adc_host_wave_signal(0, 5, &noise), adc_host_wave_signal(1, 5, &noise));
+}
+
+static void write_file(const char *path, const void *data, size_t len)
+{
+    FILE *f = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    TEST_ASSERT_EQUAL(len, fwrite(data, 1, len, f));
+    fclose(f);
+}
+
+TEST_CASE("host replay loads csv and binary captures", "[adc_source]")
+{
+    adc_source_config_t cfg = {
+        .sample_rate_hz = 1000,
+        .frame_samples = 4,
+        .num_channels = 2,
+        .channels = { { .channel = 6 }, { .channel = 3 } },
+    };
+    adc_host_replay_t rp;
+
+    // Plain table with a header; out-of-range codes are clamped
+    const char table[] = "ch6,ch3\n100,200\n101,201\n5000,-3\n";
+    write_file("/tmp/adc_replay_test.csv", table, sizeof(table) - 1);
+    TEST_ASSERT_EQUAL(ESP_OK, adc_host_replay_load(&rp, "/tmp/adc_replay_test.csv", &cfg));
+    TEST_ASSERT_EQUAL(3, rp.num_scans);
+    TEST_ASSERT_EQUAL_UINT32(2, rp.num_columns);
+    TEST_ASSERT_EQUAL_UINT16(101, adc_host_replay_signal(6, 1, &rp));
+    TEST_ASSERT_EQUAL_UINT16(201, adc_host_replay_signal(3, 1, &rp));
+    TEST_ASSERT_EQUAL_UINT16(4095, adc_host_replay_signal(6, 2, &rp));
+    TEST_ASSERT_EQUAL_UINT16(0, adc_host_replay_signal(3, 2, &rp));
+    TEST_ASSERT_EQUAL_UINT16(100, adc_host_replay_signal(6, 3, &rp));   // Loops
+    adc_host_replay_free(&rp);
+
+    // stream_reader.py --csv output: columns follow channel ids in order of
+    // appearance, and the values are mV (kept past 4095, left for the caller)
+    const char stream[] =
+        "channel,seq,timestamp_us,index,value\n"
+        "6,0,0,0,3300\n6,0,0,1,5000\n3,0,0,0,900\n3,0,0,1,901\n3,1,2000,2,902\n";
+    write_file("/tmp/adc_replay_test.csv", stream, sizeof(stream) - 1);
+    TEST_ASSERT_EQUAL(ESP_OK, adc_host_replay_load(&rp, "/tmp/adc_replay_test.csv", &cfg));
+    TEST_ASSERT_TRUE(rp.in_mv);
+    TEST_ASSERT_EQUAL(2, rp.num_scans);                                 // Cut to the shorter channel
+    TEST_ASSERT_EQUAL_UINT16(5000, adc_host_replay_signal(6, 1, &rp));
+    TEST_ASSERT_EQUAL_UINT16(901, adc_host_replay_signal(3, 1, &rp));
+    adc_host_replay_free(&rp);
+
+    // Raw interleaved little-endian codes; the trailing half scan is ignored
+    const uint8_t raw[] = { 0x10, 0x00, 0x20, 0x00, 0xFF, 0x0F, 0x00, 0x01, 0x33, 0x00 };
+    write_file("/tmp/adc_replay_test.bin", raw, sizeof(raw));
+    TEST_ASSERT_EQUAL(ESP_OK, adc_host_replay_load(&rp, "/tmp/adc_replay_test.bin", &cfg));
+    TEST_ASSERT_EQUAL(2, rp.num_scans);
+    TEST_ASSERT_EQUAL_UINT16(0x10, adc_host_replay_signal(6, 0, &rp));
+    TEST_ASSERT_EQUAL_UINT16(0x100, adc_host_replay_signal(3, 1, &rp));
+    adc_host_replay_free(&rp);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_FOUND, adc_host_replay_load(&rp, "/tmp/adc_replay_missing.bin", &cfg));
+    remove("/tmp/adc_replay_test.csv");
+    remove("/tmp/adc_replay_test.bin");
+}
+
+TEST_CASE("host replay rejects rows it cannot read whole", "[adc_source]")
+{
+    adc_source_config_t cfg = {
+        .sample_rate_hz = 1000,
+        .frame_samples = 4,
+        .num_channels = 1,
+        .channels = { { .channel = 6 } },
+    };
+    adc_host_replay_t rp;
+
+    // Eight columns is the limit; a ninth is not dropped silently
+    const char eight[] = "1,2,3,4,5,6,7,8\n";
+    write_file("/tmp/adc_replay_test.csv", eight, sizeof(eight) - 1);
+    TEST_ASSERT_EQUAL(ESP_OK, adc_host_replay_load(&rp, "/tmp/adc_replay_test.csv", &cfg));
+    TEST_ASSERT_EQUAL_UINT32(8, rp.num_columns);
+    adc_host_replay_free(&rp);
+
+    const char nine[] = "1,2,3,4,5,6,7,8,9\n";
+    write_file("/tmp/adc_replay_test.csv", nine, sizeof(nine) - 1);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, adc_host_replay_load(&rp, "/tmp/adc_replay_test.csv", &cfg));
+
+    const char junk[] = "100,200\n101,201x\n";
+    write_file("/tmp/adc_replay_test.csv", junk, sizeof(junk) - 1);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, adc_host_replay_load(&rp, "/tmp/adc_replay_test.csv", &cfg));
+
+    // A line longer than the read buffer, in both csv layouts; the last line
+    // may still end without a newline
+    char text[600];
+    int len = snprintf(text, sizeof(text), "100,200\n%0300d,1\n", 7);
+    write_file("/tmp/adc_replay_test.csv", text, (size_t)len);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, adc_host_replay_load(&rp, "/tmp/adc_replay_test.csv", &cfg));
+
+    len = snprintf(text, sizeof(text), "channel,seq,timestamp_us,index,value\n6,0,0,0,%0300d\n", 7);
+    write_file("/tmp/adc_replay_test.csv", text, (size_t)len);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, adc_host_replay_load(&rp, "/tmp/adc_replay_test.csv", &cfg));
+
+    const char no_newline[] = "100,200\n101,201";
+    write_file("/tmp/adc_replay_test.csv", no_newline, sizeof(no_newline) - 1);
+    TEST_ASSERT_EQUAL(ESP_OK, adc_host_replay_load(&rp, "/tmp/adc_replay_test.csv", &cfg));
+    TEST_ASSERT_EQUAL(2, rp.num_scans);
+    adc_host_replay_free(&rp);
+    remove("/tmp/adc_replay_test.csv");
+}
+
+TEST_CASE("host source speed runs the realtime clock faster", "[adc_source]")
+{
+    adc_source_config_t cfg = {
+        .sample_rate_hz = 1000,
+        .frame_samples = 50,         // 50 ms per frame at speed 1
+    };
+    adc_host_source_config_t host_cfg = {
+        .signal = ramp_signal,
+        .realtime = true,
+        .speed = 50,                 // 1 ms per frame
+    };
+    adc_source_t *src = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, adc_source_new_host(&cfg, &host_cfg, &src));
+    TEST_ASSERT_EQUAL(ESP_OK, adc_source_start(src));
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    adc_frame_t frame;
+    for (int f = 0; f < 40; f++) {
+        TEST_ASSERT_EQUAL(ESP_OK, adc_source_read(src, &frame, 100));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+
+    // 40 frames = 2 s of signal, paced into ~40 ms of wall time
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(35, (uint32_t)ms);
+    TEST_ASSERT_LESS_THAN_UINT32(1000, (uint32_t)ms);
+    TEST_ASSERT_EQUAL_UINT16((39 * 50) & 0x0FFF, frame.data[0]);
+    adc_source_del(src);
+}
@@ -0,0 +1,414 @@
+// =============================
+// Tests: block_pipe (zero-copy block pipeline)
+// =============================
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "unity.h"
+#include "block_pipe.h"
+#include "adc_cali_lut.h"
+#include "filter_chain.h"
+#include "stream_proto.h"
+#include "bench.h"
+
+#define TEST_CHANNELS   3
+#define TEST_SAMPLES    100
+#define TEST_DEPTH      4
+#define TEST_BLOCKS     500
+
+typedef struct {
+    uint32_t next_seq;                      // Next sequence number expected
+    uint32_t out_of_order;
+    uint32_t bad_data;
+    pipe_block_t *seen[TEST_BLOCKS];        // Block pointer that carried each seq
+} flow_ctx_t;
+
+static void stage_check_order(pipe_block_t *blk, void *ctx)
+{
+    flow_ctx_t *f = (flow_ctx_t *)ctx;
+    if (blk->seq != f->next_seq) {
+        f->out_of_order++;
+    }
+    f->next_seq = blk->seq + 1;
+    if (blk->seq < TEST_BLOCKS) {
+        f->seen[blk->seq] = blk;
+    }
+}
+
+static void stage_add_one(pipe_block_t *blk, void *ctx)
+{
+    for (uint32_t c = 0; c < blk->num_channels; c++) {
+        for (size_t i = 0; i < blk->len[c]; i++) {
+            blk->data[c][i] += 1;
+        }
+    }
+}
+
+// The producer wrote seq + c + i; stage 1 added one in place
+static void stage_verify(pipe_block_t *blk, void *ctx)
+{
+    stage_check_order(blk, ctx);
+    flow_ctx_t *f = (flow_ctx_t *)ctx;
+    for (uint32_t c = 0; c < blk->num_channels; c++) {
+        for (size_t i = 0; i < blk->len[c]; i++) {
+            if (blk->data[c][i] != (int16_t)(blk->seq + c + i + 1)) {
+                f->bad_data++;
+                return;
+            }
+        }
+    }
+}
+
+static void stage_nop(pipe_block_t *blk, void *ctx)
+{
+}
+
+static block_pipe_config_t make_config(uint32_t depth, uint32_t num_stages, block_pipe_stage_fn_t fn)
+{
+    block_pipe_config_t cfg = {
+        .num_channels = TEST_CHANNELS,
+        .block_samples = TEST_SAMPLES,
+        .depth = depth,
+        .num_stages = num_stages,
+    };
+    for (uint32_t s = 0; s < num_stages; s++) {
+        cfg.stages[s] = (block_pipe_stage_cfg_t) {
+            .name = "test stage", .fn = fn, .core = tskNO_AFFINITY, .priority = 5, .stack = 4096,
+        };
+    }
+    return cfg;
+}
+
+TEST_CASE("block pipe keeps order and hands over pointers only", "[block_pipe]")
+{
+    static flow_ctx_t first, last;
+    memset(&first, 0, sizeof(first));
+    memset(&last, 0, sizeof(last));
+
+    block_pipe_config_t cfg = make_config(TEST_DEPTH, 3, stage_add_one);
+    cfg.stages[0].fn = stage_check_order;
+    cfg.stages[0].ctx = &first;
+    cfg.stages[2].fn = stage_verify;
+    cfg.stages[2].ctx = &last;
+
+    block_pipe_t *pipe = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, block_pipe_new(&cfg, &pipe));
+    TEST_ASSERT_EQUAL(ESP_OK, block_pipe_start(pipe));
+
+    for (uint32_t k = 0; k < TEST_BLOCKS; k++) {
+        pipe_block_t *blk = block_pipe_acquire(pipe, portMAX_DELAY);
+        TEST_ASSERT_NOT_NULL(blk);
+        for (uint32_t c = 0; c < TEST_CHANNELS; c++) {
+            TEST_ASSERT_EQUAL_UINT32(0, blk->len[c]);
+            for (size_t i = 0; i < TEST_SAMPLES; i++) {
+                blk->data[c][i] = (int16_t)(k + c + i);
+            }
+            blk->len[c] = TEST_SAMPLES;
+        }
+        blk->seq = k;
+        block_pipe_submit(pipe, blk);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, block_pipe_stop(pipe));
+
+    TEST_ASSERT_EQUAL_UINT32(TEST_BLOCKS, last.next_seq);
+    TEST_ASSERT_EQUAL_UINT32(0, first.out_of_order);
+    TEST_ASSERT_EQUAL_UINT32(0, last.out_of_order);
+    TEST_ASSERT_EQUAL_UINT32(0, last.bad_data);
+
+    // Zero-copy: the last stage saw the very block the first one saw,
+    // and only TEST_DEPTH distinct blocks were ever used
+    uint32_t distinct = 0;
+    pipe_block_t *ptrs[TEST_DEPTH];
+    for (uint32_t k = 0; k < TEST_BLOCKS; k++) {
+        TEST_ASSERT_EQUAL_PTR(first.seen[k], last.seen[k]);
+        uint32_t j = 0;
+        while (j < distinct && ptrs[j] != last.seen[k]) {
+            j++;
+        }
+        if (j == distinct) {
+            TEST_ASSERT_LESS_THAN_UINT32(TEST_DEPTH, distinct);
+            ptrs[distinct++] = last.seen[k];
+        }
+    }
+
+    block_pipe_stats_t stats;
+    block_pipe_get_stats(pipe, &stats);
+    TEST_ASSERT_EQUAL_UINT32(TEST_BLOCKS, stats.submitted);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.starved);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(TEST_DEPTH, stats.in_flight_max);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.num_stages);
+    for (uint32_t s = 0; s < 3; s++) {
+        TEST_ASSERT_EQUAL_UINT32(TEST_BLOCKS, stats.stage[s].blocks);
+        TEST_ASSERT_EQUAL_UINT64((uint64_t)TEST_BLOCKS * TEST_CHANNELS * TEST_SAMPLES, stats.stage[s].samples);
+    }
+    block_pipe_del(pipe);
+}
+
+TEST_CASE("block pipe reports starvation when every block is out", "[block_pipe]")
+{
+    block_pipe_config_t cfg = make_config(3, 1, stage_nop);
+    block_pipe_t *pipe = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, block_pipe_new(&cfg, &pipe));
+    TEST_ASSERT_EQUAL(ESP_OK, block_pipe_start(pipe));
+
+    pipe_block_t *held[3];
+    for (int i = 0; i < 3; i++) {
+        held[i] = block_pipe_acquire(pipe, 0);
+        TEST_ASSERT_NOT_NULL(held[i]);
+    }
+    TEST_ASSERT_NULL(block_pipe_acquire(pipe, 0));
+    TEST_ASSERT_NULL(block_pipe_acquire(pipe, pdMS_TO_TICKS(10)));
+
+    for (int i = 0; i < 3; i++) {
+        held[i]->seq = i;
+        block_pipe_submit(pipe, held[i]);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, block_pipe_stop(pipe));
+
+    // Back in the pool after the last stage
+    pipe_block_t *again = block_pipe_acquire(pipe, 0);
+    TEST_ASSERT_NOT_NULL(again);
+
+    block_pipe_stats_t stats;
+    block_pipe_get_stats(pipe, &stats);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.starved);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.in_flight_max);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.stage[0].blocks);
+    block_pipe_del(pipe);
+}
+
+TEST_CASE("block pipe runs are aligned and disjoint", "[block_pipe]")
+{
+    block_pipe_config_t cfg = make_config(TEST_DEPTH, 1, stage_nop);
+    cfg.block_samples = 37;     // Not a multiple of the alignment
+    block_pipe_t *pipe = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, block_pipe_new(&cfg, &pipe));
+
+    const int16_t *runs[TEST_DEPTH * TEST_CHANNELS];
+    int n = 0;
+    for (int b = 0; b < TEST_DEPTH; b++) {
+        pipe_block_t *blk = block_pipe_acquire(pipe, 0);
+        TEST_ASSERT_NOT_NULL(blk);
+        TEST_ASSERT_EQUAL_UINT32(TEST_CHANNELS, blk->num_channels);
+        for (int c = 0; c < TEST_CHANNELS; c++) {
+            TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)blk->data[c] % 16);
+            runs[n++] = blk->data[c];
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            if (i != j) {
+                TEST_ASSERT_TRUE(runs[i] + 37 <= runs[j] || runs[j] + 37 <= runs[i]);
+            }
+        }
+    }
+    block_pipe_del(pipe);       // Never started: nothing to stop
+}
+
+TEST_CASE("block pipe rejects bad configurations", "[block_pipe]")
+{
+    block_pipe_t *pipe = NULL;
+    block_pipe_config_t cfg = make_config(1, 1, stage_nop);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, block_pipe_new(&cfg, &pipe));       // Depth 1: nothing to overlap
+
+    cfg = make_config(2, 0, stage_nop);
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, block_pipe_new(&cfg, &pipe));
+
+    cfg = make_config(2, 2, stage_nop);
+    cfg.stages[1].fn = NULL;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, block_pipe_new(&cfg, &pipe));
+
+    cfg = make_config(2, 1, stage_nop);
+    cfg.num_channels = BLOCK_PIPE_MAX_CHANNELS + 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, block_pipe_new(&cfg, &pipe));
+    TEST_ASSERT_NULL(pipe);
+}
+
+TEST_CASE("block pipe capacity follows the busiest core", "[block_pipe]")
+{
+    const uint32_t ns[3] = {100, 200, 300};
+    const BaseType_t split[3] = {0, 1, 1};
+    const BaseType_t single[3] = {0, 0, tskNO_AFFINITY};
+
+    // All on core 0: 600 ns/sample, 80% of 1 s / 600 ns
+    TEST_ASSERT_EQUAL_UINT32(1333333, block_pipe_capacity_hz(ns, single, 3, 80));
+#if portNUM_PROCESSORS > 1
+    // Core 1 carries 500 ns/sample
+    TEST_ASSERT_EQUAL_UINT32(1600000, block_pipe_capacity_hz(ns, split, 3, 80));
+#else
+    // No core 1 (linux port): everything lands on core 0
+    TEST_ASSERT_EQUAL_UINT32(1333333, block_pipe_capacity_hz(ns, split, 3, 80));
+#endif
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, block_pipe_capacity_hz(ns, split, 0, 80));
+}
+
+// =============================
+// Benchmark
+// =============================
+// The firmware's work per block pushed through a real pipeline as fast as it
+// goes: the producer converts raw codes through the table (acquisition), stage
+// 0 runs the default filter chain, stage 1 encodes the binary frames (output).
+// One run with the stages pinned to core 0 next to the producer, and on a
+// multi-core build one with the stages on core 1. The linux FreeRTOS port has
+// a single core, so that comparison only runs in target_test/ on an ESP32.
+// Each run measures the sustained scan rate and what every
+// task spent per sample; the capacity model fed with those costs is printed
+// next to it. The tasks sharing a core run one at a time, so if the placement
+// is real the model at 100% load bounds what was measured.
+#define BENCH_SAMPLES   256
+#define BENCH_ROUNDS    2000
+#define BENCH_CHANNELS  4
+
+typedef struct {
+    int16_t ma_hist[BENCH_CHANNELS][5];
+    filter_biquad_t notch[BENCH_CHANNELS][1];
+    filter_biquad_t lowpass[BENCH_CHANNELS][1];
+    filter_stage_t stages[BENCH_CHANNELS][3];
+    filter_chain_t chain[BENCH_CHANNELS];
+    uint8_t wire[STREAM_WIRE_MAX_SIZE];
+} bench_ctx_t;
+
+typedef struct {
+    double   scans_per_s;                // Sustained, producer start to last block out
+    uint32_t ns[3];                      // Per sample: acquire, filter, output
+    block_pipe_stats_t stats;
+} bench_run_t;
+
+static esp_err_t bench_raw_to_mv(void *ctx, int raw, int *mv)
+{
+    *mv = raw * 3300 / 4095;
+    return ESP_OK;
+}
+
+// The firmware's default chain per channel: average, notch, low-pass
+static void bench_init_filters(bench_ctx_t *b)
+{
+    for (int c = 0; c < BENCH_CHANNELS; c++) {
+        TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_moving_avg(&b->stages[c][0], b->ma_hist[c], 5));
+        TEST_ASSERT_EQUAL(ESP_OK, filter_biquad_design(FILTER_BIQUAD_NOTCH, 20000, 50, 30, &b->notch[c][0]));
+        TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_biquad(&b->stages[c][1], b->notch[c], 1));
+        TEST_ASSERT_EQUAL(ESP_OK, filter_biquad_design(FILTER_BIQUAD_LOWPASS, 20000, 1000, 0.7071f, &b->lowpass[c][0]));
+        TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_biquad(&b->stages[c][2], b->lowpass[c], 1));
+        b->chain[c] = (filter_chain_t) { .stages = b->stages[c], .num_stages = 3 };
+    }
+}
+
+static void bench_stage_filter(pipe_block_t *blk, void *ctx)
+{
+    bench_ctx_t *b = (bench_ctx_t *)ctx;
+    for (uint32_t c = 0; c < blk->num_channels; c++) {
+        filter_chain_process(&b->chain[c], blk->data[c], blk->len[c]);
+    }
+}
+
+static void bench_stage_output(pipe_block_t *blk, void *ctx)
+{
+    bench_ctx_t *b = (bench_ctx_t *)ctx;
+    for (uint32_t c = 0; c < blk->num_channels; c++) {
+        stream_frame_hdr_t hdr = { .encoding = STREAM_ENC_AUTO, .channel = c, .count = blk->len[c], .seq = blk->seq };
+        size_t len = 0;
+        stream_proto_encode(&hdr, blk->data[c], b->wire, sizeof(b->wire), &len);
+    }
+}
+
+static void bench_pipeline(bench_ctx_t *b, adc_cali_lut_t *lut, const uint16_t *raw, BaseType_t stage_core,
+                           bench_run_t *run)
+{
+    block_pipe_config_t cfg = {
+        .num_channels = BENCH_CHANNELS,
+        .block_samples = BENCH_SAMPLES,
+        .depth = TEST_DEPTH,
+        .num_stages = 2,
+    };
+    cfg.stages[0] = (block_pipe_stage_cfg_t) {
+        .name = "bench filter", .fn = bench_stage_filter, .ctx = b, .core = stage_core, .priority = 5, .stack = 4096,
+    };
+    cfg.stages[1] = (block_pipe_stage_cfg_t) {
+        .name = "bench output", .fn = bench_stage_output, .ctx = b, .core = stage_core, .priority = 5, .stack = 4096,
+    };
+    bench_init_filters(b);
+
+    block_pipe_t *pipe = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, block_pipe_new(&cfg, &pipe));
+    TEST_ASSERT_EQUAL(ESP_OK, block_pipe_start(pipe));
+
+    // --- Producer: waits for a free block, so the slowest task sets the pace ---
+    int64_t acq_us = 0;
+    int64_t t0 = bench_now_us();
+    for (uint32_t k = 0; k < BENCH_ROUNDS; k++) {
+        pipe_block_t *blk = block_pipe_acquire(pipe, portMAX_DELAY);
+        TEST_ASSERT_NOT_NULL(blk);
+        int64_t a0 = bench_now_us();
+        for (int c = 0; c < BENCH_CHANNELS; c++) {
+            adc_cali_lut_raw_to_mv_block(lut, raw, blk->data[c], BENCH_SAMPLES);
+            blk->len[c] = BENCH_SAMPLES;
+        }
+        acq_us += bench_now_us() - a0;
+        blk->seq = k;
+        block_pipe_submit(pipe, blk);
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, block_pipe_stop(pipe));       // Returns once the last block is out
+    int64_t elapsed_us = bench_now_us() - t0;
+
+    block_pipe_get_stats(pipe, &run->stats);
+    block_pipe_del(pipe);
+
+    const uint64_t samples = (uint64_t)BENCH_ROUNDS * BENCH_CHANNELS * BENCH_SAMPLES;
+    run->scans_per_s = (double)BENCH_ROUNDS * BENCH_SAMPLES * 1e6 / (double)elapsed_us;
+    run->ns[0] = (uint32_t)(acq_us * 1000 / samples);
+    run->ns[1] = (uint32_t)(run->stats.stage[0].busy_us * 1000 / samples);
+    run->ns[2] = (uint32_t)(run->stats.stage[1].busy_us * 1000 / samples);
+}
+
+// Returns the model's scan rate for the run's costs on this placement
+static double bench_print(const char *name, const bench_run_t *run, const BaseType_t *core)
+{
+    uint32_t model = block_pipe_capacity_hz(run->ns, core, 3, 100) / BENCH_CHANNELS;
+    printf("[bench] block_pipe %s: %.0f scans/s sustained (model %lu at 100%% load), "
+           "acquire %lu, filter %lu, output %lu ns/sample\n",
+           name, run->scans_per_s, (unsigned long)model,
+           (unsigned long)run->ns[0], (unsigned long)run->ns[1], (unsigned long)run->ns[2]);
+    return model;
+}
+
+TEST_CASE("block pipe sustained rate with pinned stages", "[block_pipe][bench]")
+{
+    static uint16_t raw[BENCH_SAMPLES];
+    static bench_ctx_t ctx;
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        raw[i] = (uint16_t)(2048 + 1500 * sin(2 * M_PI * i / 64.0));
+    }
+    adc_cali_lut_t *lut = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, adc_cali_lut_new(12, bench_raw_to_mv, NULL, &lut));
+
+    // --- One core: producer and both stages share core 0 ---
+    const BaseType_t one_core[3] = {0, 0, 0};
+    bench_run_t single;
+    bench_pipeline(&ctx, lut, raw, 0, &single);
+    double model = bench_print("one core ", &single, one_core);
+
+    // Every block went through both stages, and never more than the pool was out
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ROUNDS, single.stats.submitted);
+    TEST_ASSERT_EQUAL_UINT32(0, single.stats.starved);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ROUNDS, single.stats.stage[0].blocks);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ROUNDS, single.stats.stage[1].blocks);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(TEST_DEPTH, single.stats.in_flight_max);
+    // Busy times of one core add up to at most the run time (10% for the
+    // microsecond clock the stages time each block with)
+    TEST_ASSERT_LESS_THAN_FLOAT(1.1 * model, single.scans_per_s);
+
+#if portNUM_PROCESSORS > 1
+    // --- Two cores: the stages move to core 1; only core 1's share bounds the rate ---
+    const BaseType_t two_cores[3] = {0, 1, 1};
+    bench_run_t dual;
+    bench_pipeline(&ctx, lut, raw, 1, &dual);
+    model = bench_print("two cores", &dual, two_cores);
+    printf("[bench] block_pipe two cores / one core: x%.2f measured\n", dual.scans_per_s / single.scans_per_s);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_ROUNDS, dual.stats.stage[1].blocks);
+    TEST_ASSERT_LESS_THAN_FLOAT(1.1 * model, dual.scans_per_s);
+#endif
+    adc_cali_lut_del(lut);
+}
@@ -0,0 +1,405 @@
+// =============================
+// Tests: filter_chain
+// =============================
+// Fixed-point stages are checked against double-precision references fed
+// with the same (quantised) coefficients.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "filter_chain.h"
+#include "bench.h"
+
+#define TEST_FS      1000.0
+#define TEST_LEN     4000
+
+static void make_signal(int16_t *out, size_t n)
+{
+    srand(1234);
+    for (size_t i = 0; i < n; i++) {
+        double t = i / TEST_FS;
+        double v = 1500 + 600 * sin(2 * M_PI * 5 * t) + 400 * sin(2 * M_PI * 50 * t) + (rand() % 101 - 50);
+        out[i] = (int16_t)lround(v);
+    }
+}
+
+// Feeds `block` through the stage in chunks of pseudo-random size
+static void process_chunked(filter_stage_t *stage, int16_t *block, size_t n)
+{
+    size_t done = 0;
+    unsigned chunk = 1;
+    while (done < n) {
+        chunk = (chunk * 7 + 3) % 97 + 1;
+        size_t len = (n - done < chunk) ? n - done : chunk;
+        filter_stage_process(stage, block + done, len);
+        done += len;
+    }
+}
+
+static void biquad_reference(const filter_biquad_t *c, const int16_t *in, double *out, size_t n)
+{
+    const double s = (double)(1 << FILTER_BIQUAD_COEFF_SHIFT);
+    double b0 = c->b0 / s, b1 = c->b1 / s, b2 = c->b2 / s, a1 = c->a1 / s, a2 = c->a2 / s;
+    double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+    for (size_t i = 0; i < n; i++) {
+        double y = b0 * in[i] + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        x2 = x1;
+        x1 = in[i];
+        y2 = y1;
+        y1 = y;
+        out[i] = y;
+    }
+}
+
+static int max_abs_error(const int16_t *got, const double *ref, size_t n)
+{
+    int worst = 0;
+    for (size_t i = 0; i < n; i++) {
+        int e = abs((int)got[i] - (int)lround(ref[i]));
+        if (e > worst) {
+            worst = e;
+        }
+    }
+    return worst;
+}
+
+TEST_CASE("moving average matches the direct sum for any block size", "[filter_chain]")
+{
+    static int16_t in[TEST_LEN], out[TEST_LEN];
+    static int16_t hist[37];
+    make_signal(in, TEST_LEN);
+    memcpy(out, in, sizeof(in));
+
+    filter_stage_t stage;
+    TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_moving_avg(&stage, hist, 37));
+    process_chunked(&stage, out, TEST_LEN);
+
+    for (int i = 0; i < TEST_LEN; i++) {
+        int32_t sum = 0;
+        for (int k = 0; k < 37; k++) {
+            sum += (i - k >= 0) ? in[i - k] : 0;
+        }
+        TEST_ASSERT_EQUAL_INT(sum / 37, out[i]);
+    }
+}
+
+TEST_CASE("biquad low/band/high-pass track the float reference", "[filter_chain]")
+{
+    static int16_t in[TEST_LEN], out[TEST_LEN];
+    static double ref[TEST_LEN];
+    make_signal(in, TEST_LEN);
+
+    const filter_biquad_type_t types[] = { FILTER_BIQUAD_LOWPASS, FILTER_BIQUAD_BANDPASS, FILTER_BIQUAD_HIGHPASS };
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+        filter_biquad_t bq[1];
+        TEST_ASSERT_EQUAL(ESP_OK, filter_biquad_design(types[t], TEST_FS, 20, 0.707f, &bq[0]));
+        biquad_reference(&bq[0], in, ref, TEST_LEN);
+
+        filter_stage_t stage;
+        TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_biquad(&stage, bq, 1));
+        memcpy(out, in, sizeof(in));
+        process_chunked(&stage, out, TEST_LEN);
+
+        TEST_ASSERT_LESS_OR_EQUAL(1, max_abs_error(out, ref, TEST_LEN));
+    }
+}
+
+TEST_CASE("biquad notch removes 50 Hz mains", "[filter_chain]")
+{
+    static int16_t in[TEST_LEN], out[TEST_LEN];
+    for (int i = 0; i < TEST_LEN; i++) {
+        in[i] = (int16_t)lround(1000 * sin(2 * M_PI * 50 * i / TEST_FS));
+    }
+
+    // Two cascaded notch sections for a deeper null
+    filter_biquad_t bq[2];
+    TEST_ASSERT_EQUAL(ESP_OK, filter_biquad_design(FILTER_BIQUAD_NOTCH, TEST_FS, 50, 5, &bq[0]));
+    TEST_ASSERT_EQUAL(ESP_OK, filter_biquad_design(FILTER_BIQUAD_NOTCH, TEST_FS, 50, 5, &bq[1]));
+
+    filter_stage_t stage;
+    TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_biquad(&stage, bq, 2));
+    memcpy(out, in, sizeof(in));
+    filter_stage_process(&stage, out, TEST_LEN);
+
+    // After settling, less than 1% of the mains amplitude is left
+    int peak = 0;
+    for (int i = TEST_LEN / 2; i < TEST_LEN; i++) {
+        peak = (abs(out[i]) > peak) ? abs(out[i]) : peak;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(10, peak);
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, filter_biquad_design(FILTER_BIQUAD_NOTCH, 100, 50, 5, &bq[0]));
+}
+
+// =============================
+// Mains notch as the firmware designs it
+// =============================
+// init_filters() uses fs = 20 kHz, Q = 30: the poles sit right at the unit
+// circle, where coefficient quantisation and state rounding matter most.
+#define NOTCH_FS     20000.0
+#define NOTCH_Q      30.0
+#define NOTCH_LEN    80000      // 4 s; the notch settles in about 0.2 s
+#define NOTCH_TAIL   20000      // Measured over the last second: whole cycles of every tone
+
+// |H| of the unquantised design at f
+static double notch_gain(double f)
+{
+    double w0 = 2 * M_PI * 50 / NOTCH_FS, w = 2 * M_PI * f / NOTCH_FS;
+    double alpha = sin(w0) / (2 * NOTCH_Q), cw0 = cos(w0);
+    double nr = 1 - 2 * cw0 * cos(w) + cos(2 * w), ni = 2 * cw0 * sin(w) - sin(2 * w);
+    double dr = (1 + alpha) - 2 * cw0 * cos(w) + (1 - alpha) * cos(2 * w);
+    double di = 2 * cw0 * sin(w) - (1 - alpha) * sin(2 * w);
+    return sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+}
+
+static double tone_amplitude(const int16_t *y, size_t n, double f)
+{
+    double s = 0, c = 0;
+    for (size_t i = 0; i < n; i++) {
+        s += y[i] * sin(2 * M_PI * f * i / NOTCH_FS);
+        c += y[i] * cos(2 * M_PI * f * i / NOTCH_FS);
+    }
+    return 2 * sqrt(s * s + c * c) / n;
+}
+
+TEST_CASE("biquad notch at the firmware design tracks double precision", "[filter_chain]")
+{
+    static int16_t in[NOTCH_LEN], out[NOTCH_LEN];
+    filter_biquad_t bq[1];
+    filter_stage_t stage;
+
+    // --- Depth at 50 Hz and gain around it, on a 1000 mV tone over 1650 mV DC ---
+    const double freqs[] = { 50, 10, 45, 49, 51, 55, 200, 1000 };
+    for (size_t k = 0; k < sizeof(freqs) / sizeof(freqs[0]); k++) {
+        TEST_ASSERT_EQUAL(ESP_OK, filter_biquad_design(FILTER_BIQUAD_NOTCH, NOTCH_FS, 50, NOTCH_Q, &bq[0]));
+        TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_biquad(&stage, bq, 1));
+        for (int i = 0; i < NOTCH_LEN; i++) {
+            out[i] = (int16_t)lround(1650 + 1000 * sin(2 * M_PI * freqs[k] * i / NOTCH_FS));
+        }
+        filter_stage_process(&stage, out, NOTCH_LEN);
+
+        double gain = tone_amplitude(out + NOTCH_LEN - NOTCH_TAIL, NOTCH_TAIL, freqs[k]) / 1000;
+        if (freqs[k] == 50) {
+            TEST_ASSERT_LESS_OR_EQUAL(1000, (int)lround(1e6 * gain));     // >= 60 dB
+        } else {
+            TEST_ASSERT_DOUBLE_WITHIN(0.002, notch_gain(freqs[k]), gain);
+        }
+    }
+
+    // --- Sample by sample against the unquantised filter in double precision ---
+    srand(99);
+    for (int i = 0; i < NOTCH_LEN; i++) {
+        double t = i / NOTCH_FS;
+        in[i] = (int16_t)lround(1650 + 700 * sin(2 * M_PI * 10 * t) + 300 * sin(2 * M_PI * 50 * t) + (rand() % 41 - 20));
+    }
+    double w0 = 2 * M_PI * 50 / NOTCH_FS, alpha = sin(w0) / (2 * NOTCH_Q), a0 = 1 + alpha;
+    double b0 = 1 / a0, b1 = -2 * cos(w0) / a0, a1 = b1, a2 = (1 - alpha) / a0;
+    double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+
+    TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_biquad(&stage, bq, 1));
+    memcpy(out, in, sizeof(in));
+    process_chunked(&stage, out, NOTCH_LEN);
+
+    int worst = 0;
+    for (int i = 0; i < NOTCH_LEN; i++) {
+        double y = b0 * in[i] + b1 * x1 + b0 * x2 - a1 * y1 - a2 * y2;
+        x2 = x1;
+        x1 = in[i];
+        y2 = y1;
+        y1 = y;
+        int e = abs(out[i] - (int)lround(y));
+        worst = (i >= NOTCH_LEN / 2 && e > worst) ? e : worst;
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(1, worst);
+}
+
+#define FIR_TAPS 15
+
+TEST_CASE("fir matches the float reference and takes runtime coefficients", "[filter_chain]")
+{
+    static int16_t in[TEST_LEN], out[TEST_LEN];
+    static double ref[TEST_LEN];
+    make_signal(in, TEST_LEN);
+
+    // 15-tap Hamming-windowed low-pass, cut-off 30 Hz
+    static int16_t coeffs[FIR_TAPS];
+    static int16_t delay[2 * FIR_TAPS];
+    for (int k = 0; k < FIR_TAPS; k++) {
+        double m = k - (FIR_TAPS - 1) / 2.0;
+        double fc = 30.0 / TEST_FS;
+        double h = (m == 0) ? 2 * fc : sin(2 * M_PI * fc * m) / (M_PI * m);
+        h *= 0.54 - 0.46 * cos(2 * M_PI * k / (FIR_TAPS - 1));
+        coeffs[k] = (int16_t)lround(h * 32768);
+    }
+
+    for (int i = 0; i < TEST_LEN; i++) {
+        double acc = 0;
+        for (int k = 0; k < FIR_TAPS; k++) {
+            acc += (i - k >= 0) ? coeffs[k] * (double)in[i - k] : 0;
+        }
+        ref[i] = acc / 32768;
+    }
+
+    filter_stage_t stage;
+    TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_fir(&stage, coeffs, FIR_TAPS, delay));
+    memcpy(out, in, sizeof(in));
+    process_chunked(&stage, out, TEST_LEN);
+    TEST_ASSERT_LESS_OR_EQUAL(1, max_abs_error(out, ref, TEST_LEN));
+
+    // Swap in a pure 3-sample delay at runtime
+    static const int16_t delay3[FIR_TAPS] = { [3] = 32767 };
+    TEST_ASSERT_EQUAL(ESP_OK, filter_fir_set_coeffs(&stage, delay3));
+    int16_t probe[8] = {100, 200, 300, 400, 500, 600, 700, 800};
+    filter_stage_process(&stage, probe, 8);
+    TEST_ASSERT_INT_WITHIN(1, 500, probe[7]);   // x[n-3]
+}
+
+// What the FIR kernel in the build gives for a Q15 sum: the portable path
+// rounds to nearest and saturates, esp-dsp's dsps_dotprod_s16() adds 0x7FFF
+// and truncates to int16 (used when taps % 4 == 0)
+static int16_t fir_expected(int64_t acc, bool esp_dsp)
+{
+    if (esp_dsp) {
+        return (int16_t)((acc + 0x7FFF) >> FILTER_FIR_COEFF_SHIFT);
+    }
+    acc = (acc + (1 << (FILTER_FIR_COEFF_SHIFT - 1))) >> FILTER_FIR_COEFF_SHIFT;
+    return (int16_t)(acc > INT16_MAX ? INT16_MAX : (acc < INT16_MIN ? INT16_MIN : acc));
+}
+
+TEST_CASE("fir output is bit-exact with the kernel in the build", "[filter_chain]")
+{
+    static int16_t in[TEST_LEN], out[TEST_LEN];
+    static int16_t coeffs[16];
+    static int16_t delay[32];
+    make_signal(in, TEST_LEN);
+    for (int k = 0; k < 16; k++) {
+        coeffs[k] = (int16_t)((k * 7919) % 4001 - 1500);
+    }
+
+    // 16 taps takes esp-dsp when it is in the build, 15 taps never does
+    for (uint32_t taps = 15; taps <= 16; taps++) {
+        const bool esp_dsp = FILTER_CHAIN_HAVE_ESP_DSP && (taps % 4 == 0);
+        filter_stage_t stage;
+        TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_fir(&stage, coeffs, taps, delay));
+        memcpy(out, in, sizeof(in));
+        process_chunked(&stage, out, TEST_LEN);
+
+        for (int i = 0; i < TEST_LEN; i++) {
+            int64_t acc = 0;
+            for (uint32_t k = 0; k < taps; k++) {
+                acc += (i - (int)k >= 0) ? (int32_t)coeffs[k] * in[i - k] : 0;
+            }
+            TEST_ASSERT_EQUAL_INT(fir_expected(acc, esp_dsp), out[i]);
+            // The two roundings never differ by more than 1 LSB (see filter_chain.h)
+            TEST_ASSERT_INT_WITHIN(1, fir_expected(acc, false), fir_expected(acc, true));
+        }
+    }
+}
+
+TEST_CASE("filter chain runs stages in order and resets", "[filter_chain]")
+{
+    static int16_t hist[4];
+    static filter_biquad_t bq[1];
+    static filter_stage_t stages[2];
+    TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_moving_avg(&stages[0], hist, 4));
+    TEST_ASSERT_EQUAL(ESP_OK, filter_biquad_design(FILTER_BIQUAD_LOWPASS, TEST_FS, 100, 0.707f, &bq[0]));
+    TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_biquad(&stages[1], bq, 1));
+    filter_chain_t chain = { .stages = stages, .num_stages = 2 };
+
+    // A DC input settles to the same DC value
+    int16_t block[256];
+    for (int i = 0; i < 256; i++) {
+        block[i] = 1234;
+    }
+    filter_chain_process(&chain, block, 256);
+    TEST_ASSERT_INT_WITHIN(1, 1234, block[255]);
+
+    filter_chain_reset(&chain);
+    TEST_ASSERT_EQUAL_INT32(0, stages[0].ma.sum);
+    TEST_ASSERT_EQUAL_INT32(0, bq[0].y1);
+}
+
+TEST_CASE("filter chain reads from one buffer and writes to another", "[filter_chain]")
+{
+    static int16_t hist[2][8];
+    static filter_biquad_t bq[2][2];
+    static int16_t delay[2][2 * 12];
+    static const int16_t taps[12] = { 800, 1600, 2400, 3200, 4000, 4800, 4800, 4000, 3200, 2400, 1600, 800 };
+    static filter_stage_t stages[2][3];
+    filter_chain_t chain[2];
+    for (int k = 0; k < 2; k++) {
+        TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_moving_avg(&stages[k][0], hist[k], 8));
+        TEST_ASSERT_EQUAL(ESP_OK, filter_biquad_design(FILTER_BIQUAD_NOTCH, TEST_FS, 50, 5, &bq[k][0]));
+        TEST_ASSERT_EQUAL(ESP_OK, filter_biquad_design(FILTER_BIQUAD_LOWPASS, TEST_FS, 100, 0.707f, &bq[k][1]));
+        TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_biquad(&stages[k][1], bq[k], 2));
+        TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_fir(&stages[k][2], taps, 12, delay[k]));
+        chain[k] = (filter_chain_t) { .stages = stages[k], .num_stages = 3 };
+    }
+
+    // Same result as in place, block after block, and the source is left alone
+    static int16_t src[TEST_LEN], copy[TEST_LEN], in_place[TEST_LEN], out[TEST_LEN];
+    make_signal(src, TEST_LEN);
+    memcpy(copy, src, sizeof(src));
+    memcpy(in_place, src, sizeof(src));
+    for (size_t done = 0; done < TEST_LEN; done += 100) {
+        filter_chain_process(&chain[0], in_place + done, 100);
+        filter_chain_process_to(&chain[1], src + done, out + done, 100);
+    }
+    TEST_ASSERT_EQUAL_INT16_ARRAY(in_place, out, TEST_LEN);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(copy, src, TEST_LEN);
+
+    // No stages: a plain copy
+    filter_chain_t empty = { .stages = NULL, .num_stages = 0 };
+    memset(out, 0, sizeof(out));
+    filter_chain_process_to(&empty, src, out, TEST_LEN);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(src, out, TEST_LEN);
+}
+
+// =============================
+// Throughput per stage
+// =============================
+#define BENCH_BLOCK   256
+#define BENCH_ROUNDS  4000
+
+static double bench_stage(filter_stage_t *stage)
+{
+    static int16_t block[BENCH_BLOCK];
+    make_signal(block, BENCH_BLOCK);
+    int64_t t0 = bench_now_us();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        filter_stage_process(stage, block, BENCH_BLOCK);
+    }
+    int64_t dt = bench_now_us() - t0;
+    return (double)BENCH_BLOCK * BENCH_ROUNDS / (double)(dt > 0 ? dt : 1);
+}
+
+TEST_CASE("filter stage throughput", "[filter_chain][bench]")
+{
+    static int16_t hist[64];
+    static filter_biquad_t bq[4];
+    static int16_t coeffs[32];
+    static int16_t delay[64];
+    filter_stage_t stage;
+
+    TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_moving_avg(&stage, hist, 64));
+    printf("[bench] filter moving_avg(64): %.1f Msamples/s\n", bench_stage(&stage));
+
+    TEST_ASSERT_EQUAL(ESP_OK, filter_biquad_design(FILTER_BIQUAD_NOTCH, 20000, 50, 30, &bq[0]));
+    TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_biquad(&stage, bq, 1));
+    printf("[bench] filter biquad(1 section): %.1f Msamples/s\n", bench_stage(&stage));
+
+    for (int s = 0; s < 4; s++) {
+        TEST_ASSERT_EQUAL(ESP_OK, filter_biquad_design(FILTER_BIQUAD_LOWPASS, 20000, 500, 0.707f, &bq[s]));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_biquad(&stage, bq, 4));
+    printf("[bench] filter biquad(4 sections): %.1f Msamples/s\n", bench_stage(&stage));
+
+    for (int k = 0; k < 32; k++) {
+        coeffs[k] = 1024;
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, filter_stage_init_fir(&stage, coeffs, 32, delay));
+    printf("[bench] filter fir(32 taps): %.1f Msamples/s\n", bench_stage(&stage));
+}
@@ -0,0 +1,15 @@
+// =============================
+// Host Test Runner
+// =============================
+// Runs every TEST_CASE linked into this application. Cases tagged [bench]
+// print throughput figures that pytest_host_test.py picks up.
+
+#include <stdlib.h>
+#include "unity.h"
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    unity_run_all_tests();
+    exit(UNITY_END());
+}
@@ -0,0 +1,60 @@
+// =============================
+// Tests: pipe_timing
+// =============================
+
+#include "unity.h"
+#include "pipe_timing.h"
+
+TEST_CASE("histogram bins, percentiles and outliers", "[pipe_timing]")
+{
+    timing_hist_t h;
+    timing_hist_init(&h, 0, 10);
+    TEST_ASSERT_EQUAL_INT64(0, timing_hist_percentile(&h, 50));
+
+    for (int v = 0; v < 100; v++) {
+        timing_hist_add(&h, v);             // 10 per bin in bins 0..9
+    }
+    timing_hist_add(&h, -5);
+    timing_hist_add(&h, 1000);              // Past the last bin
+
+    TEST_ASSERT_EQUAL_UINT32(102, h.count);
+    TEST_ASSERT_EQUAL_UINT32(1, h.below);
+    TEST_ASSERT_EQUAL_UINT32(1, h.above);
+    TEST_ASSERT_EQUAL_UINT32(10, h.bins[3]);
+    TEST_ASSERT_EQUAL_INT64(-5, h.min_us);
+    TEST_ASSERT_EQUAL_INT64(1000, h.max_us);
+
+    // Percentiles are upper bin edges, never below the true value
+    TEST_ASSERT_EQUAL_INT64(-5, timing_hist_percentile(&h, 0));
+    TEST_ASSERT_EQUAL_INT64(50, timing_hist_percentile(&h, 50));   // 51st of 102 is 49
+    TEST_ASSERT_EQUAL_INT64(100, timing_hist_percentile(&h, 99));
+    TEST_ASSERT_EQUAL_INT64(1000, timing_hist_percentile(&h, 100));
+    TEST_ASSERT_EQUAL_INT64((4950 - 5 + 1000) / 102, timing_hist_mean(&h));
+
+    timing_hist_reset(&h);
+    TEST_ASSERT_EQUAL_UINT32(0, h.count);
+    TEST_ASSERT_EQUAL_UINT32(10, h.bin_us);
+}
+
+TEST_CASE("jitter meter centres on the nominal period", "[pipe_timing]")
+{
+    jitter_meter_t m;
+    jitter_meter_init(&m, 1000, 10);
+
+    // 1 kHz with +-3 us wobble, then one missing sample
+    int64_t t = 0;
+    for (int i = 0; i < 100; i++) {
+        jitter_meter_add(&m, t + ((i & 1) ? 3 : -3));
+        t += 1000;
+    }
+    t += 1000;
+    jitter_meter_add(&m, t);
+
+    TEST_ASSERT_EQUAL_UINT32(100, m.hist.count);
+    TEST_ASSERT_EQUAL_UINT32(1, m.gaps);
+    TEST_ASSERT_EQUAL_INT64(-6, m.hist.min_us);
+    TEST_ASSERT_EQUAL_INT64(997, m.hist.max_us);      // 1997 us from the last +3 sample
+    TEST_ASSERT_EQUAL_UINT32(1, m.hist.above);
+    // Everything else within one bin either side of zero
+    TEST_ASSERT_EQUAL_UINT32(99, m.hist.bins[TIMING_HIST_BINS / 2 - 1] + m.hist.bins[TIMING_HIST_BINS / 2]);
+}
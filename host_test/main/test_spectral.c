@@ -0,0 +1,281 @@
+// =============================
+// Tests: spectral
+// =============================
+// The FFT is checked against a direct double-precision DFT of the same
+// input (what numpy.fft.rfft computes); band powers, RMS and the dominant
+// frequency against the values a known test signal must give.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "spectral.h"
+#include "bench.h"
+
+#define TEST_FS      256.0f
+
+static spectral_plan_t plan;
+static spectral_t sp;
+static spectral_sdft_t sdft;
+static spectral_result_t results[16];
+static int16_t signal[8192];
+static float data[SPECTRAL_MAX_N];
+static double ref_re[SPECTRAL_MAX_N / 2 + 1];
+static double ref_im[SPECTRAL_MAX_N / 2 + 1];
+
+static const spectral_config_t eeg_cfg = {
+    .sample_rate_hz = TEST_FS,
+    .hop = 128,
+    .num_bands = 4,
+    .bands = { { 0.5f, 4 }, { 4, 8 }, { 8, 13 }, { 13, 30 } },   // delta, theta, alpha, beta
+};
+
+// offset + amplitude * sin(2 pi f t) + uniform noise of +-noise
+static void make_sine(int16_t *out, size_t n, double offset, double amp, double f_hz, int noise)
+{
+    srand(4321);
+    for (size_t i = 0; i < n; i++) {
+        double v = offset + amp * sin(2 * M_PI * f_hz * i / TEST_FS);
+        if (noise) {
+            v += rand() % (2 * noise + 1) - noise;
+        }
+        out[i] = (int16_t)lround(v);
+    }
+}
+
+static void dft_reference(const float *x, uint32_t n)
+{
+    for (uint32_t k = 0; k <= n / 2; k++) {
+        double re = 0, im = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            double a = 2 * M_PI * (double)((uint64_t)k * i % n) / n;
+            re += x[i] * cos(a);
+            im -= x[i] * sin(a);
+        }
+        ref_re[k] = re;
+        ref_im[k] = im;
+    }
+}
+
+TEST_CASE("real fft matches the direct dft for 256/512/1024 points", "[spectral]")
+{
+    static const uint32_t sizes[] = { 256, 512, 1024 };
+    static float input[SPECTRAL_MAX_N];
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        const uint32_t n = sizes[s];
+        TEST_ASSERT_EQUAL(ESP_OK, spectral_plan_init(&plan, n, SPECTRAL_WINDOW_RECT));
+        srand(99 + n);
+        for (uint32_t i = 0; i < n; i++) {
+            input[i] = (float)(rand() % 2001 - 1000) + 300.0f * sinf(2 * (float)M_PI * 37 * i / n);
+        }
+        dft_reference(input, n);
+        memcpy(data, input, n * sizeof(float));
+        spectral_rfft(&plan, data);
+
+        // Float rounding grows with log2(n); 1e-4 of the largest bin is generous
+        double peak = 0;
+        for (uint32_t k = 0; k <= n / 2; k++) {
+            peak = fmax(peak, hypot(ref_re[k], ref_im[k]));
+        }
+        const double tol = peak * 1e-4;
+        TEST_ASSERT_DOUBLE_WITHIN(tol, ref_re[0], data[0]);
+        TEST_ASSERT_DOUBLE_WITHIN(tol, ref_re[n / 2], data[1]);
+        for (uint32_t k = 1; k < n / 2; k++) {
+            TEST_ASSERT_DOUBLE_WITHIN(tol, ref_re[k], data[2 * k]);
+            TEST_ASSERT_DOUBLE_WITHIN(tol, ref_im[k], data[2 * k + 1]);
+        }
+    }
+}
+
+TEST_CASE("spectral plan rejects bad lengths and windows", "[spectral]")
+{
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spectral_plan_init(&plan, 128, SPECTRAL_WINDOW_HANN));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spectral_plan_init(&plan, 768, SPECTRAL_WINDOW_HANN));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spectral_plan_init(&plan, 2048, SPECTRAL_WINDOW_HANN));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spectral_plan_init(&plan, 512, (spectral_window_t)42));
+    TEST_ASSERT_EQUAL(ESP_OK, spectral_plan_init(&plan, 512, SPECTRAL_WINDOW_HANN));
+
+    spectral_config_t cfg = eeg_cfg;
+    cfg.hop = 0;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spectral_init(&sp, &plan, &cfg));
+    cfg.hop = 513;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spectral_init(&sp, &plan, &cfg));
+    cfg = eeg_cfg;
+    cfg.bands[1].hi_hz = cfg.bands[1].lo_hz;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spectral_init(&sp, &plan, &cfg));
+    cfg = eeg_cfg;
+    cfg.num_bands = SPECTRAL_MAX_BANDS + 1;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spectral_init(&sp, &plan, &cfg));
+}
+
+TEST_CASE("alpha sine lands in the alpha band at the right frequency", "[spectral]")
+{
+    // 10.3 Hz, 200 mV amplitude on a 1650 mV offset: power A^2/2 = 20000 mV^2
+    static const spectral_window_t windows[] = { SPECTRAL_WINDOW_HANN, SPECTRAL_WINDOW_HAMMING, SPECTRAL_WINDOW_BLACKMAN };
+    make_sine(signal, 512, 1650, 200, 10.3, 0);
+    for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        TEST_ASSERT_EQUAL(ESP_OK, spectral_plan_init(&plan, 512, windows[w]));
+        TEST_ASSERT_EQUAL(ESP_OK, spectral_init(&sp, &plan, &eeg_cfg));
+        spectral_analyze(&sp, signal, &results[0]);
+        const spectral_result_t *r = &results[0];
+
+        TEST_ASSERT_FLOAT_WITHIN(5.0f, 1650.0f, r->mean);      // 20.6 periods: not quite zero-mean
+        TEST_ASSERT_FLOAT_WITHIN(200.0f / sqrtf(2) * 0.02f, 200.0f / sqrtf(2), r->rms);
+        TEST_ASSERT_FLOAT_WITHIN(0.1f, 10.3f, r->dominant_hz);
+        TEST_ASSERT_FLOAT_WITHIN(20000.0f * 0.05f, 20000.0f, r->total_power);
+        TEST_ASSERT_FLOAT_WITHIN(20000.0f * 0.05f, 20000.0f, r->band_power[2]);
+        TEST_ASSERT_LESS_THAN_FLOAT(20000.0f * 0.02f, r->band_power[0]);
+        TEST_ASSERT_LESS_THAN_FLOAT(20000.0f * 0.02f, r->band_power[1]);
+        TEST_ASSERT_LESS_THAN_FLOAT(20000.0f * 0.02f, r->band_power[3]);
+    }
+}
+
+TEST_CASE("band powers add up to the signal power with noise", "[spectral]")
+{
+    // Theta and beta tones plus white noise: total = sum of the tone powers + noise variance
+    TEST_ASSERT_EQUAL(ESP_OK, spectral_plan_init(&plan, 1024, SPECTRAL_WINDOW_HANN));
+    TEST_ASSERT_EQUAL(ESP_OK, spectral_init(&sp, &plan, &eeg_cfg));
+    srand(77);
+    for (size_t i = 0; i < 1024; i++) {
+        double t = i / TEST_FS;
+        double v = 1000 + 150 * sin(2 * M_PI * 6 * t) + 80 * sin(2 * M_PI * 21 * t) + (rand() % 41 - 20);
+        signal[i] = (int16_t)lround(v);
+    }
+    spectral_analyze(&sp, signal, &results[0]);
+    const spectral_result_t *r = &results[0];
+    const float noise = 20 * 21 / 3.0f;     // Variance of uniform -20..20
+    TEST_ASSERT_FLOAT_WITHIN(150 * 150 / 2 * 0.05f, 150 * 150 / 2, r->band_power[1]);
+    TEST_ASSERT_FLOAT_WITHIN(80 * 80 / 2 * 0.1f, 80 * 80 / 2, r->band_power[3]);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f * (11250 + 3200 + noise), 11250 + 3200 + noise, r->total_power);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f * r->total_power, r->rms * r->rms, r->total_power);
+    TEST_ASSERT_FLOAT_WITHIN(0.1f, 6.0f, r->dominant_hz);
+}
+
+TEST_CASE("esp-dsp and portable fft give the same band powers", "[spectral]")
+{
+    // Without esp-dsp in the build both plans would run the portable FFT
+    TEST_ASSERT_EQUAL(ESP_OK, spectral_plan_init(&plan, SPECTRAL_MIN_N, SPECTRAL_WINDOW_HANN));
+    if (!plan.use_esp_dsp) {
+        TEST_IGNORE_MESSAGE("esp-dsp is not in this build (target_test/ has it)");
+    }
+    static spectral_plan_t portable;
+    static spectral_t sp_portable;
+    for (uint32_t n = SPECTRAL_MIN_N; n <= SPECTRAL_MAX_N; n *= 2) {
+        TEST_ASSERT_EQUAL(ESP_OK, spectral_plan_init(&plan, n, SPECTRAL_WINDOW_HANN));
+        TEST_ASSERT_EQUAL(ESP_OK, spectral_plan_init(&portable, n, SPECTRAL_WINDOW_HANN));
+        portable.use_esp_dsp = false;
+        TEST_ASSERT_EQUAL(ESP_OK, spectral_init(&sp, &plan, &eeg_cfg));
+        TEST_ASSERT_EQUAL(ESP_OK, spectral_init(&sp_portable, &portable, &eeg_cfg));
+
+        make_sine(signal, n, 1650, 200, 10.3, 40);
+        spectral_analyze(&sp, signal, &results[0]);
+        spectral_analyze(&sp_portable, signal, &results[1]);
+
+        const spectral_result_t *dsp = &results[0], *ref = &results[1];
+        const float tol = ref->total_power * 1e-4f;
+        TEST_ASSERT_FLOAT_WITHIN(tol, ref->total_power, dsp->total_power);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, ref->dominant_hz, dsp->dominant_hz);
+        for (uint32_t b = 0; b < eeg_cfg.num_bands; b++) {
+            TEST_ASSERT_FLOAT_WITHIN(tol, ref->band_power[b], dsp->band_power[b]);
+        }
+    }
+}
+
+TEST_CASE("windows follow the hop for any chunking", "[spectral]")
+{
+    TEST_ASSERT_EQUAL(ESP_OK, spectral_plan_init(&plan, 256, SPECTRAL_WINDOW_HANN));
+    make_sine(signal, 2048, 1200, 300, 20, 30);
+
+    // Reference: whole stream in one call -> first window at 256, then every 64
+    spectral_config_t cfg = eeg_cfg;
+    cfg.hop = 64;
+    static spectral_result_t whole[32];
+    TEST_ASSERT_EQUAL(ESP_OK, spectral_init(&sp, &plan, &cfg));
+    size_t n_whole = spectral_process(&sp, signal, 2048, whole, 32);
+    TEST_ASSERT_EQUAL(1 + (2048 - 256) / 64, n_whole);
+    for (size_t i = 0; i < n_whole; i++) {
+        TEST_ASSERT_EQUAL_UINT32(i, whole[i].seq);
+        TEST_ASSERT_EQUAL_UINT64(256 + 64 * i, whole[i].end_sample);
+    }
+
+    // Odd chunk sizes give bit-identical windows
+    TEST_ASSERT_EQUAL(ESP_OK, spectral_init(&sp, &plan, &cfg));
+    size_t done = 0, got = 0;
+    unsigned chunk = 1;
+    while (done < 2048) {
+        chunk = (chunk * 7 + 3) % 97 + 1;
+        size_t len = (2048 - done < chunk) ? 2048 - done : chunk;
+        size_t k = spectral_process(&sp, signal + done, len, results, 16);
+        for (size_t i = 0; i < k; i++, got++) {
+            TEST_ASSERT_EQUAL_UINT32(whole[got].seq, results[i].seq);
+            TEST_ASSERT_EQUAL_FLOAT(whole[got].rms, results[i].rms);
+            TEST_ASSERT_EQUAL_FLOAT(whole[got].band_power[3], results[i].band_power[3]);
+        }
+        done += len;
+    }
+    TEST_ASSERT_EQUAL(n_whole, got);
+
+    // Results beyond max_results are dropped but still counted
+    TEST_ASSERT_EQUAL(ESP_OK, spectral_init(&sp, &plan, &cfg));
+    TEST_ASSERT_EQUAL(2, spectral_process(&sp, signal, 512, results, 2));
+    TEST_ASSERT_EQUAL(1, spectral_process(&sp, signal, 64, results, 2));
+    TEST_ASSERT_EQUAL_UINT32(5, results[0].seq);
+}
+
+TEST_CASE("sliding dft matches the fft bin power", "[spectral]")
+{
+    // Rectangular window: SDFT bin k after n samples == FFT bin k of the last n samples
+    const float freqs[] = { 10, 21 };
+    TEST_ASSERT_EQUAL(ESP_OK, spectral_plan_init(&plan, 256, SPECTRAL_WINDOW_RECT));
+    TEST_ASSERT_EQUAL(ESP_OK, spectral_init(&sp, &plan, &eeg_cfg));
+    TEST_ASSERT_EQUAL(ESP_OK, spectral_sdft_init(&sdft, TEST_FS, 256, freqs, 2));
+    TEST_ASSERT_EQUAL_FLOAT(10.0f, spectral_sdft_freq(&sdft, 0));
+
+    srand(5);
+    for (size_t i = 0; i < 4096; i++) {
+        double t = i / TEST_FS;
+        signal[i] = (int16_t)lround(120 * sin(2 * M_PI * 10 * t) + 40 * sin(2 * M_PI * 21 * t + 1) + (rand() % 21 - 10));
+    }
+    spectral_sdft_process(&sdft, signal, 4096);
+    spectral_analyze(&sp, signal + 4096 - 256, &results[0]);
+
+    // Window of the FFT result has its mean removed; the SDFT does not, which
+    // only matters at DC. Both track the same bins.
+    for (uint32_t i = 0; i < 2; i++) {
+        float fft = plan.power[sdft.bin[i]];
+        TEST_ASSERT_FLOAT_WITHIN(fft * 0.01f + 1.0f, fft, spectral_sdft_power(&sdft, i));
+    }
+    TEST_ASSERT_FLOAT_WITHIN(120 * 120 / 2 * 0.05f, 120 * 120 / 2, spectral_sdft_power(&sdft, 0));
+
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spectral_sdft_init(&sdft, TEST_FS, 256, (const float[]){ 0 }, 1));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spectral_sdft_init(&sdft, TEST_FS, 256, (const float[]){ 128 }, 1));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spectral_sdft_init(&sdft, TEST_FS, 256, freqs, SPECTRAL_SDFT_MAX_BINS + 1));
+}
+
+TEST_CASE("spectral cycles per window", "[spectral][bench]")
+{
+    static const uint32_t sizes[] = { 256, 512, 1024 };
+    const int reps = 2000;
+    make_sine(signal, SPECTRAL_MAX_N, 1650, 500, 11, 50);
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        spectral_plan_init(&plan, sizes[s], SPECTRAL_WINDOW_HANN);
+        spectral_init(&sp, &plan, &eeg_cfg);
+        uint64_t c0 = bench_cycles();
+        for (int r = 0; r < reps; r++) {
+            spectral_analyze(&sp, signal, &results[0]);
+        }
+        uint64_t c1 = bench_cycles();
+        printf("[bench] spectral window N=%u: %llu cycles (%.1f per sample)\n", (unsigned)sizes[s],
+               (unsigned long long)((c1 - c0) / reps), (double)(c1 - c0) / reps / sizes[s]);
+    }
+
+    const float freqs[] = { 2, 6, 10, 20 };
+    spectral_sdft_init(&sdft, TEST_FS, 256, freqs, 4);
+    uint64_t c0 = bench_cycles();
+    for (int r = 0; r < 500; r++) {
+        spectral_sdft_process(&sdft, signal, SPECTRAL_MAX_N);
+    }
+    uint64_t c1 = bench_cycles();
+    printf("[bench] spectral sdft 4 bins: %.1f cycles per sample\n", (double)(c1 - c0) / (500.0 * SPECTRAL_MAX_N));
+}
@@ -0,0 +1,179 @@
+// =============================
+// Tests: spsc_ring
+// =============================
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include "unity.h"
+#include "spsc_ring.h"
+#include "bench.h"
+
+TEST_CASE("ring rejects non power-of-two capacity", "[spsc_ring]")
+{
+    static int16_t storage[12];
+    spsc_ring_t ring;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spsc_ring_init(&ring, storage, 12));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, spsc_ring_init(&ring, storage, 1));
+    TEST_ASSERT_EQUAL(ESP_OK, spsc_ring_init(&ring, storage, 8));
+}
+
+TEST_CASE("ring spans stop at the wrap point", "[spsc_ring]")
+{
+    static int16_t storage[8];
+    spsc_ring_t ring;
+    TEST_ASSERT_EQUAL(ESP_OK, spsc_ring_init(&ring, storage, 8));
+
+    const int16_t in[6] = {1, 2, 3, 4, 5, 6};
+    const int16_t *span;
+
+    // Move the indexes to 6 so the next push wraps
+    TEST_ASSERT_EQUAL(6, spsc_ring_push_n(&ring, in, 6));
+    TEST_ASSERT_EQUAL(6, spsc_ring_peek_n(&ring, &span, 6));
+    TEST_ASSERT_EQUAL_PTR(&storage[0], span);
+    spsc_ring_consume_n(&ring, 6);
+
+    TEST_ASSERT_EQUAL(5, spsc_ring_push_n(&ring, in, 5));
+    // First span: slots 6..7, second span: slots 0..2
+    TEST_ASSERT_EQUAL(2, spsc_ring_peek_n(&ring, &span, 5));
+    TEST_ASSERT_EQUAL_PTR(&storage[6], span);
+    TEST_ASSERT_EQUAL(1, span[0]);
+    TEST_ASSERT_EQUAL(2, span[1]);
+    spsc_ring_consume_n(&ring, 2);
+    TEST_ASSERT_EQUAL(3, spsc_ring_peek_n(&ring, &span, 5));
+    TEST_ASSERT_EQUAL_PTR(&storage[0], span);
+    TEST_ASSERT_EQUAL(3, span[0]);
+    TEST_ASSERT_EQUAL(5, span[2]);
+    spsc_ring_consume_n(&ring, 3);
+    TEST_ASSERT_EQUAL(0, spsc_ring_available(&ring));
+}
+
+TEST_CASE("ring counts overruns, underruns and high-water mark", "[spsc_ring]")
+{
+    static int16_t storage[16];
+    spsc_ring_t ring;
+    TEST_ASSERT_EQUAL(ESP_OK, spsc_ring_init(&ring, storage, 16));
+
+    const int16_t *span;
+    TEST_ASSERT_EQUAL(0, spsc_ring_poll(&ring));            // Woke up for data, found none
+    TEST_ASSERT_EQUAL(0, spsc_ring_peek_n(&ring, &span, 4));
+
+    int16_t in[20] = {0};
+    TEST_ASSERT_EQUAL(10, spsc_ring_push_n(&ring, in, 10));
+    TEST_ASSERT_EQUAL(6, spsc_ring_push_n(&ring, in, 10));   // 4 dropped
+
+    // A drain that ends on an empty peek is not an underrun
+    TEST_ASSERT_EQUAL(16, spsc_ring_poll(&ring));
+    spsc_ring_consume_n(&ring, spsc_ring_peek_n(&ring, &span, 16));
+    TEST_ASSERT_EQUAL(0, spsc_ring_peek_n(&ring, &span, 16));
+
+    spsc_ring_stats_t stats;
+    spsc_ring_get_stats(&ring, &stats);
+    TEST_ASSERT_EQUAL_UINT32(16, stats.capacity);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.fill);
+    TEST_ASSERT_EQUAL_UINT32(16, stats.high_water);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.overruns);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.underruns);
+    TEST_ASSERT_EQUAL_UINT32(16, stats.pushed);
+}
+
+// =============================
+// Producer -> consumer on two real threads
+// =============================
+#define BENCH_RING_SIZE   4096
+#define BENCH_BLOCK       256
+#define BENCH_SAMPLES     (16u * 1024 * 1024)
+
+typedef struct {
+    spsc_ring_t ring;
+    uint32_t errors;
+} bench_ctx_t;
+
+// The linux target drives its FreeRTOS tick with a signal; keep it off these threads
+static void block_signals(void)
+{
+    sigset_t set;
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+}
+
+static void *bench_producer(void *arg)
+{
+    bench_ctx_t *ctx = arg;
+    int16_t block[BENCH_BLOCK];
+    uint32_t next = 0;
+    block_signals();
+
+    while (next < BENCH_SAMPLES) {
+        for (int i = 0; i < BENCH_BLOCK; i++) {
+            block[i] = (int16_t)(next + i);
+        }
+        size_t done = 0;
+        while (done < BENCH_BLOCK) {
+            // Only push what fits so the sequence stays gap-free
+            size_t space = BENCH_RING_SIZE - spsc_ring_available(&ctx->ring);
+            size_t n = BENCH_BLOCK - done;
+            if (n > space) {
+                n = space;
+            }
+            if (n == 0) {
+                sched_yield();   // Ring full: let the consumer run
+                continue;
+            }
+            done += spsc_ring_push_n(&ctx->ring, block + done, n);
+        }
+        next += BENCH_BLOCK;
+    }
+    return NULL;
+}
+
+static void *bench_consumer(void *arg)
+{
+    bench_ctx_t *ctx = arg;
+    uint32_t expected = 0;
+    block_signals();
+
+    while (expected < BENCH_SAMPLES) {
+        const int16_t *span;
+        size_t n = spsc_ring_peek_n(&ctx->ring, &span, BENCH_BLOCK);
+        if (n == 0) {
+            sched_yield();       // Ring empty: let the producer run
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (span[i] != (int16_t)(expected + i)) {
+                ctx->errors++;
+            }
+        }
+        spsc_ring_consume_n(&ctx->ring, n);
+        expected += n;
+    }
+    return NULL;
+}
+
+TEST_CASE("ring producer to consumer throughput", "[spsc_ring][bench]")
+{
+    static int16_t storage[BENCH_RING_SIZE];
+    static bench_ctx_t ctx;
+    TEST_ASSERT_EQUAL(ESP_OK, spsc_ring_init(&ctx.ring, storage, BENCH_RING_SIZE));
+    ctx.errors = 0;
+
+    pthread_t prod, cons;
+    int64_t t0 = bench_now_us();
+    pthread_create(&cons, NULL, bench_consumer, &ctx);
+    pthread_create(&prod, NULL, bench_producer, &ctx);
+    pthread_join(prod, NULL);
+    pthread_join(cons, NULL);
+    int64_t dt = bench_now_us() - t0;
+
+    spsc_ring_stats_t stats;
+    spsc_ring_get_stats(&ctx.ring, &stats);
+    printf("[bench] spsc_ring: %.1f Msamples/s, high-water %lu/%lu\n",
+           (double)BENCH_SAMPLES / (double)dt, (unsigned long)stats.high_water,
+           (unsigned long)stats.capacity);
+
+    TEST_ASSERT_EQUAL_UINT32(0, ctx.errors);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.overruns);
+    TEST_ASSERT_EQUAL_UINT32(BENCH_SAMPLES, stats.pushed);
+}
@@ -0,0 +1,390 @@
+// =============================
+// Tests: stream_proto / stream_tx
+// =============================
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "unity.h"
+#include "stream_proto.h"
+#include "stream_tx.h"
+#include "bench.h"
+
+#define TEST_N 256
+
+// Filtered ADC output: a slow sine around 1.6 V with a little noise
+static void make_signal(int16_t *s, size_t n, uint32_t seed)
+{
+    for (size_t i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        s[i] = (int16_t)(1600 + 800 * sinf(2.0f * 3.14159265f * (float)i / 200.0f) + (int)(seed >> 29) - 4);
+    }
+}
+
+// Collects everything the decoder hands out
+typedef struct {
+    uint32_t frames;
+    stream_frame_hdr_t hdr;
+    int16_t samples[STREAM_MAX_SAMPLES];
+} capture_t;
+
+static void capture_frame(const stream_frame_hdr_t *hdr, const int16_t *samples, void *ctx)
+{
+    capture_t *cap = (capture_t *)ctx;
+    cap->frames++;
+    cap->hdr = *hdr;
+    memcpy(cap->samples, samples, hdr->count * sizeof(int16_t));
+}
+
+static void roundtrip(uint8_t encoding, const int16_t *s, size_t n)
+{
+    static uint8_t wire[STREAM_WIRE_MAX_SIZE];
+    static int16_t out[STREAM_MAX_SAMPLES];
+    stream_frame_hdr_t hdr = {
+        .encoding = encoding, .channel = 6, .count = (uint16_t)n, .seq = 0x01020304, .timestamp_us = 0xA0B0C0D0,
+    };
+    size_t len = 0;
+    TEST_ASSERT_EQUAL(ESP_OK, stream_proto_encode(&hdr, s, wire, sizeof(wire), &len));
+    TEST_ASSERT_TRUE(len <= STREAM_WIRE_MAX_SIZE);
+
+    // Delimiters at both ends only
+    TEST_ASSERT_EQUAL_UINT8(0, wire[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, wire[len - 1]);
+    for (size_t i = 1; i < len - 1; i++) {
+        TEST_ASSERT_NOT_EQUAL(0, wire[i]);
+    }
+
+    stream_frame_hdr_t got;
+    TEST_ASSERT_EQUAL(ESP_OK, stream_proto_decode(&wire[1], len - 2, &got, out));
+    TEST_ASSERT_EQUAL_UINT8(hdr.encoding, got.encoding);
+    TEST_ASSERT_EQUAL_UINT8(6, got.channel);
+    TEST_ASSERT_EQUAL_UINT16(n, got.count);
+    TEST_ASSERT_EQUAL_UINT32(0x01020304, got.seq);
+    TEST_ASSERT_EQUAL_UINT32(0xA0B0C0D0, got.timestamp_us);
+    if (n > 0) {
+        TEST_ASSERT_EQUAL_INT16_ARRAY(s, out, n);
+    }
+}
+
+TEST_CASE("stream frames round-trip in every encoding", "[stream_proto]")
+{
+    static int16_t s[STREAM_MAX_SAMPLES];
+    make_signal(s, STREAM_MAX_SAMPLES, 1);
+
+    const size_t sizes[] = {0, 1, 2, 3, 255, STREAM_MAX_SAMPLES};
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        roundtrip(STREAM_ENC_RAW16, s, sizes[k]);
+        roundtrip(STREAM_ENC_PACKED12, s, sizes[k]);
+        roundtrip(STREAM_ENC_DELTA8, s, sizes[k]);
+        roundtrip(STREAM_ENC_AUTO, s, sizes[k]);
+    }
+
+    // Full-range values and large steps: DELTA8 escapes, PACKED12 refused
+    int16_t wild[8] = {0, 32767, -32768, 5, 4, 3, -200, 4095};
+    roundtrip(STREAM_ENC_RAW16, wild, 8);
+    roundtrip(STREAM_ENC_AUTO, wild, 8);
+    int16_t steps[8] = {100, 101, 1000, 999, 998, -3000, -2990, -2980};
+    roundtrip(STREAM_ENC_DELTA8, steps, 8);
+
+    static uint8_t wire[STREAM_WIRE_MAX_SIZE];
+    size_t len;
+    stream_frame_hdr_t hdr = { .encoding = STREAM_ENC_PACKED12, .count = 8 };
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, stream_proto_encode(&hdr, wild, wire, sizeof(wire), &len));
+    hdr.encoding = STREAM_ENC_DELTA8;     // More escapes than RAW16 would cost
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, stream_proto_encode(&hdr, wild, wire, sizeof(wire), &len));
+    hdr.encoding = STREAM_ENC_RAW16;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, stream_proto_encode(&hdr, wild, wire, 10, &len));
+}
+
+TEST_CASE("stream auto encoding picks the smallest payload", "[stream_proto]")
+{
+    static int16_t s[TEST_N];
+    static uint8_t wire[STREAM_WIRE_MAX_SIZE];
+    size_t len;
+
+    // Smooth signal: deltas fit in a byte
+    make_signal(s, TEST_N, 2);
+    stream_frame_hdr_t hdr = { .encoding = STREAM_ENC_AUTO, .count = TEST_N };
+    TEST_ASSERT_EQUAL(ESP_OK, stream_proto_encode(&hdr, s, wire, sizeof(wire), &len));
+    TEST_ASSERT_EQUAL_UINT8(STREAM_ENC_DELTA8, hdr.encoding);
+
+    // White noise over the 12-bit range: packing wins
+    uint32_t seed = 3;
+    for (int i = 0; i < TEST_N; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        s[i] = (int16_t)(seed >> 20);
+    }
+    hdr.encoding = STREAM_ENC_AUTO;
+    TEST_ASSERT_EQUAL(ESP_OK, stream_proto_encode(&hdr, s, wire, sizeof(wire), &len));
+    TEST_ASSERT_EQUAL_UINT8(STREAM_ENC_PACKED12, hdr.encoding);
+}
+
+TEST_CASE("stream decoder resynchronises on chunked input with stray text", "[stream_proto]")
+{
+    static int16_t s[4][TEST_N];
+    static uint8_t stream[8 * STREAM_WIRE_MAX_SIZE];
+    size_t total = 0;
+
+    // Four frames with a log line in the middle of the stream
+    for (uint32_t f = 0; f < 4; f++) {
+        make_signal(s[f], TEST_N, f + 10);
+        stream_frame_hdr_t hdr = { .encoding = STREAM_ENC_AUTO, .count = TEST_N, .seq = f, .timestamp_us = f * 12800 };
+        size_t len;
+        TEST_ASSERT_EQUAL(ESP_OK, stream_proto_encode(&hdr, s[f], &stream[total], sizeof(stream) - total, &len));
+        total += len;
+        if (f == 1) {
+            const char *log = "I (1234) ADC_BASIC: Filter chain ready: 2 stage(s)\n";
+            memcpy(&stream[total], log, strlen(log));
+            total += strlen(log);
+        }
+    }
+
+    // Join mid-frame and feed in odd-sized chunks
+    static stream_decoder_t dec;
+    static capture_t cap;
+    memset(&cap, 0, sizeof(cap));
+    stream_decoder_init(&dec, capture_frame, &cap);
+    size_t pos = 7;
+    for (size_t chunk = 1; pos < total; chunk = chunk * 3 % 61 + 1) {
+        size_t n = (total - pos < chunk) ? total - pos : chunk;
+        stream_decoder_feed(&dec, &stream[pos], n);
+        pos += n;
+    }
+
+    // First frame is cut (one bad frame), the text is another bad frame
+    TEST_ASSERT_EQUAL_UINT32(3, dec.frames);
+    TEST_ASSERT_EQUAL_UINT32(2, dec.bad_frames);
+    TEST_ASSERT_EQUAL_UINT32(0, dec.lost_frames);
+    TEST_ASSERT_EQUAL_UINT32(3, cap.hdr.seq);
+    TEST_ASSERT_EQUAL_UINT32(3 * 12800, cap.hdr.timestamp_us);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(s[3], cap.samples, TEST_N);
+}
+
+TEST_CASE("stream decoder reports corruption and lost frames", "[stream_proto]")
+{
+    static int16_t s[TEST_N];
+    static uint8_t wire[STREAM_WIRE_MAX_SIZE];
+    static stream_decoder_t dec;
+    make_signal(s, TEST_N, 4);
+    stream_decoder_init(&dec, NULL, NULL);
+
+    // CRC-16/CCITT-FALSE check value
+    TEST_ASSERT_EQUAL_UINT16(0x29B1, stream_crc16((const uint8_t *)"123456789", 9));
+
+    const uint32_t seqs[] = {0, 1, 4, 5, 6};
+    for (size_t k = 0; k < 5; k++) {
+        stream_frame_hdr_t hdr = { .encoding = STREAM_ENC_RAW16, .count = TEST_N, .seq = seqs[k] };
+        size_t len;
+        TEST_ASSERT_EQUAL(ESP_OK, stream_proto_encode(&hdr, s, wire, sizeof(wire), &len));
+        if (seqs[k] == 5) {
+            wire[len / 2] ^= 0x10;      // Single bit error inside the frame
+            TEST_ASSERT_EQUAL(ESP_ERR_INVALID_CRC, stream_proto_decode(&wire[1], len - 2, &hdr, dec.samples));
+        }
+        stream_decoder_feed(&dec, wire, len);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(4, dec.frames);
+    TEST_ASSERT_EQUAL_UINT32(1, dec.bad_frames);
+    TEST_ASSERT_EQUAL_UINT32(3, dec.lost_frames);  // 2, 3 never sent; 5 corrupted
+    TEST_ASSERT_EQUAL_UINT64(4 * TEST_N, dec.samples_out);
+}
+
+TEST_CASE("stream decoder re-anchors when the sequence restarts", "[stream_proto]")
+{
+    static int16_t s[TEST_N];
+    static uint8_t wire[STREAM_WIRE_MAX_SIZE];
+    static stream_decoder_t dec;
+    make_signal(s, TEST_N, 5);
+    stream_decoder_init(&dec, NULL, NULL);
+
+    // Wrap-around is an ordinary gap (0xFFFFFFFF lost); 0 after 3 is a
+    // restarted sender, then counting goes on from there (1 lost)
+    const uint32_t seqs[] = {0xFFFFFFFD, 0xFFFFFFFE, 0, 1, 2, 3, 0, 2};
+    for (size_t k = 0; k < sizeof(seqs) / sizeof(seqs[0]); k++) {
+        stream_frame_hdr_t hdr = { .encoding = STREAM_ENC_RAW16, .count = TEST_N, .seq = seqs[k] };
+        size_t len;
+        TEST_ASSERT_EQUAL(ESP_OK, stream_proto_encode(&hdr, s, wire, sizeof(wire), &len));
+        stream_decoder_feed(&dec, wire, len);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(8, dec.frames);
+    TEST_ASSERT_EQUAL_UINT32(2, dec.lost_frames);
+    TEST_ASSERT_EQUAL_UINT32(1, dec.resyncs);
+    TEST_ASSERT_EQUAL_UINT32(3, dec.next_seq);
+}
+
+static void count_features(const stream_frame_hdr_t *hdr, const float *values, void *ctx)
+{
+    float *sum = (float *)ctx;
+    for (size_t i = 0; i < hdr->count; i++) {
+        *sum += values[i];
+    }
+}
+
+TEST_CASE("stream feature frames share the sequence with sample frames", "[stream_proto]")
+{
+    static int16_t s[TEST_N];
+    static uint8_t wire[STREAM_WIRE_MAX_SIZE];
+    static stream_decoder_t dec;
+    static const float values[] = { 1650.5f, 141.4f, 10.25f, 20000.0f, -0.0f, 1e-7f };
+    float got[STREAM_MAX_FEATURES];
+    float sum = 0;
+    make_signal(s, TEST_N, 9);
+    stream_decoder_init(&dec, NULL, &sum);
+    dec.on_features = count_features;
+
+    // samples 0, features 1, (features 2 lost), samples 3
+    for (uint32_t seq = 0; seq < 4; seq++) {
+        stream_frame_hdr_t hdr = { .encoding = STREAM_ENC_AUTO, .channel = 2, .seq = seq, .timestamp_us = seq * 500 };
+        size_t len;
+        if (seq == 0 || seq == 3) {
+            hdr.count = TEST_N;
+            TEST_ASSERT_EQUAL(ESP_OK, stream_proto_encode(&hdr, s, wire, sizeof(wire), &len));
+            TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, stream_proto_decode_features(&wire[1], len - 2, &hdr, got));
+        } else {
+            hdr.count = 6;
+            TEST_ASSERT_EQUAL(ESP_OK, stream_proto_encode_features(&hdr, values, wire, sizeof(wire), &len));
+            TEST_ASSERT_EQUAL_UINT8(STREAM_ENC_FLOAT32, hdr.encoding);
+            TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED, stream_proto_decode(&wire[1], len - 2, &hdr, dec.samples));
+
+            stream_frame_hdr_t out;
+            TEST_ASSERT_EQUAL(ESP_OK, stream_proto_decode_features(&wire[1], len - 2, &out, got));
+            TEST_ASSERT_EQUAL_UINT16(6, out.count);
+            TEST_ASSERT_EQUAL_UINT8(2, out.channel);
+            TEST_ASSERT_EQUAL_MEMORY(values, got, sizeof(values));     // Bit-exact
+            if (seq == 2) {
+                continue;
+            }
+        }
+        stream_decoder_feed(&dec, wire, len);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(3, dec.frames);
+    TEST_ASSERT_EQUAL_UINT32(1, dec.feature_frames);
+    TEST_ASSERT_EQUAL_UINT32(1, dec.lost_frames);
+    TEST_ASSERT_EQUAL_UINT32(0, dec.bad_frames);
+    TEST_ASSERT_EQUAL_UINT64(2 * TEST_N, dec.samples_out);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1650.5f + 141.4f + 10.25f + 20000.0f, sum);
+
+    stream_frame_hdr_t hdr = { .count = STREAM_MAX_FEATURES + 1 };
+    size_t len;
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, stream_proto_encode_features(&hdr, got, wire, sizeof(wire), &len));
+}
+
+// =============================
+// Transmit task
+// =============================
+typedef struct {
+    stream_decoder_t dec;
+    capture_t cap;
+} loopback_t;
+
+static size_t loopback_write(const uint8_t *data, size_t len, void *ctx)
+{
+    loopback_t *lb = (loopback_t *)ctx;
+    stream_decoder_feed(&lb->dec, data, len);
+    return len;
+}
+
+TEST_CASE("stream tx delivers submitted blocks in order", "[stream_proto]")
+{
+    static loopback_t lb;
+    memset(&lb, 0, sizeof(lb));
+    stream_decoder_init(&lb.dec, capture_frame, &lb.cap);
+
+    stream_tx_config_t cfg = {
+        .write = loopback_write,
+        .write_ctx = &lb,
+        .encoding = STREAM_ENC_AUTO,
+        .queue_depth = 4,
+        .task_priority = 2,
+        .task_stack = 4096,
+    };
+    stream_tx_t *tx = NULL;
+    TEST_ASSERT_EQUAL(ESP_OK, stream_tx_start(&cfg, &tx));
+
+    static int16_t s[STREAM_TX_BLOCK_SAMPLES];
+    uint32_t sent = 0;
+    for (int b = 0; b < 50; b++) {
+        make_signal(s, STREAM_TX_BLOCK_SAMPLES, b);
+        esp_err_t ret = stream_tx_submit(tx, 0, b * 1000, s, STREAM_TX_BLOCK_SAMPLES);
+        TEST_ASSERT_TRUE(ret == ESP_OK || ret == ESP_ERR_TIMEOUT);
+        sent += (ret == ESP_OK);
+        if (b % 4 == 3) {
+            vTaskDelay(pdMS_TO_TICKS(2));
+        }
+    }
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, stream_tx_submit(tx, 0, 0, s, STREAM_TX_BLOCK_SAMPLES + 1));
+
+    // Let the task drain the queue
+    for (int i = 0; i < 500 && lb.dec.frames < sent; i++) {
+        vTaskDelay(pdMS_TO_TICKS(2));
+    }
+
+    stream_tx_stats_t stats;
+    stream_tx_get_stats(tx, &stats);
+    TEST_ASSERT_EQUAL_UINT32(sent, stats.frames);
+    TEST_ASSERT_EQUAL_UINT32(50 - sent, stats.dropped_blocks);
+    TEST_ASSERT_EQUAL_UINT32(stats.bytes, lb.dec.bytes);
+    stream_tx_stop(tx);
+
+    // Every accepted block arrived; every rejected one before the last is a sequence gap
+    TEST_ASSERT_EQUAL_UINT32(sent, lb.dec.frames);
+    TEST_ASSERT_EQUAL_UINT32(0, lb.dec.bad_frames);
+    TEST_ASSERT_EQUAL_UINT32(lb.cap.hdr.seq + 1, lb.dec.frames + lb.dec.lost_frames);
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)sent * STREAM_TX_BLOCK_SAMPLES, lb.dec.samples_out);
+}
+
+// =============================
+// Benchmark
+// =============================
+#define BENCH_FRAMES 20000
+
+TEST_CASE("stream encode and decode throughput", "[stream_proto][bench]")
+{
+    static int16_t s[TEST_N];
+    static uint8_t wire[STREAM_WIRE_MAX_SIZE];
+    static stream_decoder_t dec;
+    make_signal(s, TEST_N, 5);
+
+    const struct { uint8_t enc; const char *name; } encs[] = {
+        {STREAM_ENC_RAW16, "raw16"}, {STREAM_ENC_PACKED12, "packed12"},
+        {STREAM_ENC_DELTA8, "delta8"}, {STREAM_ENC_AUTO, "auto"},
+    };
+
+    // Text baseline: one "ADC Voltage: %d mV" log line per sample
+    size_t text_bytes = 0;
+    for (int i = 0; i < TEST_N; i++) {
+        char line[80];
+        text_bytes += snprintf(line, sizeof(line), "I (123456) ADC_BASIC: ADC Voltage: %d mV\n", s[i]);
+    }
+    printf("[bench] stream_proto: text log %.2f bytes/sample\n", (double)text_bytes / TEST_N);
+
+    for (size_t k = 0; k < sizeof(encs) / sizeof(encs[0]); k++) {
+        stream_decoder_init(&dec, NULL, NULL);
+        size_t bytes = 0;
+        uint64_t c0 = bench_cycles();
+        int64_t t0 = bench_now_us();
+        for (uint32_t f = 0; f < BENCH_FRAMES; f++) {
+            stream_frame_hdr_t hdr = { .encoding = encs[k].enc, .count = TEST_N, .seq = f };
+            size_t len;
+            stream_proto_encode(&hdr, s, wire, sizeof(wire), &len);
+            bytes += len;
+        }
+        uint64_t c1 = bench_cycles();
+        int64_t t1 = bench_now_us();
+        for (uint32_t f = 0; f < BENCH_FRAMES; f++) {
+            stream_decoder_feed(&dec, wire, bytes / BENCH_FRAMES);
+        }
+        uint64_t c2 = bench_cycles();
+
+        printf("[bench] stream_proto %s: %.2f bytes/sample, encode %.1f cycles/sample (%.0f frames/s), decode %.1f cycles/sample\n",
+               encs[k].name, (double)bytes / (BENCH_FRAMES * TEST_N),
+               (double)(c1 - c0) / (BENCH_FRAMES * TEST_N),
+               BENCH_FRAMES * 1e6 / (double)(t1 - t0 > 0 ? t1 - t0 : 1),
+               (double)(c2 - c1) / (BENCH_FRAMES * TEST_N));
+        TEST_ASSERT_EQUAL_UINT32(BENCH_FRAMES, dec.frames);
+    }
+}
@@ -0,0 +1,23 @@
+# SPDX-License-Identifier: CC0-1.0
+# Runs the host test application on the ESP-IDF `linux` target.
+import logging
+
+import pytest
+from pytest_embedded_idf.dut import IdfDut
+from pytest_embedded_idf.utils import idf_parametrize
+
+
+def collect_bench(dut: IdfDut) -> str:
+    # Unity prints the summary after the last test; [bench] lines come before it
+    out = dut.expect(r'(\d+) Tests (\d+) Failures (\d+) Ignored', timeout=120)
+    assert out.group(2) == b'0', 'unit test failures'
+    return dut.pexpect_proc.before.decode('utf-8', errors='replace')
+
+
+@pytest.mark.host_test
+@idf_parametrize('target', ['linux'], indirect=['target'])
+def test_host_units(dut: IdfDut) -> None:
+    log = collect_bench(dut)
+    for line in log.splitlines():
+        if line.startswith('[bench]'):
+            logging.info(line)
@@ -2,11 +2,31 @@
 // Header Files (Your Toolbox)
 // =============================
 
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
-#include "esp_adc/adc_oneshot.h"    // For ADC HW interation
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_timer.h"
 #include "esp_adc/adc_cali.h"       // For voltage calibration
+#include "esp_adc/adc_cali_scheme.h"
+#endif
+#include "adc_source.h"             // Oneshot / continuous acquisition front-end
+#include "spsc_ring.h"              // Lock-free sample hand-off between the tasks
+#include "adc_cali_lut.h"           // Precomputed raw -> mV table
+#include "filter_chain.h"           // Moving average / biquad / FIR stages
+#include "stream_tx.h"              // Binary frames over the console UART
+#include "pipe_timing.h"            // Jitter / latency histograms
+#include "block_pipe.h"             // Zero-copy block pool + pinned stage tasks
+#include "spectral.h"               // Windowed FFT: band powers, dominant frequency
+#include "adc_host.h"               // linux target: mock source, stage timing, benchmark
+#if CONFIG_ESP_CONSOLE_UART && !CONFIG_IDF_TARGET_LINUX
+#include "driver/uart_vfs.h"        // Console line-ending control
+#endif
 
 
 // =============================
@@ -18,194 +38,1041 @@
 // =============================
 // ADC Configuration
 // =============================
-// Define which ADC unit and channel you want to use.
-// For example: ADC1 Channel 6 (Take a look to the ESP32-DevKit Pin Layout)
+// Define which ADC unit and channels you want to use (see adc_channels below).
+// Acquisition mode, sample rate, frame size and the number of channels are
+// set in menuconfig ("ADC Application").
 #define ADC_UNIT       ADC_UNIT_1
-#define ADC_CHANNEL    ADC_CHANNEL_6   // GPIO34
-#define BUFFER_SIZE    256             // Circular buffer length
-#define ADC_SAMPLE_PERIOD_MS 100       // Sampling period (ms)
+#define ADC_ATTEN      ADC_ATTEN_DB_11 // ~3.3V full-scale voltage range
+#define ADC_NUM_CHANNELS CONFIG_ADC_ACQ_NUM_CHANNELS
+#define ADC_LUT_BITWIDTH 12            // ADC_BITWIDTH_DEFAULT on ESP32
+#define ADC_ATTEN_COUNT  4             // ADC_ATTEN_DB_0 .. ADC_ATTEN_DB_11
+#define BUFFER_SIZE    4096            // Ring length per channel, power of two (~200 ms at 20 kHz)
+#define FILTER_BLOCK   256             // Samples filtered per chain call
+#define ADC_SAMPLE_PERIOD_MS 100       // Filter output period (ms)
+#define ADC_READ_TIMEOUT_MS  1000      // Max wait for one frame
+#define ADC_EVENT_TIMEOUT_MS 1000      // Event mode: filter task wakes at least this often
+#define ADC_JITTER_BIN_US    10        // Jitter histogram: +-160 us around the nominal period
+#if CONFIG_ADC_SCHED_EVENT || CONFIG_ADC_PIPE_BLOCKS
+#define ADC_LATENCY_BIN_US   100       // Latency histogram: 0..3.2 ms
+#else
+#define ADC_LATENCY_BIN_US   (ADC_SAMPLE_PERIOD_MS * 1000 / 16)   // 0..2 filter periods
+#endif
+#define ADC_FRAME_US  ((int64_t)CONFIG_ADC_ACQ_FRAME_SAMPLES * 1000000 / CONFIG_ADC_ACQ_SAMPLE_RATE_HZ)
+#define STREAM_TASK_PRIORITY 2         // Below sampling (5) and filtering (4)
+#define STREAM_TASK_STACK    (4096 + ADC_HOST_STACK_EXTRA)   // Encoder scratch lives on this stack
+#define ADC_ACQ_STACK        (3072 + ADC_HOST_STACK_EXTRA)   // Sampling task
+#define ADC_FILTER_STACK     (3072 + ADC_HOST_STACK_EXTRA)   // Filter stage of the block pipeline
+#if CONFIG_ADC_SPECTRAL
+#define ADC_PROC_STACK       (4096 + ADC_HOST_STACK_EXTRA)   // Filter / output tasks: float log formatting
+#else
+#define ADC_PROC_STACK       (3072 + ADC_HOST_STACK_EXTRA)   // Filter / output tasks
+#endif
+#if CONFIG_ADC_PIPE_BLOCKS
+#define ADC_ACQ_CORE         0         // Sampling task (the ADC / DMA interrupts land here too)
+#if CONFIG_ADC_PIPE_DUAL_CORE
+#define ADC_PROC_CORE        1         // Filter and output stages on the other core
+#else
+#define ADC_PROC_CORE        0         // Everything on one core, for comparison
+#endif
+#define ADC_PIPE_LOAD_PCT    80        // Core share the capacity estimate plans with
+#endif
+
+// On the host the signal is replayed faster than real time: frame timestamps
+// are wall time, so periods derived from the sample rate shrink by the speed.
+#if CONFIG_IDF_TARGET_LINUX
+#define adc_now_us()         adc_host_now_us()
+#define ADC_TIME_SCALE       adc_host_speed()
+#else
+#define adc_now_us()         esp_timer_get_time()
+#define ADC_TIME_SCALE       1
+#endif
+// Stream timestamps are on the signal's clock: capture times scaled back by the speed
+#define ADC_STREAM_US(t)     ((t) * ADC_TIME_SCALE)
+
+
+// =============================
+// Channel Table
+// =============================
+// The first ADC_NUM_CHANNELS entries are scanned, in this order (ESP32 ADC1,
+// take a look to the ESP32-DevKit Pin Layout). rate_div = N keeps every Nth
+// scan of that channel, for slow signals next to fast ones.
+static const adc_source_channel_cfg_t adc_channels[ADC_SOURCE_MAX_CHANNELS] = {
+    { .channel = ADC_CHANNEL_6, .atten = ADC_ATTEN, .rate_div = 1 },   // GPIO34
+    { .channel = ADC_CHANNEL_7, .atten = ADC_ATTEN, .rate_div = 1 },   // GPIO35
+    { .channel = ADC_CHANNEL_4, .atten = ADC_ATTEN, .rate_div = 1 },   // GPIO32
+    { .channel = ADC_CHANNEL_5, .atten = ADC_ATTEN, .rate_div = 1 },   // GPIO33
+    { .channel = ADC_CHANNEL_0, .atten = ADC_ATTEN, .rate_div = 1 },   // GPIO36 (VP)
+    { .channel = ADC_CHANNEL_3, .atten = ADC_ATTEN, .rate_div = 1 },   // GPIO39 (VN)
+    { .channel = ADC_CHANNEL_1, .atten = ADC_ATTEN, .rate_div = 1 },   // GPIO37 (not on most DevKits)
+    { .channel = ADC_CHANNEL_2, .atten = ADC_ATTEN, .rate_div = 1 },   // GPIO38 (not on most DevKits)
+};
 
 
 // =============================
 // Global Handles
 // =============================
 // Shared between tasks
-static adc_oneshot_unit_handle_t adc_handle;  // ADC driver handle
-static adc_cali_handle_t adc_cali_handle;     // Calibration handle
+static adc_source_t *adc_src;                                  // ADC acquisition source
+#if !CONFIG_IDF_TARGET_LINUX
+static adc_cali_handle_t adc_cali_handle[ADC_ATTEN_COUNT];     // Calibration handle per attenuation
+#endif
+static adc_cali_lut_t *adc_cali_lut[ADC_ATTEN_COUNT];          // Calibration table (NULL = raw fallback)
 
 
 // =============================
-// Circular Buffer Declaration
+// Per-Channel Pipeline
 // =============================
-// Stores the latest ADC samples
-static int16_t adc_buffer[BUFFER_SIZE];     // vector of size 256
-static volatile size_t buffer_index = 0;    // index pointing to  where the next sample will be written
+// Each channel has its own ring and filter state: calibrated samples travel
+// from adc_sampling (only producer) to adc_filtering (only consumer) through a
+// lock-free SPSC ring, and the filter chain runs on one channel's contiguous
+// run at a time. Stage state lives here so nothing is allocated at runtime.
+// Moving average -> mains notch -> low-pass, all optional except the average.
+// (The block pipeline below needs no rings: blocks carry the runs.)
+//
+// Stream timestamps come from the source's capture times: the sampling task
+// carries a channel's clock on from run to run at the channel's rate, and
+// restarts it from the next capture time after anything was lost (source
+// drops, missed scans, ring overruns, starved blocks), so a loss shows up as
+// a jump in the timestamps.
+#if CONFIG_ADC_PIPE_RING
+#define ADC_STAMP_DEPTH  8              // Clock restarts queued per channel
+
+// Ring position (samples pushed) and stream time where a clock restarted
+typedef struct {
+    uint32_t pos;
+    int64_t  us;
+} adc_stamp_t;
+#endif
+
+typedef struct {
+#if CONFIG_ADC_PIPE_RING
+    int16_t ring_storage[BUFFER_SIZE];          // Ring storage (4096 samples, 8 KB)
+    spsc_ring_t ring;                           // Indexes + overrun/underrun counters
+    uint32_t last_overruns;                     // Already reported
+#endif
+    int16_t ma_hist[CONFIG_ADC_FILTER_MA_WINDOW];
+    filter_biquad_t notch[1];
+    filter_biquad_t lowpass[1];
+    filter_stage_t stages[3];
+    filter_chain_t chain;
+    uint64_t filtered_total;                    // Samples filtered so far
+    int64_t clock_us;                           // Stream time of sample clock_at; the ones
+    uint64_t clock_at;                          // after it follow at the channel's rate
+    // Written by the sampling task
+    int64_t acq_base_us;                        // Stream time where the clock last restarted
+    uint64_t acq_count;                         // Samples handed on since then
+    bool acq_in_step;                           // Clear after a loss: restart at the next run
+#if CONFIG_ADC_PIPE_RING
+    uint32_t acq_pushed;                        // Samples stored in the ring
+    QueueHandle_t stamps;                       // adc_stamp_t, sampling -> filter task
+#endif
+#if CONFIG_ADC_SPECTRAL
+    spectral_t spectral;                        // Window history + band bins
+#if CONFIG_ADC_SPECTRAL_TRACK_HZ > 0
+    spectral_sdft_t track;                      // Sliding DFT of the tracked frequency
+#endif
+    uint64_t spectral_logged;                   // Text: end of the last logged window
+#endif
+} adc_channel_ctx_t;
+
+static adc_channel_ctx_t adc_chan[ADC_NUM_CHANNELS];
+
+// Stream time of the sample n after the one at base_us, on channel c's sample clock
+static inline int64_t adc_clock_us(int c, int64_t base_us, int64_t n)
+{
+    return base_us + n * adc_channels[c].rate_div * 1000000LL / CONFIG_ADC_ACQ_SAMPLE_RATE_HZ;
+}
+
+// Something was lost for every channel: restart all clocks at the next runs
+static void adc_clock_restart(void)
+{
+    for (int c = 0; c < ADC_NUM_CHANNELS; c++) {
+        adc_chan[c].acq_in_step = false;
+    }
+}
+#if CONFIG_ADC_PIPE_RING
+static int16_t adc_mv_block[CONFIG_ADC_ACQ_FRAME_SAMPLES + 1]; // One channel run converted to mV
+static int16_t filter_work[FILTER_BLOCK];    // Filter output of one ring span
+#endif
 
 
 // =============================
-// ADC Unit Initialization + Channel Configuration + Calibration
+// Pipeline Timing
 // =============================
-// Function to initialize the ADC unit, configure the channel, and set up calibration.
-// Returns a handle to the initialized ADC unit.
-adc_oneshot_unit_handle_t init_adc(void)
-{
+// The sampling task notifies the filter task after every frame; the
+// notification value is the conversion time (low 32 bits of esp_timer) of the
+// frame's last scan. In event mode the filter task sleeps on it; in polled mode
+// it only reads it, to measure latency the same way.
+#if CONFIG_ADC_PIPE_RING
+static TaskHandle_t filter_task;
+#endif
+static jitter_meter_t acq_jitter;            // Owned by adc_sampling
+static timing_hist_t filter_latency;         // Owned by adc_filtering (block pipeline: the output stage)
 
-    esp_err_t ret;
 
-    // ==============================
-    // 1️⃣ ADC Unit Configuration
-    // ==============================
-
-    // STEP 1A : Create a Handle (Done - Alrady defined globally)
-    // A handle is like a "pointer" or reference to a software object that represents
-    // the ADC hardware inside ESP-IDF. This handle will be used for all future ADC calls.
-    // (At this point, adc_handle is just a NULL pointer.)
-    // static adc_oneshot_unit_handle_t adc_handle;    // Reference to ADC driver
-
-    // STEP 1B : Define the ADC Unit configuration structure
-    // This structure describes global settings for the ADC peripheral.
-    // - unit_id: Which ADC hardware block (ADC1 or ADC2)
-    adc_oneshot_unit_init_cfg_t init_config = {
-        .unit_id = ADC_UNIT_1,   // Use ADC1 block
-    };
-    // Nothing is initialized yet. This is just the **desired configuration**.
-
-    // STEP 1C : Initialize ADC unit using the ESP-IDF API
-    // Function: adc_oneshot_new_unit(init_config, &adc_handle)
-    // What it does:
-    // 1. Allocates memory for the ADC driver object
-    // 2. Programs ADC hardware registers according to init_config
-    // 3. Updates adc_handle to point to this driver object
-    ret = adc_oneshot_new_unit(&init_config, &adc_handle);
-    if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "ADC Unit initialized successfully!");
-    } else {
-        ESP_LOGE(TAG, "Failed to initialize ADC unit! Error code: %d", ret);
-        return NULL; // Stop if initialization failed
-    }
-    // Now adc_handle points to a fully initialized ADC driver object
-    // but the ADC channel/pin and input scaling are not set yet.
-
-    // ==============================
-    // 2️⃣ ADC Channel Configuration
-    // ==============================
-
-    // STEP 2B : Define the Channel Configuration structure
-    // This is a separate configuration structure that describes how to read from a specific ADC channel (pin).
-    // - bitwidth: Resolution of conversion (default 12-bit)
-    // - attenuation: How much input voltage the ADC can measure (~3.3V for DB_11)
-    adc_oneshot_chan_cfg_t chan_config = {
-        .bitwidth = ADC_BITWIDTH_DEFAULT,  // Default 12-bit resolution
-        .atten = ADC_ATTEN_DB_11           // ~3.3V full-scale voltage range
-    };
+// =============================
+// Block Pipeline
+// =============================
+// CONFIG_ADC_PIPE_BLOCKS replaces the rings with a fixed pool of blocks
+// (components/block_pipe). The sampling task, pinned to ADC_ACQ_CORE, writes
+// the calibrated mV of every channel run into a free block (the source has
+// already copied the raw codes out of the driver and de-interleaved them);
+// the filter and output stages run in their own tasks on ADC_PROC_CORE and
+// work on that same block in place, so only the block pointer moves between
+// the tasks. Blocks go back to the pool after the output stage.
+#if CONFIG_ADC_PIPE_BLOCKS
+typedef struct {
+    int64_t  last_print_us;                  // Text: latest values, every ADC_SAMPLE_PERIOD_MS
+    int64_t  last_report_us;                 // Text: latency, once per second
+    uint32_t last_tx_dropped;                // Binary: already reported
+} adc_output_ctx_t;
 
-    // STEP 2C: [ BLANK]
-    ret = adc_oneshot_config_channel(adc_handle, ADC_CHANNEL, &chan_config);
-    if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "ADC channel configured successfully!");
-    } else {
-        ESP_LOGE(TAG, "Failed to configure ADC channel! Error code: %d", ret);
-        return NULL;
-    }
+static block_pipe_t *adc_pipe;
+static adc_output_ctx_t adc_output;          // Owned by the output stage
+static int64_t acq_busy_us;                  // Owned by adc_sampling: time spent converting
+static uint64_t acq_samples;                 // ... for this many samples
+#endif
 
-    // ==============================
-    // 3️⃣ ADC Calibration Initialization
-    // ==============================
 
-    // Calibration is optional but recommended for accurate voltage readings.
-    // On ESP32, raw ADC values may vary due to temperature, voltage supply, and manufacturing.
-    // The calibration API converts raw readings to mV.
+// =============================
+// Spectral Analysis
+// =============================
+// CONFIG_ADC_SPECTRAL analyses the filtered samples of every channel in
+// overlapping windows (components/spectral). Binary output then sends one
+// feature vector per window instead of the samples:
+//   [mean, rms, dominant_hz, total_power, delta, theta, alpha, beta, (tracked)]
+#if CONFIG_ADC_SPECTRAL
+static const spectral_band_t adc_bands[] = {
+    { 0.5f, 4.0f },     // Delta
+    { 4.0f, 8.0f },     // Theta
+    { 8.0f, 13.0f },    // Alpha
+    { 13.0f, 30.0f },   // Beta
+};
+#define ADC_NUM_BANDS            (sizeof(adc_bands) / sizeof(adc_bands[0]))
+#define ADC_SPECTRAL_MAX_RESULTS 4     // Windows handled per spectral_process() call
+#define ADC_NUM_FEATURES         (4 + ADC_NUM_BANDS + (CONFIG_ADC_SPECTRAL_TRACK_HZ > 0))
+
+static spectral_plan_t adc_plan;             // Window + twiddles; shared, analysis runs in one task
+static spectral_result_t adc_spectral_res[ADC_SPECTRAL_MAX_RESULTS];
+#endif
+
+
+// =============================
+// Binary Output
+// =============================
+#if CONFIG_ADC_OUTPUT_BINARY
+static stream_tx_t *stream_tx;               // Filtered blocks -> UART frames
+#endif
+
+
+// =============================
+// ADC Calibration Initialization
+// =============================
+// Calibration is optional but recommended for accurate voltage readings.
+// On ESP32, raw ADC values may vary due to temperature, voltage supply, and manufacturing.
+// The calibration API converts raw readings to mV. It works on raw codes only,
+// so the same handle serves both the oneshot and the continuous source.
+// Calibration depends on the attenuation: channels that share one also share
+// the handle and the table.
+static void init_calibration(adc_atten_t atten)
+{
+#if CONFIG_IDF_TARGET_LINUX
+    // No eFuse values on the host: a nominal straight line stands in
+    if (!adc_cali_lut[atten] && adc_host_cali_lut_new(atten, &adc_cali_lut[atten]) != ESP_OK) {
+        ESP_LOGW(TAG, "Calibration table unavailable. Using raw ADC values.");
+    }
+#else
+    esp_err_t ret = ESP_ERR_NOT_SUPPORTED;
+
+    if (adc_cali_handle[atten] || adc_cali_lut[atten]) {
+        return;     // Already done for another channel
+    }
 
-    // Step 3A: Define the Calibration configuration structure
-    // This structure describes how the calibration should be performed.
-    // - unit_id: Which ADC unit (must match the one used before)
+    // Step 1: Create the calibration scheme the chip supports
+    // - unit_id: Which ADC unit (must match the one used for sampling)
     // - atten: Must match the attenuation used in channel config
     // - bitwidth: Must match the bitwidth used in channel config
+    // (ESP32 only has line fitting; newer chips use curve fitting)
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
     adc_cali_curve_fitting_config_t cali_cfg = {
-        .unit_id = ADC_UNIT,               // Same ADC unit as before
-        .atten = ADC_ATTEN_DB_11,          // Same attenuation as channel config
+        .unit_id = ADC_UNIT,               // Same ADC unit as the source
+        .atten = atten,                    // Same attenuation as channel config
         .bitwidth = ADC_BITWIDTH_DEFAULT   // Same bitwidth as channel config
     };
+    ret = adc_cali_create_scheme_curve_fitting(&cali_cfg, &adc_cali_handle[atten]);
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t cali_cfg = {
+        .unit_id = ADC_UNIT,
+        .atten = atten,
+        .bitwidth = ADC_BITWIDTH_DEFAULT
+    };
+    ret = adc_cali_create_scheme_line_fitting(&cali_cfg, &adc_cali_handle[atten]);
+#endif
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "ADC calibration not available (atten %d). Using raw ADC values.", atten);
+        adc_cali_handle[atten] = NULL;   // Use raw values if calibration fails
+        return;
+    }
 
-    // Step 3B: Initialize Calibration using ESP-IDF API
-    // Function: adc_cali_create_scheme_curve_fitting(&cali_cfg, &handle)
-    // What it does:
-    // - Allocates memory for calibration object
-    // - Prepares math to convert raw ADC → voltage (mV)
-    if (adc_cali_create_scheme_curve_fitting(&cali_cfg, &adc_cali_handle) == ESP_OK) {
-        ESP_LOGI(TAG, "ADC calibration ready.");
-    } else {
-        ESP_LOGW(TAG, "ADC calibration not available. Using raw ADC values.");
-        adc_cali_handle = NULL;          // Use raw values if calibration fails
+    // Step 2: Evaluate the calibration once for every raw code
+    // The per-sample hot path then becomes a single table load (8 KB for 12-bit).
+    if (adc_cali_lut_new_from_handle(adc_cali_handle[atten], ADC_LUT_BITWIDTH, &adc_cali_lut[atten]) != ESP_OK) {
+        ESP_LOGW(TAG, "Calibration table unavailable. Using raw ADC values.");
+        adc_cali_lut[atten] = NULL;
+        return;
+    }
+
+    // Step 3: Check the table against the driver, code by code
+    // It must give exactly what adc_cali_raw_to_voltage() would have.
+    uint32_t mismatches = 0;
+    if (adc_cali_lut_verify_handle(adc_cali_lut[atten], adc_cali_handle[atten], &mismatches) != ESP_OK) {
+        ESP_LOGE(TAG, "Calibration table differs from the driver in %lu codes (atten %d). Using raw ADC values.",
+                 (unsigned long)mismatches, atten);
+        adc_cali_lut_del(adc_cali_lut[atten]);
+        adc_cali_lut[atten] = NULL;
+        return;
+    }
+    ESP_LOGI(TAG, "ADC calibration ready (atten %d), table matches the driver.", atten);
+#endif
+}
+
+// =============================
+// ADC Source Initialization
+// =============================
+// Creates the acquisition source selected in menuconfig (see adc_source.h)
+// for the first ADC_NUM_CHANNELS entries of the channel table, and the
+// calibration handles (on the linux target: the host source, see adc_host.h).
+// Returns NULL on failure.
+adc_source_t *init_adc(void)
+{
+    esp_err_t ret;
+    adc_source_t *src = NULL;
+
+    adc_source_config_t src_cfg = {
+        .unit = ADC_UNIT,
+        .sample_rate_hz = CONFIG_ADC_ACQ_SAMPLE_RATE_HZ,
+        .frame_samples = CONFIG_ADC_ACQ_FRAME_SAMPLES,
+        .num_channels = ADC_NUM_CHANNELS,
+#if CONFIG_ADC_SCHED_EVENT
+        .trigger = ADC_SOURCE_TRIGGER_TIMER,     // Oneshot: gptimer instead of the tick
+#endif
+    };
+    memcpy(src_cfg.channels, adc_channels, sizeof(adc_channels));
+
+#if CONFIG_IDF_TARGET_LINUX
+    ret = adc_host_source_new(&src_cfg, &src);     // Either mode: the host stand-in replays a signal
+#elif CONFIG_ADC_ACQ_MODE_CONTINUOUS
+    ret = adc_source_new_continuous(&src_cfg, &src);
+#else
+    ret = adc_source_new_oneshot(&src_cfg, &src);
+#endif
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create ADC source! Error code: %d", ret);
+        return NULL;
+    }
+
+    for (int c = 0; c < ADC_NUM_CHANNELS; c++) {
+        init_calibration(adc_channels[c].atten);
+    }
+
+    ret = adc_source_start(src);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start ADC source! Error code: %d", ret);
+        adc_source_del(src);
+        return NULL;
     }
 
     // --- End of setup ---
     ESP_LOGI(TAG, "ADC is now initialized and ready for sampling.");
+    return src;
+}
+
+// =============================
+// Stack Report
+// =============================
+// Tasks of this application, with the names and stack sizes passed to
+// xTaskCreate in app_main (or to the block pipeline and stream_tx).
+typedef struct {
+    const char *name;
+    uint32_t    stack;
+} adc_task_info_t;
+
+static const adc_task_info_t adc_tasks[] = {
+    { "ADC Sampling", ADC_ACQ_STACK },
+#if CONFIG_ADC_PIPE_BLOCKS && CONFIG_ADC_PIPE_STAGES == 2
+    { "ADC Filtering", ADC_FILTER_STACK },
+    { "ADC Output", ADC_PROC_STACK },
+#else
+    { "ADC Filtering", ADC_PROC_STACK },
+#endif
+#if CONFIG_ADC_OUTPUT_BINARY
+    { "Stream TX", STREAM_TASK_STACK },
+#endif
+};
+#define ADC_NUM_TASKS  (sizeof(adc_tasks) / sizeof(adc_tasks[0]))
+
+// Called by adc_sampling once per second: logs a task's stack high-water
+// mark the first time and whenever it has grown, so the log holds the least
+// free stack each task has had.
+static void report_stacks(void)
+{
+    static uint32_t last_free[ADC_NUM_TASKS];
+    static bool reported[ADC_NUM_TASKS];
+
+    for (size_t i = 0; i < ADC_NUM_TASKS; i++) {
+        TaskHandle_t task = xTaskGetHandle(adc_tasks[i].name);
+        if (!task) {
+            continue;
+        }
+        uint32_t free_bytes = uxTaskGetStackHighWaterMark(task) * sizeof(StackType_t);
+        if (!reported[i] || free_bytes < last_free[i]) {
+            ESP_LOGI(TAG, "Stack %s: %lu of %lu bytes free", adc_tasks[i].name,
+                     (unsigned long)free_bytes, (unsigned long)adc_tasks[i].stack);
+            last_free[i] = free_bytes;
+            reported[i] = true;
+        }
+    }
+}
+
+#if CONFIG_ADC_PIPE_BLOCKS && CONFIG_ADC_OUTPUT_TEXT
+// =============================
+// Pipeline Report
+// =============================
+// Called by adc_sampling once per second: what each task spent per sample
+// since the last report, the scan rate the capacity model derives from those
+// costs with all tasks on one core and split across two (an upper bound:
+// hand-offs are not in it), and the measured load per core.
+static void report_pipeline(void)
+{
+    static int64_t last_acq_busy_us;
+    static uint64_t last_acq_samples;
+    static block_pipe_stats_t last;
+    static block_pipe_load_snap_t load_snap;
+
+    block_pipe_stats_t now;
+    block_pipe_get_stats(adc_pipe, &now);
+
+    // --- 1. Nanoseconds per sample: acquisition, then every stage ---
+    uint32_t ns[1 + BLOCK_PIPE_MAX_STAGES];
+    BaseType_t one_core[1 + BLOCK_PIPE_MAX_STAGES];
+    BaseType_t two_cores[1 + BLOCK_PIPE_MAX_STAGES];
+    uint64_t n = acq_samples - last_acq_samples;
+    ns[0] = n ? (uint32_t)((acq_busy_us - last_acq_busy_us) * 1000 / n) : 0;
+    one_core[0] = two_cores[0] = 0;
+    for (uint32_t s = 0; s < now.num_stages; s++) {
+        n = now.stage[s].samples - last.stage[s].samples;
+        ns[1 + s] = n ? (uint32_t)((now.stage[s].busy_us - last.stage[s].busy_us) * 1000 / n) : 0;
+        one_core[1 + s] = 0;
+        two_cores[1 + s] = 1;
+    }
+    last_acq_busy_us = acq_busy_us;
+    last_acq_samples = acq_samples;
+    last = now;
+
+#if CONFIG_ADC_PIPE_STAGES == 2
+    ESP_LOGI(TAG, "Pipeline cost: acquire %lu, filter %lu, output %lu ns/sample",
+             (unsigned long)ns[0], (unsigned long)ns[1], (unsigned long)ns[2]);
+#else
+    ESP_LOGI(TAG, "Pipeline cost: acquire %lu, filter+output %lu ns/sample",
+             (unsigned long)ns[0], (unsigned long)ns[1]);
+#endif
 
-    // Return the ADC driver handle in case the caller wants it
-    return adc_handle;
+    // --- 2. Sustainable scan rate (samples of all channels share the budget) ---
+    uint32_t single = block_pipe_capacity_hz(ns, one_core, 1 + now.num_stages, ADC_PIPE_LOAD_PCT);
+    uint32_t dual = block_pipe_capacity_hz(ns, two_cores, 1 + now.num_stages, ADC_PIPE_LOAD_PCT);
+    ESP_LOGI(TAG, "Capacity model at %d%% load: ~%lu scans/s on one core, ~%lu on two; %lu/%d blocks in flight max, %lu starved",
+             ADC_PIPE_LOAD_PCT, (unsigned long)(single / ADC_NUM_CHANNELS), (unsigned long)(dual / ADC_NUM_CHANNELS),
+             (unsigned long)now.in_flight_max, CONFIG_ADC_PIPE_DEPTH, (unsigned long)now.starved);
 
+    // --- 3. Measured load (needs CONFIG_ADC_PIPE_CPU_STATS) ---
+    uint8_t load[portNUM_PROCESSORS];
+    if (block_pipe_core_load(&load_snap, load) == ESP_OK) {
+#if portNUM_PROCESSORS > 1
+        ESP_LOGI(TAG, "CPU load: core 0 %u%%, core 1 %u%%", load[0], load[1]);
+#else
+        ESP_LOGI(TAG, "CPU load: core 0 %u%%", load[0]);
+#endif
+    }
 }
+#endif
 
 // =============================
 // FreeRTOS Task: ADC Sampling
 // =============================
+// Pulls whole frames from the source; the source itself does the pacing
+// (tick, timer alarm or DMA interrupt). Frames arrive de-interleaved, one
+// contiguous run per channel.
 void adc_sampling(void *arg)
 {
+    int64_t last_report_us = 0;
+    uint32_t last_lost = 0;
+#if CONFIG_ADC_OUTPUT_TEXT
+    char line[96];
+#endif
+#if CONFIG_ADC_OUTPUT_BINARY
+    uint32_t last_dropped = 0;
+#if CONFIG_ADC_PIPE_BLOCKS
+    uint32_t last_starved = 0;
+#endif
+#endif
+
     while (1) {
 
-        int raw = 0;
-        uint16_t voltage = 0; // Calibrated voltage in mV
+        adc_frame_t frame;
+
+        // --- 1. Wait for the next frame of raw samples ---
+        if (adc_source_read(adc_src, &frame, ADC_READ_TIMEOUT_MS) != ESP_OK) {
+            continue;
+        }
+        jitter_meter_add(&acq_jitter, frame.timestamp_us);
+        ADC_HOST_FRAME();
+
+        // Frames or scans the source lost since the last frame
+        adc_source_stats_t src_stats;
+        adc_source_get_stats(adc_src, &src_stats);
+        if (src_stats.dropped_frames + src_stats.missed_scans != last_lost) {
+            last_lost = src_stats.dropped_frames + src_stats.missed_scans;
+            adc_clock_restart();
+        }
+
+#if CONFIG_ADC_PIPE_BLOCKS
+        // --- 2. Take a free block (never waits: if the stages are behind, the
+        //        frame is dropped and counted as starved) ---
+        pipe_block_t *blk = block_pipe_acquire(adc_pipe, 0);
+        int64_t conv_start_us = adc_now_us();
+#endif
+        ADC_STAGE_BEGIN(acq_mark);
+        size_t frame_samples = 0;       // Runs differ with rate dividers or after a resync
+        uint32_t newest_scan = 0;       // Scan of the newest sample, from the start of the frame
 
-        // --- 1. Read raw ADC value ---
-        adc_oneshot_read(adc_handle, ADC_CHANNEL, &raw); // ESP-IDF API
+        for (uint32_t c = 0; c < frame.num_channels; c++) {
+            const adc_frame_chan_t *run = &frame.chan[c];
+#if CONFIG_ADC_PIPE_BLOCKS
+            if (!blk) {
+                adc_clock_restart();                 // The frame is dropped
+                break;
+            }
+            int16_t *mv = blk->data[c];              // mV go into the block; the stages work on it in place
+            blk->len[c] = run->len;
+            acq_samples += run->len;
+#else
+            int16_t *mv = adc_mv_block;
+#endif
+            frame_samples += run->len;
+            if (run->len > 0 && (run->len - 1) * adc_channels[c].rate_div > newest_scan) {
+                newest_scan = (run->len - 1) * adc_channels[c].rate_div;
+            }
+
+            // --- 3. Convert the channel's run to calibrated voltage (mV) via the table ---
+            // (raw codes are passed through if calibration is unavailable)
+            adc_cali_lut_raw_to_mv_block(adc_cali_lut[adc_channels[c].atten], run->data, mv, run->len);
+
+#if CONFIG_ADC_ACQ_MODE_ONESHOT && CONFIG_ADC_OUTPUT_TEXT
+            // --- 4. Optional: Print to serial (only affordable at low rates) ---
+            for (size_t i = 0; i < run->len; i++) {
+                ESP_LOGI(TAG, "ADC Voltage (ch %d): %d mV", run->channel, mv[i]);
+            }
+#endif
+
+            // --- 5. Stream time: where the last run ended, or its capture time after a loss ---
+            adc_channel_ctx_t *ch = &adc_chan[c];
+            bool restart = !ch->acq_in_step && run->len > 0;
+            if (restart) {
+                ch->acq_base_us = ADC_STREAM_US(run->timestamp_us);
+                ch->acq_count = 0;
+                ch->acq_in_step = true;
+            }
+#if CONFIG_ADC_PIPE_BLOCKS
+            blk->chan_us[c] = adc_clock_us(c, ch->acq_base_us, (int64_t)ch->acq_count);
+            ch->acq_count += run->len;
+#else
+            // --- 6. Hand the run to the channel's filter (overruns are counted by the ring) ---
+            // A restart is queued before the samples, so the filter task has it when it reads them
+            if (restart) {
+                adc_stamp_t stamp = { .pos = ch->acq_pushed, .us = ch->acq_base_us };
+                if (xQueueSend(ch->stamps, &stamp, 0) != pdTRUE) {
+                    ch->acq_in_step = false;         // Queue full: try again with the next run
+                }
+            }
+            size_t stored = spsc_ring_push_n(&ch->ring, mv, run->len);
+            ch->acq_pushed += stored;
+            ch->acq_count += stored;
+            if (stored < run->len) {
+                ch->acq_in_step = false;             // The rest of the run is lost
+            }
+#endif
+        }
+        ADC_STAGE_END(acq_mark, ADC_STAGE_ACQUIRE, frame_samples);
+
+        // --- 7. Pass the frame on, with the conversion time of the newest scan ---
+        int64_t newest_us = frame.timestamp_us +
+                            newest_scan * 1000000LL / CONFIG_ADC_ACQ_SAMPLE_RATE_HZ / ADC_TIME_SCALE;
+#if CONFIG_ADC_PIPE_BLOCKS
+        if (blk) {
+            blk->seq = frame.seq;
+            blk->timestamp_us = frame.timestamp_us;
+            blk->newest_us = newest_us;
+            acq_busy_us += adc_now_us() - conv_start_us;
+            block_pipe_submit(adc_pipe, blk);            // Pointer only
+        }
+#else
+        // (overwrites an unread value: the filter drains everything anyway)
+        xTaskNotify(filter_task, (uint32_t)newest_us, eSetValueWithOverwrite);
+#endif
 
-        // --- 2. Convert raw to calibrated voltage (mV) ---
-        if (adc_cali_handle) {
-            adc_cali_raw_to_voltage(adc_cali_handle, raw, &voltage); // ESP-IDF API
+        // --- 8. Report sustained rate, dropped frames and jitter about once per second ---
+        // (binary mode: only losses are reported, to keep the UART for frames)
+        if (frame.timestamp_us - last_report_us >= 1000000) {
+            adc_source_stats_t stats;
+            adc_source_get_stats(adc_src, &stats);
+#if CONFIG_ADC_OUTPUT_TEXT
+            ESP_LOGI(TAG, "Acquisition: %lu samples/s, %lu dropped frames, %lu missed scans",
+                     (unsigned long)stats.samples_per_sec, (unsigned long)stats.dropped_frames,
+                     (unsigned long)stats.missed_scans);
+            ESP_LOGI(TAG, "Frame jitter: %s, %lu gaps",
+                     timing_hist_summary(&acq_jitter.hist, line, sizeof(line)), (unsigned long)acq_jitter.gaps);
+            timing_hist_reset(&acq_jitter.hist);
+#if CONFIG_ADC_PIPE_BLOCKS
+            report_pipeline();
+#endif
+#else
+            if (stats.dropped_frames != last_dropped) {
+                ESP_LOGW(TAG, "Acquisition: %lu dropped frames", (unsigned long)stats.dropped_frames);
+                last_dropped = stats.dropped_frames;
+            }
+#if CONFIG_ADC_PIPE_BLOCKS
+            block_pipe_stats_t pipe_stats;
+            block_pipe_get_stats(adc_pipe, &pipe_stats);
+            if (pipe_stats.starved != last_starved) {
+                ESP_LOGW(TAG, "Pipeline: %lu frames without a free block", (unsigned long)pipe_stats.starved);
+                last_starved = pipe_stats.starved;
+            }
+#endif
+#endif
+            report_stacks();
+            last_report_us = frame.timestamp_us;
+        }
+    }
+}
+
+// =============================
+// Filter Chain Initialization
+// =============================
+// Builds the stages selected in menuconfig for one channel. Biquads are
+// designed for the channel's actual sample rate (after its rate divider);
+// a stage that cannot work at that rate is skipped.
+static void init_filters(int c)
+{
+    adc_channel_ctx_t *ch = &adc_chan[c];
+    const uint32_t rate = CONFIG_ADC_ACQ_SAMPLE_RATE_HZ / adc_channels[c].rate_div;
+    const float fs = rate;
+    size_t n = 0;
+
+    ch->chain.stages = ch->stages;
+
+    // --- 1. Moving average (always on, window 1 = pass-through) ---
+    filter_stage_init_moving_avg(&ch->stages[n++], ch->ma_hist, CONFIG_ADC_FILTER_MA_WINDOW);
+
+    // --- 2. Mains notch ---
+    if (CONFIG_ADC_FILTER_NOTCH_HZ > 0) {
+        if (filter_biquad_design(FILTER_BIQUAD_NOTCH, fs, CONFIG_ADC_FILTER_NOTCH_HZ, 30.0f, &ch->notch[0]) == ESP_OK) {
+            filter_stage_init_biquad(&ch->stages[n++], ch->notch, 1);
+        } else {
+            ESP_LOGW(TAG, "Notch at %d Hz not possible at %lu Hz sampling. Skipped.",
+                     CONFIG_ADC_FILTER_NOTCH_HZ, (unsigned long)rate);
+        }
+    }
+
+    // --- 3. Low-pass ---
+    if (CONFIG_ADC_FILTER_LOWPASS_HZ > 0) {
+        if (filter_biquad_design(FILTER_BIQUAD_LOWPASS, fs, CONFIG_ADC_FILTER_LOWPASS_HZ, 0.7071f, &ch->lowpass[0]) == ESP_OK) {
+            filter_stage_init_biquad(&ch->stages[n++], ch->lowpass, 1);
         } else {
-            // Fallback if calibration unavailable
-            voltage = raw;
+            ESP_LOGW(TAG, "Low-pass at %d Hz not possible at %lu Hz sampling. Skipped.",
+                     CONFIG_ADC_FILTER_LOWPASS_HZ, (unsigned long)rate);
         }
+    }
+
+    ch->chain.num_stages = n;
+    ESP_LOGI(TAG, "Channel %d: %lu Hz, filter chain ready: %u stage(s)",
+             adc_channels[c].channel, (unsigned long)rate, (unsigned)n);
+}
+
+#if CONFIG_ADC_SPECTRAL
+// =============================
+// Spectral Analysis Initialization
+// =============================
+// One analysis state per channel, on the channel's actual sample rate.
+// adc_plan must be ready (app_main). A tracked frequency the window cannot
+// resolve is dropped with a warning; the band analysis still runs.
+static esp_err_t init_spectral(int c)
+{
+    adc_channel_ctx_t *ch = &adc_chan[c];
+    const uint32_t rate = CONFIG_ADC_ACQ_SAMPLE_RATE_HZ / adc_channels[c].rate_div;
+
+    spectral_config_t cfg = {
+        .sample_rate_hz = rate,
+        .hop = CONFIG_ADC_SPECTRAL_HOP,
+        .num_bands = ADC_NUM_BANDS,
+    };
+    memcpy(cfg.bands, adc_bands, sizeof(adc_bands));
+    esp_err_t ret = spectral_init(&ch->spectral, &adc_plan, &cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Spectral analysis setup failed (ch %d)! Error code: %d", adc_channels[c].channel, ret);
+        return ret;
+    }
 
-        // --- 3. Store calibrated voltage in circular buffer ---
-        adc_buffer[buffer_index] = voltage;
-        buffer_index = (buffer_index + 1) % BUFFER_SIZE; // Wrap around
+#if CONFIG_ADC_SPECTRAL_TRACK_HZ > 0
+    const float track_hz = CONFIG_ADC_SPECTRAL_TRACK_HZ;
+    if (spectral_sdft_init(&ch->track, rate, CONFIG_ADC_SPECTRAL_N, &track_hz, 1) != ESP_OK) {
+        ESP_LOGW(TAG, "Cannot track %d Hz at %lu Hz sampling. Skipped.",
+                 CONFIG_ADC_SPECTRAL_TRACK_HZ, (unsigned long)rate);
+        spectral_sdft_init(&ch->track, rate, CONFIG_ADC_SPECTRAL_N, NULL, 0);
+    }
+#endif
+
+    ESP_LOGI(TAG, "Channel %d: spectral analysis every %d samples, %.2f Hz per bin",
+             adc_channels[c].channel, CONFIG_ADC_SPECTRAL_HOP, (double)rate / CONFIG_ADC_SPECTRAL_N);
+    return ESP_OK;
+}
+
+// =============================
+// Spectral Analysis Step
+// =============================
+// Called with every filtered run of channel c, by the one task that
+// produces the output. Text mode logs one window per second; binary mode
+// sends every window as a feature frame, stamped with the window's end on
+// the channel's sample clock.
+static void adc_analyze(int c, const int16_t *x, size_t n)
+{
+    adc_channel_ctx_t *ch = &adc_chan[c];
+    // At most ADC_SPECTRAL_MAX_RESULTS windows can end in this many samples
+    const size_t step = (size_t)CONFIG_ADC_SPECTRAL_HOP * ADC_SPECTRAL_MAX_RESULTS;
+
+    for (size_t done = 0; done < n; ) {
+        size_t len = (n - done < step) ? n - done : step;
+#if CONFIG_ADC_SPECTRAL_TRACK_HZ > 0
+        spectral_sdft_process(&ch->track, x + done, len);
+#endif
+        size_t windows = spectral_process(&ch->spectral, x + done, len, adc_spectral_res, ADC_SPECTRAL_MAX_RESULTS);
+        done += len;
 
-        // --- 4. Optional: Print to serial ---
-        ESP_LOGI(TAG, "ADC Voltage: %d mV", voltage);
+        for (size_t w = 0; w < windows; w++) {
+            const spectral_result_t *r = &adc_spectral_res[w];
+#if CONFIG_ADC_OUTPUT_TEXT
+            const uint32_t rate = CONFIG_ADC_ACQ_SAMPLE_RATE_HZ / adc_channels[c].rate_div;
+            if (ch->spectral_logged != 0 && r->end_sample - ch->spectral_logged < rate) {
+                continue;
+            }
+            ch->spectral_logged = r->end_sample;
+            ESP_LOGI(TAG, "Spectrum (ch %d): mean %.1f mV, rms %.1f mV, peak %.2f Hz, "
+                     "delta %.1f, theta %.1f, alpha %.1f, beta %.1f mV^2",
+                     adc_channels[c].channel, r->mean, r->rms, r->dominant_hz,
+                     r->band_power[0], r->band_power[1], r->band_power[2], r->band_power[3]);
+#if CONFIG_ADC_SPECTRAL_TRACK_HZ > 0
+            if (ch->track.num_bins > 0) {
+                ESP_LOGI(TAG, "Tracked %.2f Hz (ch %d): %.1f mV^2",
+                         spectral_sdft_freq(&ch->track, 0), adc_channels[c].channel, spectral_sdft_power(&ch->track, 0));
+            }
+#endif
+#else
+            float v[ADC_NUM_FEATURES];
+            v[0] = r->mean;
+            v[1] = r->rms;
+            v[2] = r->dominant_hz;
+            v[3] = r->total_power;
+            memcpy(&v[4], r->band_power, ADC_NUM_BANDS * sizeof(float));
+#if CONFIG_ADC_SPECTRAL_TRACK_HZ > 0
+            v[4 + ADC_NUM_BANDS] = ch->track.num_bins > 0 ? spectral_sdft_power(&ch->track, 0) : 0.0f;
+#endif
+            uint32_t ts_us = (uint32_t)adc_clock_us(c, ch->clock_us, (int64_t)(r->end_sample - ch->clock_at));
+            stream_tx_submit_features(stream_tx, adc_channels[c].channel, ts_us, v, ADC_NUM_FEATURES);
+#endif
+        }
+    }
+}
+#endif  // CONFIG_ADC_SPECTRAL
 
-        // --- 5. Delay for next sample (100 ms) ---
-        vTaskDelay(pdMS_TO_TICKS(ADC_SAMPLE_PERIOD_MS));
+#if CONFIG_ADC_PIPE_RING
+// Applies the clock restarts the sampling task queued up to the filter
+// position, and returns how many samples may be read before the next one:
+// a filtered block never spans a loss.
+static size_t adc_ring_clock(adc_channel_ctx_t *ch)
+{
+    adc_stamp_t stamp;
+    while (xQueuePeek(ch->stamps, &stamp, 0) == pdTRUE) {
+        int32_t ahead = (int32_t)(stamp.pos - (uint32_t)ch->filtered_total);
+        if (ahead > 0) {
+            return ((uint32_t)ahead < FILTER_BLOCK) ? (size_t)ahead : FILTER_BLOCK;
+        }
+        xQueueReceive(ch->stamps, &stamp, 0);
+        ch->clock_us = stamp.us;
+        ch->clock_at = (uint64_t)((int64_t)ch->filtered_total + ahead);
     }
+    return FILTER_BLOCK;
 }
 
 // =============================
 // FreeRTOS Task: Filtering
 // =============================
+// Every sample goes through its channel's chain exactly once, in blocks.
+// Text mode displays the latest filtered value of each channel once per
+// wake-up; binary mode sends every filtered block to the transmit task,
+// tagged with the channel number (or, with spectral analysis, one feature
+// frame per window).
+//
+// Polled mode wakes every ADC_SAMPLE_PERIOD_MS. Event mode sleeps until the
+// sampling task has pushed a frame, so a sample is filtered within one
+// frame-time plus the processing, whatever the period.
 void adc_filtering(void *arg)
 {
-    const size_t filter_size = 5;  // Moving average window
-    int sum = 0;
-    int filtered_value = 0;
+#if CONFIG_ADC_OUTPUT_TEXT
+    int64_t last_report_us = 0;
+    int16_t filtered_value = 0;
+    char line[96];
+#else
+    uint32_t last_tx_dropped = 0;
+#endif
+#if CONFIG_ADC_SCHED_POLLED
+    TickType_t filter_period = pdMS_TO_TICKS(ADC_SAMPLE_PERIOD_MS) / ADC_TIME_SCALE;
+    filter_period = filter_period ? filter_period : 1;
+#endif
 
     while (1) {
-        sum = 0;
+        uint32_t newest_us = 0;
+        size_t woke_with = 0;
+#if CONFIG_ADC_SCHED_EVENT
+        // --- Sleep until a frame is in the rings (the timeout keeps the reports going) ---
+        BaseType_t notified = xTaskNotifyWait(0, 0, &newest_us, pdMS_TO_TICKS(ADC_EVENT_TIMEOUT_MS));
+#else
+        // Control filtering frequency (matches sampling)
+        vTaskDelay(filter_period);
+        BaseType_t notified = xTaskNotifyWait(0, 0, &newest_us, 0);
+#endif
+
+        for (int c = 0; c < ADC_NUM_CHANNELS; c++) {
+            adc_channel_ctx_t *ch = &adc_chan[c];
+            size_t fresh = 0;
+            const int16_t *span;
+            size_t n;
+
+            // The sampling task pushed a frame before notifying: finding this
+            // ring empty is an underrun (the drain below always ends on an empty peek)
+            if (notified == pdTRUE) {
+                spsc_ring_poll(&ch->ring);
+            }
+
+            // Drain everything that arrived since the last run, FILTER_BLOCK at a time
+            // The first stage reads the span in place and writes filter_work
+            while ((n = spsc_ring_peek_n(&ch->ring, &span, adc_ring_clock(ch))) > 0) {
+                ADC_STAGE_BEGIN(filter_mark);
+                filter_chain_process_to(&ch->chain, span, filter_work, n);
+                ADC_STAGE_END(filter_mark, ADC_STAGE_FILTER, n);
+                spsc_ring_consume_n(&ch->ring, n);
+                ADC_HOST_TAP(c, filter_work, n);
+                fresh += n;
+#if CONFIG_ADC_SPECTRAL
+                ADC_STAGE_BEGIN(analyze_mark);
+                adc_analyze(c, filter_work, n);
+                ADC_STAGE_END(analyze_mark, ADC_STAGE_ANALYZE, n);
+#endif
+
+#if CONFIG_ADC_OUTPUT_TEXT
+                filtered_value = filter_work[n - 1];
+#elif !CONFIG_ADC_SPECTRAL   // Binary with analysis: feature frames replace the samples
+                // Timestamp of the block's first sample (a loss before this point is a jump).
+                // Never blocks: a full queue drops the block (sequence gap at the receiver).
+                ADC_STAGE_BEGIN(output_mark);
+                uint32_t ts_us = (uint32_t)adc_clock_us(c, ch->clock_us, (int64_t)(ch->filtered_total - ch->clock_at));
+                stream_tx_submit(stream_tx, adc_channels[c].channel, ts_us, filter_work, n);
+                ADC_STAGE_END(output_mark, ADC_STAGE_OUTPUT, n);
+#endif
+                ch->filtered_total += n;
+            }
+            woke_with += fresh;
 
-        // Compute moving average of last N samples
-        for (size_t i = 0; i < filter_size; i++) {
-            size_t index = (buffer_index + BUFFER_SIZE - 1 - i) % BUFFER_SIZE;
-            sum += adc_buffer[index];
+#if CONFIG_ADC_OUTPUT_TEXT
+            if (fresh > 0) {
+                // Display filtered value
+                ADC_STAGE_BEGIN(output_mark);
+                ESP_LOGI(TAG, "Filtered ADC Voltage (ch %d): %d mV", adc_channels[c].channel, filtered_value);
+                ADC_STAGE_END(output_mark, ADC_STAGE_OUTPUT, fresh);
+            }
+#endif
+
+            // Report samples lost because this task fell behind
+            spsc_ring_stats_t stats;
+            spsc_ring_get_stats(&ch->ring, &stats);
+            if (stats.overruns != ch->last_overruns) {
+                ESP_LOGW(TAG, "Ring overrun (ch %d): %lu samples lost (high-water %lu/%lu)",
+                         adc_channels[c].channel, (unsigned long)(stats.overruns - ch->last_overruns),
+                         (unsigned long)stats.high_water, (unsigned long)stats.capacity);
+                ch->last_overruns = stats.overruns;
+            }
         }
-        filtered_value = sum / filter_size;
 
-        // Display filtered value
-        ESP_LOGI(TAG, "Filtered ADC Voltage: %d mV", filtered_value);
+        // --- End-to-end latency: newest scan converted -> filtered and handed to the output ---
+        int64_t now = adc_now_us();
+        if (notified == pdTRUE) {
+            int32_t latency_us = (int32_t)((uint32_t)now - newest_us);
+            timing_hist_add(&filter_latency, latency_us);
+            ADC_HOST_LATENCY(latency_us);
+        }
+        ADC_HOST_WAKEUP(woke_with);
+#if CONFIG_ADC_OUTPUT_TEXT
+        if (now - last_report_us >= 1000000) {
+            ESP_LOGI(TAG, "Latency: %s", timing_hist_summary(&filter_latency, line, sizeof(line)));
+            timing_hist_reset(&filter_latency);
+            last_report_us = now;
+        }
+#endif
 
-        // Control filtering frequency (matches sampling)
-        vTaskDelay(pdMS_TO_TICKS(ADC_SAMPLE_PERIOD_MS));
+#if CONFIG_ADC_OUTPUT_BINARY
+        // Report blocks the UART could not keep up with
+        stream_tx_stats_t tx_stats;
+        stream_tx_get_stats(stream_tx, &tx_stats);
+        if (tx_stats.dropped_blocks != last_tx_dropped) {
+            ESP_LOGW(TAG, "Stream: %lu blocks dropped",
+                     (unsigned long)(tx_stats.dropped_blocks - last_tx_dropped));
+            last_tx_dropped = tx_stats.dropped_blocks;
+        }
+#endif
+    }
+}
+#endif  // CONFIG_ADC_PIPE_RING
+
+#if CONFIG_ADC_PIPE_BLOCKS
+// =============================
+// Pipeline Stage: Filter
+// =============================
+// Runs every channel's chain over its run, in place inside the block.
+static void adc_stage_filter(pipe_block_t *blk, void *ctx)
+{
+    for (uint32_t c = 0; c < blk->num_channels; c++) {
+        ADC_STAGE_BEGIN(filter_mark);
+        filter_chain_process(&adc_chan[c].chain, blk->data[c], blk->len[c]);
+        ADC_STAGE_END(filter_mark, ADC_STAGE_FILTER, blk->len[c]);
+    }
+}
+
+// =============================
+// Pipeline Stage: Output
+// =============================
+// Same output as adc_filtering: text shows the latest filtered value of each
+// channel every ADC_SAMPLE_PERIOD_MS, binary sends every sample to the
+// transmit task (or only the feature frames of the spectral analysis). The
+// block returns to the pool when this stage is done, so the latency is
+// measured here.
+static void adc_stage_output(pipe_block_t *blk, void *ctx)
+{
+    adc_output_ctx_t *out = (adc_output_ctx_t *)ctx;
+
+    for (uint32_t c = 0; c < blk->num_channels; c++) {
+        adc_channel_ctx_t *ch = &adc_chan[c];
+        ch->clock_us = blk->chan_us[c];
+        ch->clock_at = ch->filtered_total;
+        ADC_HOST_TAP(c, blk->data[c], blk->len[c]);
+#if CONFIG_ADC_SPECTRAL
+        ADC_STAGE_BEGIN(analyze_mark);
+        adc_analyze(c, blk->data[c], blk->len[c]);
+        ADC_STAGE_END(analyze_mark, ADC_STAGE_ANALYZE, blk->len[c]);
+#endif
+        ADC_STAGE_BEGIN(output_mark);
+#if CONFIG_ADC_OUTPUT_TEXT
+        if (blk->len[c] > 0 && blk->newest_us - out->last_print_us >= ADC_SAMPLE_PERIOD_MS * 1000) {
+            ESP_LOGI(TAG, "Filtered ADC Voltage (ch %d): %d mV", adc_channels[c].channel, blk->data[c][blk->len[c] - 1]);
+        }
+        ch->filtered_total += blk->len[c];
+#elif CONFIG_ADC_SPECTRAL
+        ch->filtered_total += blk->len[c];          // Feature frames replace the samples
+#else
+        // The transmit queue takes at most STREAM_TX_BLOCK_SAMPLES per entry
+        for (size_t done = 0; done < blk->len[c]; ) {
+            size_t n = blk->len[c] - done;
+            if (n > STREAM_TX_BLOCK_SAMPLES) {
+                n = STREAM_TX_BLOCK_SAMPLES;
+            }
+            uint32_t ts_us = (uint32_t)adc_clock_us(c, ch->clock_us, (int64_t)done);
+            stream_tx_submit(stream_tx, adc_channels[c].channel, ts_us, blk->data[c] + done, n);
+            ch->filtered_total += n;
+            done += n;
+        }
+#endif
+        ADC_STAGE_END(output_mark, ADC_STAGE_OUTPUT, blk->len[c]);
+    }
+
+    // --- End-to-end latency: newest scan converted -> filtered and handed to the output ---
+    int64_t now = adc_now_us();
+    timing_hist_add(&filter_latency, now - blk->newest_us);
+    ADC_HOST_LATENCY(now - blk->newest_us);
+#if CONFIG_ADC_OUTPUT_TEXT
+    if (blk->newest_us - out->last_print_us >= ADC_SAMPLE_PERIOD_MS * 1000) {
+        out->last_print_us = blk->newest_us;
+    }
+    if (now - out->last_report_us >= 1000000) {
+        char line[96];
+        ESP_LOGI(TAG, "Latency: %s", timing_hist_summary(&filter_latency, line, sizeof(line)));
+        timing_hist_reset(&filter_latency);
+        out->last_report_us = now;
+    }
+#else
+    stream_tx_stats_t tx_stats;
+    stream_tx_get_stats(stream_tx, &tx_stats);
+    if (tx_stats.dropped_blocks != out->last_tx_dropped) {
+        ESP_LOGW(TAG, "Stream: %lu blocks dropped",
+                 (unsigned long)(tx_stats.dropped_blocks - out->last_tx_dropped));
+        out->last_tx_dropped = tx_stats.dropped_blocks;
+    }
+#endif
+}
+
+// One task doing both (CONFIG_ADC_PIPE_STAGES = 1)
+static void adc_stage_filter_output(pipe_block_t *blk, void *ctx)
+{
+    adc_stage_filter(blk, NULL);
+    adc_stage_output(blk, ctx);
+}
+#endif  // CONFIG_ADC_PIPE_BLOCKS
+
+#if CONFIG_IDF_TARGET_LINUX
+// =============================
+// Host Run Report
+// =============================
+// Losses and task stacks for the benchmark report at the end of a host run.
+static void adc_host_info(adc_host_pipe_info_t *info)
+{
+#if CONFIG_ADC_PIPE_BLOCKS
+    info->schedule = "blocks";
+#elif CONFIG_ADC_SCHED_EVENT
+    info->schedule = "event";
+#else
+    TickType_t filter_period = pdMS_TO_TICKS(ADC_SAMPLE_PERIOD_MS) / ADC_TIME_SCALE;
+    info->schedule = "polled";
+    info->wake_us = (int64_t)(filter_period ? filter_period : 1) * portTICK_PERIOD_MS * 1000;
+#endif
+#if CONFIG_ADC_PIPE_RING
+    for (int c = 0; c < ADC_NUM_CHANNELS; c++) {
+        spsc_ring_stats_t stats;
+        spsc_ring_get_stats(&adc_chan[c].ring, &stats);
+        info->ring_overruns += stats.overruns;
+        info->ring_underruns += stats.underruns;
+    }
+#else
+    block_pipe_stats_t pipe_stats;
+    block_pipe_get_stats(adc_pipe, &pipe_stats);
+    info->starved_blocks = pipe_stats.starved;
+#endif
+#if CONFIG_ADC_OUTPUT_BINARY
+    stream_tx_stats_t tx_stats;
+    stream_tx_get_stats(stream_tx, &tx_stats);
+    info->stream_dropped = tx_stats.dropped_blocks;
+#endif
+
+    for (size_t i = 0; i < ADC_NUM_TASKS; i++) {
+        info->tasks[info->num_tasks++] = (adc_host_task_t) { adc_tasks[i].name, adc_tasks[i].stack };
     }
 }
+#endif
 
 
 // =============================
@@ -218,29 +1085,122 @@ void app_main(void)
     ESP_LOGI(TAG, "Starting ADC Initialization and Calibration...");
 
     // --- Initialize ADC ---
-    // ESP-IDF function to setup ADC Unit, Channel, and Calibration
-    // In specific ADC Unit 1 - Channel 6 (GPIO34)
-    adc_handle = init_adc();
-    if (!adc_handle) {
+    // Setup acquisition source (oneshot or continuous) and calibration
+    // In specific ADC Unit 1 - the first ADC_NUM_CHANNELS entries of adc_channels
+    adc_src = init_adc();
+    if (!adc_src) {
         ESP_LOGE(TAG, "ADC initialization failed. Exiting.");
+#if CONFIG_IDF_TARGET_LINUX
+        exit(1);    // Host run (e.g. replay file missing): fail the process, not just the task
+#endif
         return;
     }
 
     
+    // --- Sample ring and filter chain per channel, between the two tasks ---
+    for (int c = 0; c < ADC_NUM_CHANNELS; c++) {
+#if CONFIG_ADC_PIPE_RING
+        ESP_ERROR_CHECK(spsc_ring_init(&adc_chan[c].ring, adc_chan[c].ring_storage, BUFFER_SIZE));
+        adc_chan[c].stamps = xQueueCreate(ADC_STAMP_DEPTH, sizeof(adc_stamp_t));
+        if (!adc_chan[c].stamps) {
+            ESP_LOGE(TAG, "Failed to create stamp queue!");
+            return;
+        }
+#endif
+        init_filters(c);
+    }
+#if CONFIG_ADC_SPECTRAL
+    // --- Spectral analysis after the filters: one shared FFT plan, state per channel ---
+    ESP_ERROR_CHECK(spectral_plan_init(&adc_plan, CONFIG_ADC_SPECTRAL_N, SPECTRAL_WINDOW_HANN));
+    for (int c = 0; c < ADC_NUM_CHANNELS; c++) {
+        if (init_spectral(c) != ESP_OK) {
+            return;
+        }
+    }
+#endif
+    jitter_meter_init(&acq_jitter, ADC_FRAME_US / ADC_TIME_SCALE, ADC_JITTER_BIN_US);
+    timing_hist_init(&filter_latency, 0, ADC_LATENCY_BIN_US);
+
+#if CONFIG_ADC_OUTPUT_BINARY
+    // --- Transmit task for the binary stream ---
+    // Started before the filter task so every filtered block has a taker.
+    // The console normally turns "\n" into "\r\n", which would corrupt frames.
+#if CONFIG_ESP_CONSOLE_UART && !CONFIG_IDF_TARGET_LINUX
+    uart_vfs_dev_port_set_tx_line_endings(CONFIG_ESP_CONSOLE_UART_NUM, ESP_LINE_ENDINGS_LF);
+#endif
+    stream_tx_config_t tx_cfg = {
+        .write = NULL,                              // Console UART (stdout)
+        .encoding = STREAM_ENC_AUTO,
+        .queue_depth = CONFIG_ADC_OUTPUT_QUEUE_BLOCKS,
+        .task_priority = STREAM_TASK_PRIORITY,
+        .task_stack = STREAM_TASK_STACK,
+    };
+    ESP_ERROR_CHECK(stream_tx_start(&tx_cfg, &stream_tx));
+    ESP_LOGI(TAG, "Binary output started. Decode with tools/stream_reader.py");
+#endif
+
     BaseType_t task_status;
 
-    // --- Task for ADC Sampling ---
-    task_status = xTaskCreate(adc_sampling, "ADC Sampling", 2048, NULL, 5, NULL);
-    if (task_status != pdPASS)
-        ESP_LOGE(TAG, "Failed to create ADC sampling task!");
+#if CONFIG_ADC_PIPE_BLOCKS
+    // --- Block pool and stage tasks ---
+    // All blocks are allocated here (internal RAM); nothing is allocated
+    // once the pipeline runs. The stages are started before the sampling task
+    // so every block has a taker.
+    block_pipe_config_t pipe_cfg = {
+        .num_channels = ADC_NUM_CHANNELS,
+        .block_samples = CONFIG_ADC_ACQ_FRAME_SAMPLES + 1,
+        .depth = CONFIG_ADC_PIPE_DEPTH,
+#if CONFIG_ADC_PIPE_STAGES == 2
+        .num_stages = 2,
+        .stages = {
+            { .name = "ADC Filtering", .fn = adc_stage_filter, .ctx = NULL,
+              .core = ADC_PROC_CORE, .priority = 4, .stack = ADC_FILTER_STACK },
+            { .name = "ADC Output", .fn = adc_stage_output, .ctx = &adc_output,
+              .core = ADC_PROC_CORE, .priority = 3, .stack = ADC_PROC_STACK },
+        },
+#else
+        .num_stages = 1,
+        .stages = {
+            { .name = "ADC Filtering", .fn = adc_stage_filter_output, .ctx = &adc_output,
+              .core = ADC_PROC_CORE, .priority = 4, .stack = ADC_PROC_STACK },
+        },
+#endif
+    };
+    if (block_pipe_new(&pipe_cfg, &adc_pipe) != ESP_OK || block_pipe_start(adc_pipe) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start the block pipeline!");
+        return;
+    }
+
+    // --- Task for ADC Sampling, pinned: acquisition never competes with the stages ---
+    task_status = xTaskCreatePinnedToCore(adc_sampling, "ADC Sampling", ADC_ACQ_STACK, NULL, 5, NULL, ADC_ACQ_CORE);
+    if (task_status == pdPASS) {
+        ESP_LOGI(TAG, "ADC tasks created (acquisition on core %d, processing on core %d).",
+                 ADC_ACQ_CORE, ADC_PROC_CORE);
+    } else {
+        ESP_LOGE(TAG, "Failed to create ADC task!");
+    }
+#else
     // --- Task for ADC Filtering ---
-    task_status = xTaskCreate(adc_filtering, "ADC Filtering", 2048, NULL, 4, NULL);
+    // Created first: the sampling task notifies it after every frame.
+    // (3 KB stacks leave room for the timing reports, 4 KB with spectral logs)
+    task_status = xTaskCreate(adc_filtering, "ADC Filtering", ADC_PROC_STACK, NULL, 4, &filter_task);
+    if (task_status != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create ADC filtering task!");
+        return;
+    }
+    // --- Task for ADC Sampling ---
+    task_status = xTaskCreate(adc_sampling, "ADC Sampling", ADC_ACQ_STACK, NULL, 5, NULL);
     if (task_status == pdPASS) {
         ESP_LOGI(TAG, "ADC task created successfully!");
     } else {
         ESP_LOGE(TAG, "Failed to create ADC task!");
     }
+#endif
 
+#if CONFIG_IDF_TARGET_LINUX
+    // --- Host run: report once the configured signal has been replayed ---
+    adc_host_bench_run(adc_src, adc_host_info);
+#endif
 }
 
 
@@ -0,0 +1,415 @@
+// =============================
+// Host Run Support (linux target)
+// =============================
+// Mock ADC source, nominal calibration and the benchmark report for running
+// the application on the host. See adc_host.h.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "pipe_timing.h"
+#include "adc_host.h"
+
+#define TAG "ADC_HOST"
+
+#define HOST_SINE_AMPLITUDE     1240    // Codes: ~1000 mV around mid-scale
+#define HOST_NOISE_AMPLITUDE    400
+#define HOST_STEP_AMPLITUDE     2000
+#define HOST_MID_SCALE          2048
+#define HOST_QUEUE_TICKS        4       // Frames the source buffers, in ticks of signal
+#define HOST_POLL_MS            10      // Benchmark: progress / heap sampling period
+
+
+typedef struct {
+    uint64_t cycles;
+    int64_t  ns;
+    uint64_t samples;
+} host_stage_t;
+
+typedef struct {
+    uint64_t skip;                      // Samples left before the filters have settled
+    uint64_t count;
+    double   sum;
+    double   sum_sq;
+    int16_t  min;
+    int16_t  max;
+} host_tap_t;
+
+static const char *const host_stage_names[ADC_STAGE_COUNT] = { "acquire", "filter", "analyze", "output" };
+
+static uint32_t host_speed = 1;
+static uint32_t host_seconds = CONFIG_ADC_HOST_SECONDS;
+static char host_signal_desc[96];
+static adc_source_config_t host_src_cfg;    // As given to adc_host_source_new()
+static adc_host_wave_t host_wave;
+static adc_host_replay_t host_replay;
+static host_stage_t host_stage[ADC_STAGE_COUNT];
+static host_tap_t host_tap[ADC_SOURCE_MAX_CHANNELS];
+static int64_t host_frame_us;               // Frame period on the wall clock
+static jitter_meter_t host_jitter;          // Owned by the sampling task
+static timing_hist_t host_latency;          // Owned by the task that measures latency
+static uint32_t host_wakeups;               // Owned by the ring pipeline filter task
+static uint32_t host_empty_wakeups;
+
+
+// =============================
+// Clock
+// =============================
+int64_t adc_host_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t host_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint32_t adc_host_speed(void)
+{
+    return host_speed;
+}
+
+// The source waits for frames here: blocking the task lets the others run
+// (a plain nanosleep() would stall the whole simulated scheduler)
+static void host_wait_us(int64_t us)
+{
+    const int64_t tick_us = portTICK_PERIOD_MS * 1000;
+    TickType_t ticks = (TickType_t)((us + tick_us - 1) / tick_us);
+    vTaskDelay(ticks ? ticks : 1);
+}
+
+// =============================
+// Source
+// =============================
+static uint32_t env_u32(const char *name, uint32_t def)
+{
+    const char *v = getenv(name);
+    return (v && *v) ? (uint32_t)strtoul(v, NULL, 10) : def;
+}
+
+// A capture in mV (tools/stream_reader.py --csv) replays the codes that this
+// run's calibration turns back into those mV. They were filtered once already
+// and go through the filter chain again.
+static esp_err_t host_replay_mv_to_codes(const adc_source_config_t *cfg)
+{
+    for (uint32_t k = 0; k < host_replay.num_columns; k++) {
+        // Column k feeds channel k; columns past the channel count are never read
+        int atten = cfg->num_channels ? cfg->channels[(k < cfg->num_channels) ? k : 0].atten : cfg->atten;
+        adc_cali_lut_t *lut = NULL;
+        esp_err_t ret = adc_host_cali_lut_new((adc_atten_t)atten, &lut);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "No calibration to map the capture's mV to codes! Error code: %d", ret);
+            return ret;
+        }
+        for (size_t i = 0; i < host_replay.num_scans; i++) {
+            uint16_t *v = &host_replay.codes[i * host_replay.num_columns + k];
+            *v = adc_cali_lut_mv_to_raw(lut, *v);
+        }
+        adc_cali_lut_del(lut);
+    }
+    host_replay.in_mv = false;
+    return ESP_OK;
+}
+
+// Wave from its name, or a capture file for anything else
+static esp_err_t host_signal_setup(const char *signal, const adc_source_config_t *cfg)
+{
+    host_wave = (adc_host_wave_t) {
+        .sample_rate_hz = cfg->sample_rate_hz,
+        .freq_hz = CONFIG_ADC_HOST_SIGNAL_HZ,
+        .offset = HOST_MID_SCALE,
+        .seed = 1,
+    };
+
+    if (strcmp(signal, "sine") == 0) {
+        host_wave.kind = ADC_HOST_WAVE_SINE;
+        host_wave.amplitude = HOST_SINE_AMPLITUDE;
+    } else if (strcmp(signal, "noise") == 0) {
+        host_wave.kind = ADC_HOST_WAVE_NOISE;
+        host_wave.amplitude = HOST_NOISE_AMPLITUDE;
+    } else if (strcmp(signal, "steps") == 0) {
+        host_wave.kind = ADC_HOST_WAVE_STEPS;
+        host_wave.amplitude = HOST_STEP_AMPLITUDE;
+    } else {
+        esp_err_t ret = adc_host_replay_load(&host_replay, signal, cfg);
+        if (ret == ESP_OK && host_replay.in_mv) {
+            ret = host_replay_mv_to_codes(cfg);
+        }
+        if (ret != ESP_OK) {
+            adc_host_replay_free(&host_replay);
+            return ret;
+        }
+        snprintf(host_signal_desc, sizeof(host_signal_desc), "replay %s (%u scans)",
+                 signal, (unsigned)host_replay.num_scans);
+        return ESP_OK;
+    }
+    snprintf(host_signal_desc, sizeof(host_signal_desc), "%s %d Hz", signal, CONFIG_ADC_HOST_SIGNAL_HZ);
+    return ESP_OK;
+}
+
+esp_err_t adc_host_source_new(const adc_source_config_t *cfg, adc_source_t **ret_src)
+{
+    // --- 1. Run parameters: menuconfig, overridden by the environment ---
+    host_speed = env_u32("ADC_HOST_SPEED", CONFIG_ADC_HOST_SPEED);
+    host_speed = host_speed ? host_speed : 1;
+    host_seconds = env_u32("ADC_HOST_SECONDS", CONFIG_ADC_HOST_SECONDS);
+
+    const char *signal = getenv("ADC_HOST_SIGNAL");
+    if (!signal || !*signal) {
+#if CONFIG_ADC_HOST_SIGNAL_REPLAY
+        signal = CONFIG_ADC_HOST_REPLAY_FILE;
+#elif CONFIG_ADC_HOST_SIGNAL_NOISE
+        signal = "noise";
+#elif CONFIG_ADC_HOST_SIGNAL_STEPS
+        signal = "steps";
+#else
+        signal = "sine";
+#endif
+    }
+    esp_err_t ret = host_signal_setup(signal, cfg);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // --- 2. Realtime source on the accelerated clock ---
+    // The source sleeps at least one tick, so frames arrive in bursts: it
+    // buffers HOST_QUEUE_TICKS ticks of signal before dropping any.
+    uint64_t per_tick = (uint64_t)cfg->sample_rate_hz * host_speed * portTICK_PERIOD_MS / 1000;
+    adc_host_source_config_t host_cfg = {
+        .scan_signal = host_replay.codes ? adc_host_replay_signal : adc_host_wave_signal,
+        .signal_ctx = host_replay.codes ? (void *)&host_replay : (void *)&host_wave,
+        .realtime = true,
+        .max_queued_frames = (uint32_t)(HOST_QUEUE_TICKS * per_tick / cfg->frame_samples) + HOST_QUEUE_TICKS,
+        .speed = host_speed,
+        .wait_us = host_wait_us,
+    };
+    ret = adc_source_new_host(cfg, &host_cfg, ret_src);
+    if (ret != ESP_OK) {
+        adc_host_replay_free(&host_replay);
+        return ret;
+    }
+
+    // --- 3. Output statistics skip the first half second of each channel ---
+    host_src_cfg = *cfg;
+    for (uint32_t c = 0; c < cfg->num_channels; c++) {
+        uint32_t div = cfg->channels[c].rate_div ? cfg->channels[c].rate_div : 1;
+        host_tap[c] = (host_tap_t) { .skip = cfg->sample_rate_hz / div / 2, .min = INT16_MAX, .max = INT16_MIN };
+    }
+
+    // --- 4. Schedule accounting: frames arrive once per tick at best, so the
+    //        bins are a fraction of the tick ---
+    const uint32_t tick_us = portTICK_PERIOD_MS * 1000;
+    host_frame_us = (int64_t)cfg->frame_samples * 1000000 / ((uint64_t)cfg->sample_rate_hz * host_speed);
+    jitter_meter_init(&host_jitter, host_frame_us, tick_us / 8);
+    timing_hist_init(&host_latency, 0, tick_us / 4);
+    ESP_LOGI(TAG, "Host signal: %s, x%lu, %lu s", host_signal_desc,
+             (unsigned long)host_speed, (unsigned long)host_seconds);
+    return ESP_OK;
+}
+
+// =============================
+// Calibration
+// =============================
+static const int host_full_scale_mv[] = { 950, 1250, 1750, 3300 };   // DB_0 .. DB_11
+
+static esp_err_t host_line(void *ctx, int raw, int *mv)
+{
+    int full_scale = (int)(intptr_t)ctx;
+    *mv = (raw * full_scale + 2047) / 4095;
+    return ESP_OK;
+}
+
+esp_err_t adc_host_cali_lut_new(adc_atten_t atten, adc_cali_lut_t **ret_lut)
+{
+    if (atten < ADC_ATTEN_DB_0 || atten > ADC_ATTEN_DB_11) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return adc_cali_lut_new(12, host_line, (void *)(intptr_t)host_full_scale_mv[atten], ret_lut);
+}
+
+// =============================
+// Stage Accounting and Output Tap
+// =============================
+adc_host_mark_t adc_host_mark(void)
+{
+    return (adc_host_mark_t) { .cycles = adc_host_cycles(), .ns = host_now_ns() };
+}
+
+void adc_host_stage_add(adc_stage_t stage, const adc_host_mark_t *start, size_t n)
+{
+    host_stage_t *st = &host_stage[stage];
+    st->cycles += adc_host_cycles() - start->cycles;
+    st->ns += host_now_ns() - start->ns;
+    st->samples += n;
+}
+
+void adc_host_tap(int c, const int16_t *x, size_t n)
+{
+    host_tap_t *t = &host_tap[c];
+    for (size_t i = 0; i < n; i++) {
+        if (t->skip > 0) {
+            t->skip--;
+            continue;
+        }
+        t->count++;
+        t->sum += x[i];
+        t->sum_sq += (double)x[i] * x[i];
+        t->min = (x[i] < t->min) ? x[i] : t->min;
+        t->max = (x[i] > t->max) ? x[i] : t->max;
+    }
+}
+
+// =============================
+// Schedule Accounting
+// =============================
+void adc_host_frame(void)
+{
+    jitter_meter_add(&host_jitter, adc_host_now_us());
+}
+
+void adc_host_latency(int64_t us)
+{
+    timing_hist_add(&host_latency, us);
+}
+
+void adc_host_wakeup(size_t n)
+{
+    host_wakeups++;
+    host_empty_wakeups += (n == 0);
+}
+
+// =============================
+// Benchmark Run
+// =============================
+static size_t host_heap_in_use(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+#else
+    return 0;       // Not available: reported as 0
+#endif
+}
+
+static void host_report(adc_source_t *src, adc_host_info_fn_t get_info, size_t heap_peak)
+{
+    adc_source_stats_t stats;
+    adc_source_get_stats(src, &stats);
+    adc_host_pipe_info_t info = { 0 };
+    if (get_info) {
+        get_info(&info);
+    }
+
+    // --- 1. Throughput against what the source offered ---
+    double offered = 0;
+    for (uint32_t c = 0; c < host_src_cfg.num_channels; c++) {
+        uint32_t div = host_src_cfg.channels[c].rate_div ? host_src_cfg.channels[c].rate_div : 1;
+        offered += (double)host_src_cfg.sample_rate_hz / div * host_speed;
+    }
+    double secs = stats.elapsed_us / 1e6;
+    printf("[bench] signal: %s, %lu channel(s) at %lu Hz, x%lu, %lu s\n", host_signal_desc,
+           (unsigned long)host_src_cfg.num_channels, (unsigned long)host_src_cfg.sample_rate_hz,
+           (unsigned long)host_speed, (unsigned long)host_seconds);
+    printf("[bench] throughput: %llu samples (%llu frames) in %.2f s, %.0f samples/s (offered %.0f), "
+           "%lu dropped frames, %lu ring overruns, %lu starved blocks, %lu stream drops\n",
+           (unsigned long long)stats.samples, (unsigned long long)stats.frames, secs, secs > 0 ? stats.samples / secs : 0.0, offered,
+           (unsigned long)stats.dropped_frames, (unsigned long)info.ring_overruns,
+           (unsigned long)info.starved_blocks, (unsigned long)info.stream_dropped);
+
+    // --- 2. Cost per sample of every stage that ran ---
+    double total_ns = 0;
+    for (int s = 0; s < ADC_STAGE_COUNT; s++) {
+        const host_stage_t *st = &host_stage[s];
+        if (st->samples == 0) {
+            continue;
+        }
+        double ns = (double)st->ns / st->samples;
+        total_ns += ns;
+        printf("[bench] stage %s: %.1f cycles/sample (%.1f ns)\n", host_stage_names[s],
+               (double)st->cycles / st->samples, ns);
+    }
+    if (total_ns > 0) {
+        printf("[bench] capacity: ~%.0f samples/s on one core\n", 1e9 / total_ns);
+    }
+
+    // --- 3. Schedule of the real tasks: frame arrival, latency, idle wake-ups ---
+    char line[96];
+    printf("[bench] schedule: %s, frame %lld us, wake-up every %lld us, tick %lu us\n",
+           info.schedule ? info.schedule : "?", (long long)host_frame_us, (long long)info.wake_us,
+           (unsigned long)(portTICK_PERIOD_MS * 1000));
+    printf("[bench] frame jitter: %s\n", timing_hist_summary(&host_jitter.hist, line, sizeof(line)));
+    printf("[bench] latency: %s\n", timing_hist_summary(&host_latency, line, sizeof(line)));
+    if (host_wakeups > 0) {
+        printf("[bench] wake-ups: %lu, %lu without data, %lu ring underruns\n",
+               (unsigned long)host_wakeups, (unsigned long)host_empty_wakeups,
+               (unsigned long)info.ring_underruns);
+    }
+
+    // --- 4. Memory ---
+    printf("[bench] heap: peak %lu bytes in use\n", (unsigned long)heap_peak);
+    for (uint32_t i = 0; i < info.num_tasks; i++) {
+        TaskHandle_t task = xTaskGetHandle(info.tasks[i].name);
+        if (!task) {
+            continue;
+        }
+        uint32_t unused = uxTaskGetStackHighWaterMark(task) * sizeof(StackType_t);
+        printf("[bench] stack %s: %lu of %lu bytes used (device budget %lu)\n", info.tasks[i].name,
+               (unsigned long)(info.tasks[i].stack - unused), (unsigned long)info.tasks[i].stack,
+               (unsigned long)(info.tasks[i].stack - ADC_HOST_STACK_EXTRA));
+    }
+
+    // --- 5. What came out of the filters ---
+    for (uint32_t c = 0; c < host_src_cfg.num_channels; c++) {
+        const host_tap_t *t = &host_tap[c];
+        if (t->count == 0) {
+            printf("[bench] output ch %d: no samples\n", host_src_cfg.channels[c].channel);
+            continue;
+        }
+        double mean = t->sum / t->count;
+        double var = t->sum_sq / t->count - mean * mean;
+        printf("[bench] output ch %d: mean %.1f, rms %.1f, min %d, max %d mV (%llu samples)\n",
+               host_src_cfg.channels[c].channel, mean, var > 0 ? sqrt(var) : 0.0, t->min, t->max,
+               (unsigned long long)t->count);
+    }
+    printf("[bench] done\n");
+}
+
+void adc_host_bench_run(adc_source_t *src, adc_host_info_fn_t get_info)
+{
+    if (host_seconds == 0) {
+        return;
+    }
+
+    // --- 1. Let the pipeline consume the signal, watching the heap ---
+    // Gives up after twice the expected wall time (plus 5 s): a pipeline
+    // that cannot keep up still gets its report.
+    const uint64_t frames = (uint64_t)host_seconds * host_src_cfg.sample_rate_hz / host_src_cfg.frame_samples;
+    const int64_t deadline = adc_host_now_us() + (int64_t)host_seconds * 2000000 / host_speed + 5000000;
+    size_t heap_peak = host_heap_in_use();
+    adc_source_stats_t stats;
+    do {
+        vTaskDelay(pdMS_TO_TICKS(HOST_POLL_MS) ? pdMS_TO_TICKS(HOST_POLL_MS) : 1);
+        size_t heap = host_heap_in_use();
+        heap_peak = (heap > heap_peak) ? heap : heap_peak;
+        adc_source_get_stats(src, &stats);
+    } while (stats.frames + stats.dropped_frames < frames && adc_host_now_us() < deadline);
+
+    // --- 2. Report and leave (the tasks never return) ---
+    host_report(src, get_info, heap_peak);
+    fflush(stdout);
+    exit(0);
+}
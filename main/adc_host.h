@@ -0,0 +1,185 @@
+// =============================
+// Host Run Support (linux target)
+// =============================
+// Lets main/ADC.c run unchanged on the ESP-IDF `linux` target:
+//
+//   idf.py --preview set-target linux
+//   idf.py build monitor
+//
+// The ADC is replaced by the host source (components/adc_source) playing a
+// synthetic wave or a recorded capture, sped up by ADC_HOST_SPEED, through
+// the same calibration table, rings / blocks, filters and output. After
+// ADC_HOST_SECONDS of signal the app prints a benchmark report and exits:
+//
+//   [bench] throughput: ... samples/s (offered ...), ... dropped frames, ...
+//   [bench] stage filter: ... cycles/sample (... ns)
+//   [bench] schedule: polled, frame ... us, wake-up every ... us, tick ... us
+//   [bench] frame jitter: n=... mean ... p50 ... p99 ... max ... us
+//   [bench] latency: n=... mean ... p50 ... p99 ... max ... us
+//   [bench] wake-ups: ..., ... without data, ... ring underruns
+//   [bench] heap: peak ... bytes in use
+//   [bench] stack ADC Sampling: ... of ... bytes used (device budget ...)
+//   [bench] output ch 6: mean ..., rms ..., min ..., max ... mV
+//   [bench] done
+//
+// Environment overrides (no rebuild): ADC_HOST_SIGNAL = sine | noise | steps
+// | <capture file>, ADC_HOST_SPEED, ADC_HOST_SECONDS.
+//
+// On the chip this header only provides the no-op stage and tap macros.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+
+#include "esp_err.h"
+#include "adc_source.h"
+#include "adc_cali_lut.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================
+// ADC HAL Stand-Ins
+// =============================
+// hal/adc_types.h is not available on the host; same values as on the chip
+typedef int adc_atten_t;
+enum { ADC_UNIT_1 = 0 };
+enum { ADC_ATTEN_DB_0 = 0, ADC_ATTEN_DB_2_5 = 1, ADC_ATTEN_DB_6 = 2, ADC_ATTEN_DB_11 = 3 };
+enum {
+    ADC_CHANNEL_0, ADC_CHANNEL_1, ADC_CHANNEL_2, ADC_CHANNEL_3,
+    ADC_CHANNEL_4, ADC_CHANNEL_5, ADC_CHANNEL_6, ADC_CHANNEL_7,
+};
+
+// Task stacks also hold glibc's printf and the pthread (at least PTHREAD_STACK_MIN)
+#define ADC_HOST_STACK_EXTRA    16384
+
+// =============================
+// Clock
+// =============================
+int64_t adc_host_now_us(void);
+
+// CPU cycles where the host exposes a counter, nanoseconds otherwise
+static inline uint64_t adc_host_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    return (uint64_t)adc_host_now_us() * 1000;
+#endif
+}
+
+// Signal clock / wall clock. Frame timestamps from the host source are wall
+// time, so periods derived from the sample rate are divided by this.
+uint32_t adc_host_speed(void);
+
+// =============================
+// Source and Calibration
+// =============================
+// Host source for cfg, playing the configured signal (see top of file)
+esp_err_t adc_host_source_new(const adc_source_config_t *cfg, adc_source_t **ret_src);
+
+// Nominal straight-line calibration for the attenuation (no eFuse values on
+// the host): 0 .. full scale mV over the 12-bit codes, 3300 mV at 11 dB.
+esp_err_t adc_host_cali_lut_new(adc_atten_t atten, adc_cali_lut_t **ret_lut);
+
+// =============================
+// Stage Accounting
+// =============================
+// Wrap a stage's work for n samples:
+//   ADC_STAGE_BEGIN(t);  filter_chain_process(...);  ADC_STAGE_END(t, ADC_STAGE_FILTER, n);
+// Each stage must only be timed from one task.
+typedef enum {
+    ADC_STAGE_ACQUIRE,      // Raw -> mV conversion and hand-off
+    ADC_STAGE_FILTER,
+    ADC_STAGE_ANALYZE,      // Spectral analysis
+    ADC_STAGE_OUTPUT,       // Log lines / stream submission
+    ADC_STAGE_COUNT,
+} adc_stage_t;
+
+typedef struct {
+    uint64_t cycles;
+    int64_t  ns;            // A block takes a few microseconds: us would round away most of it
+} adc_host_mark_t;
+
+adc_host_mark_t adc_host_mark(void);
+
+void adc_host_stage_add(adc_stage_t stage, const adc_host_mark_t *start, size_t n);
+
+// Output statistics of channel slot c (filtered mV), after the filters settle
+void adc_host_tap(int c, const int16_t *x, size_t n);
+
+#define ADC_STAGE_BEGIN(t)          adc_host_mark_t t = adc_host_mark()
+#define ADC_STAGE_END(t, stage, n)  adc_host_stage_add((stage), &(t), (n))
+#define ADC_HOST_TAP(c, x, n)       adc_host_tap((c), (x), (n))
+
+// =============================
+// Schedule Accounting
+// =============================
+// Whole-run timing of the application's own tasks (its histograms restart
+// every second), all on the wall clock:
+//   ADC_HOST_FRAME()        sampling task, as soon as a frame has been read:
+//                           arrival interval vs. the accelerated frame period
+//   ADC_HOST_LATENCY(us)    newest scan converted -> filtered and output
+//   ADC_HOST_WAKEUP(n)      ring pipeline filter task, once per wake-up, with
+//                           the samples it found
+void adc_host_frame(void);
+void adc_host_latency(int64_t us);
+void adc_host_wakeup(size_t n);
+
+#define ADC_HOST_FRAME()            adc_host_frame()
+#define ADC_HOST_LATENCY(us)        adc_host_latency(us)
+#define ADC_HOST_WAKEUP(n)          adc_host_wakeup(n)
+
+// =============================
+// Benchmark Run
+// =============================
+// Counters only the application knows, collected once at the end
+#define ADC_HOST_MAX_TASKS      6
+
+typedef struct {
+    const char *name;       // FreeRTOS task name
+    uint32_t    stack;      // Stack size given to xTaskCreate (bytes)
+} adc_host_task_t;
+
+typedef struct {
+    const char *schedule;       // How the filter stage wakes up: "polled", "event", "blocks"
+    int64_t  wake_us;           // Polled: wake-up period (wall clock); 0 otherwise
+    uint32_t ring_overruns;     // Samples lost between sampling and filtering
+    uint32_t ring_underruns;    // Filter wake-ups for a frame that found a ring empty
+    uint32_t starved_blocks;    // Frames without a free block
+    uint32_t stream_dropped;    // Blocks the transmit queue refused
+    uint32_t num_tasks;
+    adc_host_task_t tasks[ADC_HOST_MAX_TASKS];
+} adc_host_pipe_info_t;
+
+typedef void (*adc_host_info_fn_t)(adc_host_pipe_info_t *info);
+
+// Blocks the calling task until ADC_HOST_SECONDS of signal have been read
+// from src, prints the [bench] report and exits the process.
+// ADC_HOST_SECONDS = 0: returns at once, the app keeps running.
+void adc_host_bench_run(adc_source_t *src, adc_host_info_fn_t get_info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#else   // !CONFIG_IDF_TARGET_LINUX
+
+#define ADC_HOST_STACK_EXTRA        0
+#define ADC_STAGE_BEGIN(t)
+#define ADC_STAGE_END(t, stage, n)
+#define ADC_HOST_TAP(c, x, n)
+#define ADC_HOST_FRAME()
+#define ADC_HOST_LATENCY(us)
+#define ADC_HOST_WAKEUP(n)
+
+#endif
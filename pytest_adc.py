@@ -0,0 +1,130 @@
+# SPDX-License-Identifier: CC0-1.0
+# Runs the application on a board, and on the ESP-IDF `linux` target where the
+# host stand-in replays a test signal through the whole pipeline and prints a
+# [bench] report (see main/adc_host.h).
+import logging
+import math
+import re
+import time
+
+import pexpect
+import pytest
+from pytest_embedded_idf.dut import IdfDut
+from pytest_embedded_idf.utils import idf_parametrize
+
+# Default host run: 10 Hz sine, 1240 codes around mid-scale -> 1650 +- 999 mV
+SINE_MEAN_MV = 1650.0
+SINE_AMPLITUDE_MV = 1240 * 3300 / 4095
+HEAP_LIMIT_BYTES = 2 * 1024 * 1024
+LOSS_LIMIT = 0.01
+EMPTY_WAKEUP_LIMIT = 0.05
+STACK_HEADROOM_BYTES = 256
+STACK_WATCH_S = 5
+HIST = r'n=(\d+) mean (-?\d+) p50 (-?\d+) p99 (-?\d+) max (-?\d+) us'
+
+
+def collect_report(dut: IdfDut) -> dict:
+    dut.expect_exact('[bench] done', timeout=120)
+    log = dut.pexpect_proc.before.decode('utf-8', errors='replace')
+    lines = [line[line.index('[bench]'):] for line in log.splitlines() if '[bench]' in line]
+    for line in lines:
+        logging.info(line)
+
+    report: dict = {'stages': {}, 'stacks': {}, 'outputs': {}}
+    for line in lines:
+        if m := re.match(r'\[bench\] throughput: (\d+) samples \((\d+) frames\) in [\d.]+ s, (\d+) samples/s '
+                         r'\(offered (\d+)\), (\d+) dropped frames, (\d+) ring overruns, (\d+) starved blocks, '
+                         r'(\d+) stream drops', line):
+            report.update(samples=int(m[1]), frames=int(m[2]), rate=int(m[3]), offered=int(m[4]),
+                          dropped=int(m[5]), overruns=int(m[6]), starved=int(m[7]), stream_drops=int(m[8]))
+        elif m := re.match(r'\[bench\] stage (\w+): ([\d.]+) cycles/sample \(([\d.]+) ns\)', line):
+            report['stages'][m[1]] = float(m[3])
+        elif m := re.match(r'\[bench\] capacity: ~(\d+) samples/s', line):
+            report['capacity'] = int(m[1])
+        elif m := re.match(r'\[bench\] schedule: (\w+), frame (\d+) us, wake-up every (\d+) us, tick (\d+) us', line):
+            report.update(schedule=m[1], frame_us=int(m[2]), wake_us=int(m[3]), tick_us=int(m[4]))
+        elif m := re.match(r'\[bench\] frame jitter: ' + HIST, line):
+            report['jitter'] = dict(n=int(m[1]), mean=int(m[2]), p99=int(m[4]), max=int(m[5]))
+        elif m := re.match(r'\[bench\] latency: ' + HIST, line):
+            report['latency'] = dict(n=int(m[1]), mean=int(m[2]), p99=int(m[4]), max=int(m[5]))
+        elif m := re.match(r'\[bench\] wake-ups: (\d+), (\d+) without data', line):
+            report.update(wakeups=int(m[1]), empty_wakeups=int(m[2]))
+        elif m := re.match(r'\[bench\] heap: peak (\d+) bytes', line):
+            report['heap_peak'] = int(m[1])
+        elif m := re.match(r'\[bench\] stack (.+): (\d+) of (\d+) bytes used \(device budget (\d+)\)', line):
+            report['stacks'][m[1]] = (int(m[2]), int(m[3]), int(m[4]))
+        elif m := re.match(r'\[bench\] output ch (\d+): mean ([-\d.]+), rms ([\d.]+), min (-?\d+), max (-?\d+) mV', line):
+            report['outputs'][int(m[1])] = (float(m[2]), float(m[3]), int(m[4]), int(m[5]))
+    return report
+
+
+@pytest.mark.generic
+@idf_parametrize('target', ['esp32'], indirect=['target'])
+def test_adc_acquisition(dut: IdfDut) -> None:
+    dut.expect_exact('ADC is now initialized and ready for sampling.')
+    rate = int(dut.expect(r'Acquisition: (\d+) samples/s', timeout=10).group(1))
+    assert rate > 0
+
+    # --- Stacks: the high-water marks the chip reports while sampling ---
+    # (each task is logged once, then again whenever its free stack shrinks)
+    free: dict = {}
+    deadline = time.monotonic() + STACK_WATCH_S
+    while (left := deadline - time.monotonic()) > 0:
+        try:
+            m = dut.expect(r'Stack ([^:\r\n]+): (\d+) of (\d+) bytes free', timeout=left)
+        except pexpect.TIMEOUT:
+            break
+        free[m.group(1).decode()] = (int(m.group(2)), int(m.group(3)))
+    assert free, 'no task stacks reported'
+    for name, (unused, size) in free.items():
+        logging.info('stack %s: %d of %d bytes free', name, unused, size)
+        assert unused >= STACK_HEADROOM_BYTES, f'stack of {name}: {unused} of {size} bytes free'
+
+
+@pytest.mark.host_test
+@idf_parametrize('target', ['linux'], indirect=['target'])
+def test_adc_pipeline_host(dut: IdfDut) -> None:
+    report = collect_report(dut)
+
+    # --- Throughput: the accelerated signal gets through ---
+    # (a shared CI host can stall a task now and then: allow 1% losses)
+    assert report['rate'] >= 0.95 * report['offered'], 'pipeline fell behind the replayed signal'
+    assert report['dropped'] <= LOSS_LIMIT * report['frames']
+    assert report['overruns'] <= LOSS_LIMIT * report['samples']
+    assert report['starved'] <= LOSS_LIMIT * report['frames']
+    assert report['stream_drops'] <= LOSS_LIMIT * report['frames']
+    # Per-sample cost leaves headroom well beyond the replay speed
+    assert {'acquire', 'filter'} <= report['stages'].keys()
+    assert report['capacity'] >= 2 * report['offered']
+
+    # --- Schedule of the real tasks (wall clock, the host source wakes once per tick) ---
+    # Frames come in at the offered rate, at most a tick late (plus a tick of CI slack)
+    tick, frame = report['tick_us'], report['frame_us']
+    jitter = report['jitter']
+    assert jitter['n'] >= (1 - LOSS_LIMIT) * report['frames'] - 1
+    assert abs(jitter['mean']) <= frame // 10 + 1, f'frames every {frame + jitter["mean"]} us, not {frame} us'
+    assert jitter['p99'] <= 2 * tick, f'frame arrival p99 {jitter["p99"]} us late'
+    # A sample is filtered within a wake-up period (event: its own frame) plus those ticks
+    latency = report['latency']
+    assert latency['n'] > 0, 'no latency measured'
+    assert latency['p99'] <= report['wake_us'] + frame + 2 * tick, f'latency p99 {latency["p99"]} us'
+    # Ring pipeline: the filter task only wakes up for data (polled: when a
+    # period always spans a frame)
+    if 'wakeups' in report and (report['schedule'] == 'event' or report['wake_us'] >= frame + tick):
+        assert report['empty_wakeups'] <= EMPTY_WAKEUP_LIMIT * report['wakeups'], 'filter task woke up without data'
+
+    # --- Memory ---
+    assert 0 < report['heap_peak'] < HEAP_LIMIT_BYTES
+    assert report['stacks'], 'no task stacks reported'
+    # Host stacks carry ADC_HOST_STACK_EXTRA for glibc and the pthread, and
+    # glibc's printf does not use what newlib's does: the figures say nothing
+    # about the chip (test_adc_acquisition checks the stacks there)
+    for name, (used, size, budget) in report['stacks'].items():
+        assert used < size, f'stack of {name} exhausted'
+
+    # --- Filters: a 10 Hz sine passes the moving average and the mains notch ---
+    assert report['outputs']
+    for ch, (mean, rms, lo, hi) in report['outputs'].items():
+        assert abs(mean - SINE_MEAN_MV) < 15, f'ch {ch}: mean {mean} mV'
+        assert abs(rms - SINE_AMPLITUDE_MV / math.sqrt(2)) < 15, f'ch {ch}: rms {rms} mV'
+        assert abs((hi - lo) / 2 - SINE_AMPLITUDE_MV) < 30, f'ch {ch}: swing {lo}..{hi} mV'
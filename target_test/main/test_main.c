@@ -0,0 +1,14 @@
+// =============================
+// Target Test Runner
+// =============================
+// Runs every TEST_CASE linked into this application once. Cases tagged
+// [bench] print throughput figures that pytest_target_test.py picks up.
+
+#include "unity.h"
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    unity_run_all_tests();
+    UNITY_END();                // Returning ends the main task; nothing reboots
+}
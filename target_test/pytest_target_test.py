@@ -0,0 +1,33 @@
+# SPDX-License-Identifier: CC0-1.0
+# Runs the target test application on a board. The block pipeline benchmark
+# measures the stages on core 1 against all tasks on core 0 here, which the
+# single-core linux target cannot, and the spectral cases run the esp-dsp FFT
+# next to the portable one.
+import logging
+import re
+
+import pytest
+from pytest_embedded_idf.dut import IdfDut
+from pytest_embedded_idf.utils import idf_parametrize
+
+
+def collect_bench(dut: IdfDut) -> str:
+    # Unity prints the summary after the last test; [bench] lines come before it
+    out = dut.expect(r'(\d+) Tests (\d+) Failures (\d+) Ignored', timeout=300)
+    assert out.group(2) == b'0', 'unit test failures'
+    # The esp-dsp comparison ignores itself when the build lacks esp-dsp
+    assert out.group(3) == b'0', 'ignored tests: is esp-dsp in the build?'
+    return dut.pexpect_proc.before.decode('utf-8', errors='replace')
+
+
+@pytest.mark.generic
+@idf_parametrize('target', ['esp32'], indirect=['target'])
+def test_target_units(dut: IdfDut) -> None:
+    log = collect_bench(dut)
+    for line in log.splitlines():
+        if line.startswith('[bench]'):
+            logging.info(line)
+    # Both placements ran on real cores and the ratio is a measurement
+    m = re.search(r'\[bench\] block_pipe two cores / one core: x([\d.]+) measured', log)
+    assert m, 'no two-core pipeline run'
+    assert float(m[1]) > 1.0, 'stages on core 1 were not faster than on core 0'
@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: CC0-1.0
+# Decodes the binary sample stream (components/stream_proto) on a PC.
+#
+#   python tools/stream_reader.py /dev/ttyUSB0 --baud 921600
+#   python tools/stream_reader.py capture.bin --csv samples.csv
+#   cat capture.bin | python tools/stream_reader.py -
+#
+# Frame layout and encodings are described in stream_proto.h. Feature frames
+# (on-device analysis results) are printed, or written with --features-csv.
+import argparse
+import struct
+import sys
+import time
+from typing import BinaryIO, Callable, Iterator, List, Optional, Tuple
+
+FRAME_SAMPLES = 0x01
+FRAME_FEATURES = 0x02
+HEADER = struct.Struct('<BBBHII')     # type, encoding, channel, count, seq, timestamp_us
+CRC_SIZE = 2
+MAX_SAMPLES = 512
+MAX_FEATURES = 64
+MAX_FRAME = HEADER.size + 2 * MAX_SAMPLES + CRC_SIZE
+MAX_WIRE = MAX_FRAME + MAX_FRAME // 254 + 1
+
+ENC_RAW16 = 0
+ENC_DELTA8 = 1
+ENC_PACKED12 = 2
+ENC_FLOAT32 = 3
+ENC_NAMES = {ENC_RAW16: 'raw16', ENC_DELTA8: 'delta8', ENC_PACKED12: 'packed12', ENC_FLOAT32: 'float32'}
+DELTA8_ESCAPE = 0x80
+
+
+class FrameError(ValueError):
+    pass
+
+
+class Frame:
+    def __init__(self, encoding: int, channel: int, seq: int, timestamp_us: int, samples: List[int],
+                 values: Optional[List[float]] = None) -> None:
+        self.type = FRAME_SAMPLES if values is None else FRAME_FEATURES
+        self.encoding = encoding
+        self.channel = channel
+        self.seq = seq
+        self.timestamp_us = timestamp_us
+        self.samples = samples
+        self.values = values if values is not None else []
+
+
+def crc16(data: bytes) -> int:
+    """CRC-16/CCITT-FALSE, as stream_crc16()."""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_decode(data: bytes) -> bytes:
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            raise FrameError('bad COBS block')
+        block = data[i:i + code - 1]
+        if 0 in block:
+            raise FrameError('zero inside COBS block')
+        out += block
+        i += code - 1
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def decode_payload(encoding: int, p: bytes, n: int) -> List[int]:
+    if encoding == ENC_RAW16:
+        if len(p) != 2 * n:
+            raise FrameError('raw16 size')
+        return list(struct.unpack('<%dh' % n, p))
+
+    if encoding == ENC_PACKED12:
+        if len(p) != 3 * (n // 2) + 2 * (n & 1):
+            raise FrameError('packed12 size')
+        s = []
+        for i in range(0, 3 * (n // 2), 3):
+            s.append(p[i] | ((p[i + 1] & 0x0F) << 8))
+            s.append((p[i + 1] >> 4) | (p[i + 2] << 4))
+        if n & 1:
+            s.append(p[-2] | ((p[-1] & 0x0F) << 8))
+        return s
+
+    if encoding == ENC_DELTA8:
+        if n == 0:
+            if p:
+                raise FrameError('delta8 size')
+            return []
+        if len(p) < 2:
+            raise FrameError('delta8 size')
+        s = [struct.unpack_from('<h', p, 0)[0]]
+        i = 2
+        while len(s) < n:
+            if i >= len(p):
+                raise FrameError('delta8 truncated')
+            if p[i] == DELTA8_ESCAPE:
+                if i + 3 > len(p):
+                    raise FrameError('delta8 truncated')
+                s.append(struct.unpack_from('<h', p, i + 1)[0])
+                i += 3
+            else:
+                d = p[i] - 256 if p[i] > 127 else p[i]
+                s.append(((s[-1] + d + 0x8000) & 0xFFFF) - 0x8000)
+                i += 1
+        if i != len(p):
+            raise FrameError('delta8 size')
+        return s
+
+    raise FrameError('unknown encoding %d' % encoding)
+
+
+def decode_frame(cobs: bytes) -> Frame:
+    """Decodes one frame with the 0x00 delimiters already stripped."""
+    raw = cobs_decode(cobs)
+    if len(raw) < HEADER.size + CRC_SIZE:
+        raise FrameError('short frame')
+    body = raw[:-CRC_SIZE]
+    if crc16(body) != struct.unpack_from('<H', raw, len(body))[0]:
+        raise FrameError('CRC mismatch')
+    ftype, enc, chan, count, seq, ts = HEADER.unpack_from(body)
+    payload = body[HEADER.size:]
+    if ftype == FRAME_FEATURES:
+        if enc != ENC_FLOAT32 or count > MAX_FEATURES or len(payload) != 4 * count:
+            raise FrameError('bad feature frame')
+        return Frame(enc, chan, seq, ts, [], list(struct.unpack('<%df' % count, payload)))
+    if ftype != FRAME_SAMPLES or count > MAX_SAMPLES:
+        raise FrameError('bad header')
+    return Frame(enc, chan, seq, ts, decode_payload(enc, payload, count))
+
+
+class StreamDecoder:
+    """Byte-stream decoder with the same statistics as stream_decoder_t."""
+
+    def __init__(self, on_frame: Optional[Callable[[Frame], None]] = None) -> None:
+        self.on_frame = on_frame
+        self.buf = bytearray()
+        self.overflow = False
+        self.frames = 0
+        self.feature_frames = 0
+        self.bad_frames = 0
+        self.lost_frames = 0
+        self.resyncs = 0
+        self.next_seq = 0
+        self.bytes = 0
+        self.samples = 0
+
+    def feed(self, data: bytes) -> None:
+        self.bytes += len(data)
+        parts = data.split(b'\x00')
+        for k, part in enumerate(parts):
+            if not self.overflow:
+                self.buf += part
+                if len(self.buf) > MAX_WIRE:
+                    # Too long to be a frame: discard until the next delimiter
+                    self.bad_frames += 1
+                    self.overflow = True
+                    self.buf.clear()
+            if k < len(parts) - 1:
+                self._frame_end()
+
+    def _frame_end(self) -> None:
+        buf, overflow = bytes(self.buf), self.overflow
+        self.buf.clear()
+        self.overflow = False
+        if not buf or overflow:
+            return
+        try:
+            frame = decode_frame(buf)
+        except FrameError:
+            self.bad_frames += 1
+            return
+        if self.frames > 0 and frame.seq != self.next_seq:
+            gap = (frame.seq - self.next_seq) & 0xFFFFFFFF
+            if gap & 0x80000000:
+                self.resyncs += 1       # Sequence went backwards: the device restarted
+            else:
+                self.lost_frames += gap
+        self.next_seq = (frame.seq + 1) & 0xFFFFFFFF
+        self.frames += 1
+        self.feature_frames += frame.type == FRAME_FEATURES
+        self.samples += len(frame.samples)
+        if self.on_frame:
+            self.on_frame(frame)
+
+
+def open_input(name: str, baud: int) -> Tuple[BinaryIO, bool]:
+    """Returns (stream, is_serial)."""
+    if name == '-':
+        return sys.stdin.buffer, False
+    if name.startswith(('/dev/', 'COM')):
+        try:
+            import serial  # pyserial
+        except ImportError:
+            sys.exit('pyserial is needed for serial ports: pip install pyserial')
+        return serial.Serial(name, baud, timeout=0.1), True
+    return open(name, 'rb'), False
+
+
+def chunks(stream: BinaryIO, is_serial: bool) -> Iterator[bytes]:
+    while True:
+        data = stream.read(4096) if not is_serial else stream.read(max(1, stream.in_waiting))
+        if not data:
+            if is_serial:
+                continue
+            return
+        yield data
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description='Decode the ESP32 ADC binary sample stream')
+    parser.add_argument('input', help='serial port, capture file, or - for stdin')
+    parser.add_argument('--baud', type=int, default=115200, help='serial baud rate')
+    parser.add_argument('--csv', help='write "channel,seq,timestamp_us,index,value" rows here')
+    parser.add_argument('--features-csv', help='write "channel,seq,timestamp_us,values..." rows here')
+    parser.add_argument('--quiet', action='store_true', help='only print the final statistics')
+    args = parser.parse_args()
+
+    csv = open(args.csv, 'w') if args.csv else None
+    if csv:
+        csv.write('channel,seq,timestamp_us,index,value\n')
+    fcsv = open(args.features_csv, 'w') if args.features_csv else None
+
+    def on_frame(f: Frame) -> None:
+        if f.type == FRAME_FEATURES:
+            if fcsv:
+                fcsv.write('%d,%d,%d,%s\n' % (f.channel, f.seq, f.timestamp_us, ','.join('%g' % v for v in f.values)))
+            if not args.quiet:
+                print('ch %d  seq %d  t %d us: %s' % (f.channel, f.seq, f.timestamp_us,
+                                                      ' '.join('%.4g' % v for v in f.values)))
+        elif csv:
+            csv.writelines('%d,%d,%d,%d,%d\n' % (f.channel, f.seq, f.timestamp_us, i, v)
+                           for i, v in enumerate(f.samples))
+
+    dec = StreamDecoder(on_frame)
+    stream, is_serial = open_input(args.input, args.baud)
+    t0 = last = time.monotonic()
+
+    def report() -> None:
+        dt = max(time.monotonic() - t0, 1e-9)
+        print('frames %d (features %d)  bad %d  lost %d  resyncs %d  samples %d (%.0f/s)  %.2f bytes/sample' % (
+            dec.frames, dec.feature_frames, dec.bad_frames, dec.lost_frames, dec.resyncs, dec.samples, dec.samples / dt,
+            dec.bytes / dec.samples if dec.samples else 0.0))
+
+    try:
+        for data in chunks(stream, is_serial):
+            dec.feed(data)
+            if not args.quiet and time.monotonic() - last >= 1.0:
+                report()
+                last = time.monotonic()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        report()
+        if csv:
+            csv.close()
+        if fcsv:
+            fcsv.close()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,75 @@
+# SPDX-License-Identifier: CC0-1.0
+# Checks tools/stream_reader.py against frames produced by the C encoder.
+#   pytest tools/test_stream_reader.py
+from stream_reader import ENC_DELTA8
+from stream_reader import ENC_FLOAT32
+from stream_reader import FRAME_FEATURES
+from stream_reader import ENC_PACKED12
+from stream_reader import ENC_RAW16
+from stream_reader import StreamDecoder
+from stream_reader import crc16
+
+SAMPLES = [1600, 1603, 1590, 1750, 4095]
+
+# stream_proto_encode() output for SAMPLES, channel 6, seq 41/42/43,
+# timestamps 250000/250250/250500, encodings RAW16/DELTA8/PACKED12
+GOLDEN = [
+    bytes.fromhex('000201030605022901010490d0030d400643063606d606ff0fd71200'),
+    bytes.fromhex('000501010605022a0101048ad1030d400603f380d60680ff0ff92100'),
+    bytes.fromhex('000501020605022b01010484d2030b40366436666dff0f833f00'),
+]
+
+# stream_proto_encode_features() output for FEATURES, channel 1, seq 44, timestamp 250750
+FEATURES = [1650.5, 141.25, 10.25, 20000.0]
+GOLDEN_FEATURES = bytes.fromhex('000502030104022c0101047ed303010450ce4404400d430103244106409c46e4ef00')
+
+
+def collect(data: bytes, chunk: int = 7) -> tuple:
+    frames = []
+    dec = StreamDecoder(frames.append)
+    for i in range(0, len(data), chunk):
+        dec.feed(data[i:i + chunk])
+    return dec, frames
+
+
+def test_crc16_check_value() -> None:
+    assert crc16(b'123456789') == 0x29B1
+
+
+def test_golden_frames_decode() -> None:
+    dec, frames = collect(b''.join(GOLDEN))
+    assert (dec.frames, dec.bad_frames, dec.lost_frames) == (3, 0, 0)
+    assert [f.encoding for f in frames] == [ENC_RAW16, ENC_DELTA8, ENC_PACKED12]
+    for k, f in enumerate(frames):
+        assert f.channel == 6
+        assert f.seq == 41 + k
+        assert f.timestamp_us == 250000 + 250 * k
+        assert f.samples == SAMPLES
+
+
+def test_stray_text_corruption_and_gaps() -> None:
+    corrupted = bytearray(GOLDEN[1])
+    corrupted[12] ^= 0x04
+    data = GOLDEN[0][5:] + GOLDEN[0] + b'I (12) ADC_BASIC: hello\n' + bytes(corrupted) + GOLDEN[2]
+    dec, frames = collect(data, chunk=3)
+    assert dec.frames == 2
+    assert dec.bad_frames == 3          # cut frame, text line, CRC error
+    assert dec.lost_frames == 1         # seq 42
+    assert [f.seq for f in frames] == [41, 43]
+
+
+def test_sequence_restart_is_a_resync_not_a_loss() -> None:
+    # seq 43, then 41 (device reset), then 42: counting on from 41 again
+    dec, frames = collect(GOLDEN[2] + GOLDEN[0] + GOLDEN[1])
+    assert (dec.frames, dec.lost_frames, dec.resyncs) == (3, 0, 1)
+    assert [f.seq for f in frames] == [43, 41, 42]
+
+
+def test_feature_frame_follows_sample_frames() -> None:
+    dec, frames = collect(b''.join(GOLDEN) + GOLDEN_FEATURES, chunk=5)
+    assert (dec.frames, dec.feature_frames, dec.bad_frames, dec.lost_frames) == (4, 1, 0, 0)
+    assert dec.samples == 3 * len(SAMPLES)
+    f = frames[-1]
+    assert (f.type, f.encoding, f.channel, f.seq, f.timestamp_us) == (FRAME_FEATURES, ENC_FLOAT32, 1, 44, 250750)
+    assert f.values == FEATURES
+    assert f.samples == []